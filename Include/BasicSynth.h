@@ -17,6 +17,7 @@
 
 #include <BiQuad.h>
 #include <AllPass.h>
+#include <Convolve.h>
 #include <Filter.h>
 #include <DynFilter.h>
 
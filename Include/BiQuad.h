@@ -42,7 +42,7 @@ public:
 
 	BiQuadFilter()
 	{
-		rad = PI / synthParams.sampleRate;
+		rad = PI / ctx->sampleRate;
 		cutoff = 1;
 		fq = 1.0;
 		gain = 0;
@@ -57,6 +57,13 @@ public:
 		dlyOut2 = 0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		rad = PI / ctx->sampleRate;
+	}
+
 	/// Initialize with a copy. 
 	/// Settings, coefficients are copied from the filt object.
 	/// @param filt filter to copy from
@@ -162,6 +169,42 @@ public:
 		//dlyOut1 = tmp;
 		return out * gain;
 	}
+
+	/// Process a block of samples.
+	/// The coefficients and history are kept in locals for the
+	/// duration of the block.
+	/// @param block input and output buffers
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue a0 = ampIn0;
+		AmpValue a1 = ampIn1;
+		AmpValue a2 = ampIn2;
+		AmpValue b1 = ampOut1;
+		AmpValue b2 = ampOut2;
+		AmpValue x1 = dlyIn1;
+		AmpValue x2 = dlyIn2;
+		AmpValue y1 = dlyOut1;
+		AmpValue y2 = dlyOut2;
+		AmpValue g = gain;
+		int n = block->size;
+		while (--n >= 0)
+		{
+			AmpValue vin = *in++;
+			AmpValue val = (a0 * vin) + (a1 * x1) + (a2 * x2)
+			             - (b1 * y1) - (b2 * y2);
+			y2 = y1;
+			y1 = val;
+			x2 = x1;
+			x1 = vin;
+			*out++ = val * g;
+		}
+		dlyIn1 = x1;
+		dlyIn2 = x2;
+		dlyOut1 = y1;
+		dlyOut2 = y2;
+	}
 };
 
 /// BiQuadFilter optimized for Bandpass.
@@ -182,6 +225,36 @@ public:
 		dlyIn1 = vin;
 		return out * gain;
 	}
+
+	/// @copydoc BiQuadFilter::Samples
+	void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue a0 = ampIn0;
+		AmpValue b1 = ampOut1;
+		AmpValue b2 = ampOut2;
+		AmpValue x1 = dlyIn1;
+		AmpValue x2 = dlyIn2;
+		AmpValue y1 = dlyOut1;
+		AmpValue y2 = dlyOut2;
+		AmpValue g = gain;
+		int n = block->size;
+		while (--n >= 0)
+		{
+			AmpValue vin = *in++;
+			AmpValue val = (a0 * (vin - x2)) - (b1 * y1) - (b2 * y2);
+			y2 = y1;
+			y1 = val;
+			x2 = x1;
+			x1 = vin;
+			*out++ = val * g;
+		}
+		dlyIn1 = x1;
+		dlyIn2 = x2;
+		dlyOut1 = y1;
+		dlyOut2 = y2;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -246,10 +319,10 @@ public:
 	{
 		if (fq < 0.5)
 			fq = 0.5;
-		//double c = 1.0 / tan((PI * cutoff) / (fq * synthParams.sampleRate));
+		//double c = 1.0 / tan((PI * cutoff) / (fq * ctx->sampleRate));
 		double c = 1.0 / tan(rad * cutoff / fq);
-		//double d = 2.0 * cos(2.0 * PI * cutoff / synthParams.sampleRate);
-		double d = 2.0 * cos(synthParams.frqRad * cutoff);
+		//double d = 2.0 * cos(2.0 * PI * cutoff / ctx->sampleRate);
+		double d = 2.0 * cos(ctx->frqRad * cutoff);
 		double oned = 1.0 / (1.0 + c);
 
 		ampIn0 = oned;
@@ -275,12 +348,12 @@ public:
 	{
 		if (fq < 0.5)
 			fq = 0.5;
-		double w0 = synthParams.frqRad * cutoff;
+		double w0 = ctx->frqRad * cutoff;
 		double cw0 = cos(w0);
 		double alpha = sin(w0) / (2.0*fq);
-//		double w0 = synthParams.frqTI * cutoff;
-//		double cw0 = wtSet.CosWT(w0);
-//		double alpha = wtSet.SinWT(w0) / (2.0*fq);
+//		double w0 = ctx->frqTI * cutoff;
+//		double cw0 = ctx->wt->CosWT(w0);
+//		double alpha = ctx->wt->SinWT(w0) / (2.0*fq);
 
 		double b0 = (1.0 - cw0) / 2.0;
 		double b1 = 1.0 - cw0;
@@ -304,7 +377,7 @@ public:
 	{
 		if (fq < 0.5)
 			fq = 0.5;
-		double w0 = synthParams.frqRad * cutoff;
+		double w0 = ctx->frqRad * cutoff;
 		double cw0 = cos(w0);
 		double alpha = sin(w0) / (2.0*fq);
 
@@ -330,7 +403,7 @@ public:
 	{
 		if (fq < 0.5)
 			fq = 0.5;
-		double w0 = synthParams.frqRad * cutoff;
+		double w0 = ctx->frqRad * cutoff;
 		double cw0 = cos(w0);
 		double alpha = sin(w0) / (2.0*fq);
 
@@ -376,7 +449,7 @@ public:
 
 	virtual void CalcCoef()
 	{
-		ampOut1 = -(res + res) * cos(synthParams.frqRad * cutoff);
+		ampOut1 = -(res + res) * cos(ctx->frqRad * cutoff);
 		ampOut2 = res * res;
 		ampIn0 = (1.0 - ampOut2) * 0.5;
 		// alternate scaling:
@@ -388,9 +461,9 @@ public:
 	virtual void Init(FrqValue cu, FrqValue q, AmpValue g)
 	{
 		if (q > 0.0)
-			res = exp(-PI / (q * synthParams.sampleRate));
+			res = exp(-PI / (q * ctx->sampleRate));
 		else
-			res = exp(-PI / synthParams.sampleRate);
+			res = exp(-PI / ctx->sampleRate);
 		if (res > 0.99999)
 			res = 0.99999;
 		BiQuadFilterBP::Init(cu, g);
@@ -0,0 +1,388 @@
+/////////////////////////////////////////////////////////////
+// BasicSynth Library
+//
+/// @file Convolve.h FFT and partitioned convolution
+//
+// FFTRealT - radix-2 FFT of real-valued data, used for
+//            convolution and to build wavetables
+// ConvolveFFT - uniformly partitioned FFT convolution, used
+//            by FilterFIRn and ReverbIR for long impulse responses
+//
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////
+/// @addtogroup grpFilter
+//@{
+#ifndef _CONVOLVE_H_
+#define _CONVOLVE_H_
+
+/// Real FFT.
+/// The transform of N real values is calculated with a complex
+/// radix-2 FFT of N/2 points followed by a split into the N/2+1
+/// unique frequency bins. The spectrum is stored in place
+/// in packed form:
+/// @code
+/// buf[0] = bin 0 (DC), buf[1] = bin N/2 (Nyquist)
+/// buf[2k], buf[2k+1] = real, imaginary parts of bin k, 0 < k < N/2
+/// @endcode
+/// Both DC and Nyquist bins are purely real for real-valued input.
+/// The template argument is the sample type; FFTReal uses AmpValue
+/// for filtering, wavetables are calculated with FFTRealT<double>.
+template <class T> class FFTRealT
+{
+private:
+	int size;  // N, number of real values
+	int half;  // N/2, number of complex points
+	int *rev;  // bit-reversal table for N/2 points
+	T *twc;    // cos(2*PI*k/(N/2)), k < N/4
+	T *tws;    // sin(2*PI*k/(N/2)), k < N/4
+	T *spc;    // cos(2*PI*k/N), k <= N/4
+	T *sps;    // sin(2*PI*k/N), k <= N/4
+
+	// In-place radix-2 FFT of half complex points stored re,im.
+	// inv = 0 for forward (e^-i), 1 for inverse (e^+i). No scaling.
+	void Complex(T *buf, int inv)
+	{
+		int i, j;
+		T tr, ti;
+		for (i = 0; i < half; i++)
+		{
+			j = rev[i];
+			if (j > i)
+			{
+				tr = buf[2*i];
+				ti = buf[2*i+1];
+				buf[2*i] = buf[2*j];
+				buf[2*i+1] = buf[2*j+1];
+				buf[2*j] = tr;
+				buf[2*j+1] = ti;
+			}
+		}
+
+		T sgn = inv ? 1 : -1;
+		for (int len = 2; len <= half; len <<= 1)
+		{
+			int hl = len >> 1;
+			int step = half / len;
+			for (j = 0; j < hl; j++)
+			{
+				T wr = twc[j*step];
+				T wi = sgn * tws[j*step];
+				for (i = j; i < half; i += len)
+				{
+					T *ap = &buf[2*i];
+					T *bp = &buf[2*(i+hl)];
+					tr = bp[0] * wr - bp[1] * wi;
+					ti = bp[0] * wi + bp[1] * wr;
+					bp[0] = ap[0] - tr;
+					bp[1] = ap[1] - ti;
+					ap[0] += tr;
+					ap[1] += ti;
+				}
+			}
+		}
+	}
+
+public:
+	FFTRealT()
+	{
+		size = 0;
+		half = 0;
+		rev = 0;
+		twc = 0;
+		tws = 0;
+		spc = 0;
+		sps = 0;
+	}
+
+	~FFTRealT()
+	{
+		Clear();
+	}
+
+	/// Release the tables.
+	void Clear()
+	{
+		delete[] rev;
+		delete[] twc;
+		delete[] tws;
+		delete[] spc;
+		delete[] sps;
+		rev = 0;
+		twc = 0;
+		tws = 0;
+		spc = 0;
+		sps = 0;
+		size = 0;
+		half = 0;
+	}
+
+	/// Initialize the FFT tables.
+	/// @param n number of real values, power of two, 4 or more
+	/// @return 0 on success, -1 if n is not valid
+	int Init(int n)
+	{
+		Clear();
+		if (n < 4 || (n & (n - 1)) != 0)
+			return -1;
+
+		size = n;
+		half = n / 2;
+
+		int bits = 0;
+		while ((1 << bits) < half)
+			bits++;
+		rev = new int[half];
+		int k;
+		for (k = 0; k < half; k++)
+		{
+			int r = 0;
+			for (int b = 0; b < bits; b++)
+			{
+				if (k & (1 << b))
+					r |= 1 << (bits - 1 - b);
+			}
+			rev[k] = r;
+		}
+
+		int quarter = half / 2;
+		twc = new T[quarter];
+		tws = new T[quarter];
+		for (k = 0; k < quarter; k++)
+		{
+			double ph = (twoPI * (double) k) / (double) half;
+			twc[k] = T(cos(ph));
+			tws[k] = T(sin(ph));
+		}
+
+		spc = new T[quarter+1];
+		sps = new T[quarter+1];
+		for (k = 0; k <= quarter; k++)
+		{
+			double ph = (twoPI * (double) k) / (double) size;
+			spc[k] = T(cos(ph));
+			sps[k] = T(sin(ph));
+		}
+		return 0;
+	}
+
+	/// Get the transform length.
+	int GetSize()
+	{
+		return size;
+	}
+
+	/// Forward transform.
+	/// The N real values in buf are replaced by the packed spectrum.
+	/// The N real values are transformed as N/2 complex values
+	/// z[n] = x[2n] + i*x[2n+1]. The even (E) and odd (O) sample
+	/// spectra are separated from Z and combined with the N-point
+	/// twiddle factors W^k = e^(-2*PI*i*k/N):
+	/// X[k] = E[k] + W^k O[k], X[N/2-k] = conj(E[k] - W^k O[k])
+	/// @param buf values to transform
+	void Forward(T *buf)
+	{
+		Complex(buf, 0);
+
+		T z0r = buf[0];
+		T z0i = buf[1];
+		buf[0] = z0r + z0i;
+		buf[1] = z0r - z0i;
+
+		int quarter = half / 2;
+		for (int k = 1; k <= quarter; k++)
+		{
+			T *zk = &buf[2*k];
+			T *zj = &buf[2*(half-k)];
+			T er = (zk[0] + zj[0]) * T(0.5);
+			T ei = (zk[1] - zj[1]) * T(0.5);
+			T or_ = (zk[1] + zj[1]) * T(0.5);
+			T oi = (zj[0] - zk[0]) * T(0.5);
+			T c = spc[k];
+			T s = sps[k];
+			T tr = c * or_ + s * oi;
+			T ti = c * oi - s * or_;
+			zk[0] = er + tr;
+			zk[1] = ei + ti;
+			zj[0] = er - tr;
+			zj[1] = ti - ei;
+		}
+	}
+
+	/// Inverse transform.
+	/// The packed spectrum in buf is replaced by N real values.
+	/// The output is scaled so that Inverse(Forward(x)) == x.
+	/// @param buf spectrum to transform
+	void Inverse(T *buf)
+	{
+		// rebuild Z[k] = E[k] + i*O[k] from the spectrum
+		T x0 = buf[0];
+		T xm = buf[1];
+		buf[0] = (x0 + xm) * T(0.5);
+		buf[1] = (x0 - xm) * T(0.5);
+
+		int quarter = half / 2;
+		for (int k = 1; k <= quarter; k++)
+		{
+			T *xk = &buf[2*k];
+			T *xj = &buf[2*(half-k)];
+			T er = (xk[0] + xj[0]) * T(0.5);
+			T ei = (xk[1] - xj[1]) * T(0.5);
+			T tr = (xk[0] - xj[0]) * T(0.5);
+			T ti = (xk[1] + xj[1]) * T(0.5);
+			T c = spc[k];
+			T s = sps[k];
+			T or_ = c * tr - s * ti;
+			T oi = c * ti + s * tr;
+			xk[0] = er - oi;
+			xk[1] = ei + or_;
+			xj[0] = er + oi;
+			xj[1] = or_ - ei;
+		}
+
+		Complex(buf, 1);
+
+		T scl = T(1.0) / (T) half;
+		for (int n = 0; n < size; n++)
+			buf[n] *= scl;
+	}
+
+	/// Multiply two packed spectra and add to an accumulator.
+	/// @param acc accumulated spectrum
+	/// @param a first spectrum
+	/// @param b second spectrum
+	void MulAdd(T *acc, const T *a, const T *b)
+	{
+		acc[0] += a[0] * b[0];
+		acc[1] += a[1] * b[1];
+		for (int k = 2; k < size; k += 2)
+		{
+			T re = a[k] * b[k] - a[k+1] * b[k+1];
+			T im = a[k] * b[k+1] + a[k+1] * b[k];
+			acc[k] += re;
+			acc[k+1] += im;
+		}
+	}
+};
+
+/// Real FFT of AmpValue samples.
+typedef FFTRealT<AmpValue> FFTReal;
+
+/// Partitioned convolution.
+/// ConvolveFFT convolves the input with an impulse response of
+/// any length. The impulse response is split into partitions of B samples.
+/// The first partition is applied directly to the input sample by sample
+/// so that there is no latency. The remaining partitions are applied
+/// once every B samples in the frequency domain using the overlap-save method:
+/// the spectrum of each input block is kept in a delay line and
+/// multiplied with the spectrum of each partition. The output of
+/// the later partitions is always needed at least B samples after the
+/// input block is complete, so the result is identical to direct convolution
+/// (within rounding) and the cost per sample grows with L/B rather than L.
+///
+/// The block length is chosen from the impulse length when not given.
+class ConvolveFFT
+{
+private:
+	FFTReal fft;
+	int impLen;       // length of impulse response
+	int blkLen;       // partition length (B)
+	int fftLen;       // transform length (2B)
+	int headLen;      // length of the direct partition
+	int tailCnt;      // number of FFT partitions
+	int inPos;        // position in the current input block
+	int fdlPos;       // most recent input spectrum
+	AmpValue *head;   // first partition, time domain
+	AmpValue *inBuf;  // previous and current input blocks (2B)
+	AmpValue *outBuf; // FFT partition output for the current block (B)
+	AmpValue *spcH;   // partition spectra, tailCnt * fftLen
+	AmpValue *spcX;   // input spectrum delay line, tailCnt * fftLen
+	AmpValue *work;   // accumulated spectrum (2B)
+
+	void Block();
+
+public:
+	ConvolveFFT()
+	{
+		impLen = 0;
+		blkLen = 0;
+		fftLen = 0;
+		headLen = 0;
+		tailCnt = 0;
+		inPos = 0;
+		fdlPos = 0;
+		head = 0;
+		inBuf = 0;
+		outBuf = 0;
+		spcH = 0;
+		spcX = 0;
+		work = 0;
+	}
+
+	~ConvolveFFT()
+	{
+		Clear();
+	}
+
+	/// Release all buffers.
+	void Clear();
+
+	/// Allocate buffers for an impulse response.
+	/// The impulse response is set to zero and must be set with SetImpulse().
+	/// @param len length of the impulse response
+	/// @param blk partition length, power of two, 0 to choose automatically
+	/// @return 0 on success, -1 on error
+	int InitConvolve(int len, int blk = 0);
+
+	/// Set the impulse response.
+	/// The spectrum of each partition is recalculated. The input history
+	/// is kept so that the response can be changed while running.
+	/// @param imp impulse response, of the length given to InitConvolve()
+	void SetImpulse(const AmpValue *imp);
+
+	/// Clear the input history and pending output.
+	void Reset();
+
+	/// Get the length of the impulse response
+	int GetLength()
+	{
+		return impLen;
+	}
+
+	/// Get the partition length
+	int GetBlockLength()
+	{
+		return blkLen;
+	}
+
+	/// Process one sample.
+	/// @param inval current input sample
+	/// @return convolved output sample
+	AmpValue Sample(AmpValue inval)
+	{
+		AmpValue *xp = &inBuf[blkLen + inPos];
+		*xp = inval;
+		// four partial sums avoid waiting on each add
+		const AmpValue *hp = head;
+		AmpValue s0 = outBuf[inPos];
+		AmpValue s1 = 0;
+		AmpValue s2 = 0;
+		AmpValue s3 = 0;
+		int m = 0;
+		for ( ; m + 3 < headLen; m += 4)
+		{
+			s0 += hp[m] * xp[-m];
+			s1 += hp[m+1] * xp[-m-1];
+			s2 += hp[m+2] * xp[-m-2];
+			s3 += hp[m+3] * xp[-m-3];
+		}
+		for ( ; m < headLen; m++)
+			s0 += hp[m] * xp[-m];
+		if (++inPos >= blkLen)
+			Block();
+		return (s0 + s1) + (s2 + s3);
+	}
+};
+//@}
+#endif
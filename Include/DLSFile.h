@@ -344,6 +344,7 @@ protected:
 	FileReadBuf file;
 	DLSFileInfo info;
 	int preload;
+	int mapped;
 
 	float DLSScale(bsInt32 scl);
 	float MapScale(short destination, bsInt32 scale);
@@ -365,9 +366,13 @@ public:
 	/// Load the file and return as a SoundBank object.
 	/// The caller is responsible for deleteing the returned object.
 	/// @param fname path to the file
+	/// When map is true, sample data is used in place from a
+	/// read-only mapping of the file where possible.
+	/// @param fname path to the file
 	/// @param pre preload all samples
+	/// @param map map the sample data
 	/// @returns pointer to SoundBank object.
-	SoundBank *LoadSoundBank(const char *fname, int pre = 1);
+	SoundBank *LoadSoundBank(const char *fname, int pre = 1, int map = 0);
 
 	/// Get the info records.
 	/// @returns pointer to file info.
@@ -112,7 +112,7 @@ public:
 		ReleaseBuffers();
 		delayTime = dlyTm;
 		decayFactor = decay;
-		delayLen = (int) (delayTime * synthParams.sampleRate);
+		delayLen = (int) (delayTime * ctx->sampleRate);
 		if (delayLen <= 0)
 			delayLen = 1;
 		delayBuf = new AmpValue[delayLen];
@@ -124,7 +124,7 @@ public:
 	/// @param d time offset in seconds
 	AmpValue TapT(PhsAccum d)
 	{
-		return Tap(d * synthParams.sampleRate);
+		return Tap(d * ctx->sampleRate);
 	}
 
 	/// Read the value at sample offset s
@@ -224,6 +224,36 @@ public:
 		SetIn(inval + out);
 		return out;
 	}
+
+	/// Process a block of samples.
+	/// The block is split at the end of the delay buffer so that
+	/// the inner loop has no wrap test and can be vectorized.
+	/// @param block input and output buffers
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue dec = decayFactor;
+		int n = block->size;
+		while (n > 0)
+		{
+			int run = (int) (delayEnd - delayPos);
+			if (run > n)
+				run = n;
+			AmpValue *dp = delayPos;
+			for (int k = 0; k < run; k++)
+			{
+				AmpValue val = dp[k] * dec;
+				dp[k] = in[k] + val;
+				out[k] = val;
+			}
+			in += run;
+			out += run;
+			n -= run;
+			if ((delayPos += run) >= delayEnd)
+				delayPos = delayBuf;
+		}
+	}
 };
 
 /// Variable delay tap delay line.
@@ -251,7 +281,7 @@ public:
 	/// @param d delay time
 	void SetDelayT(PhsAccum d)
 	{
-		SetDelay(d * synthParams.sampleRate);
+		SetDelay(d * ctx->sampleRate);
 	}
 
 	/// Set variable delay in samples
@@ -315,6 +345,34 @@ public:
 		SetIn(vn);
 		return vm + (vn * decayFactor);
 	}
+
+	/// @copydoc DelayLineR::Samples
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue dec = decayFactor;
+		int n = block->size;
+		while (n > 0)
+		{
+			int run = (int) (delayEnd - delayPos);
+			if (run > n)
+				run = n;
+			AmpValue *dp = delayPos;
+			for (int k = 0; k < run; k++)
+			{
+				AmpValue vm = dp[k];
+				AmpValue vn = in[k] - (vm * dec);
+				dp[k] = vn;
+				out[k] = vm + (vn * dec);
+			}
+			in += run;
+			out += run;
+			n -= run;
+			if ((delayPos += run) >= delayEnd)
+				delayPos = delayBuf;
+		}
+	}
 };
 
 /// All-pass delay line (2).
@@ -332,6 +390,14 @@ public:
 		apg = 0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		dlx.SetContext(c);
+		dly.SetContext(c);
+	}
+
 	// dlyTm, decay
 	void Init(int n, float *v)
 	{
@@ -441,7 +507,7 @@ public:
 	/// Set the time offset for tap number n
 	void SetTap(int n, AmpValue dlyTm, AmpValue decay = 1)
 	{
-		long position = (int) (dlyTm * synthParams.sampleRate);
+		long position = (int) (dlyTm * ctx->sampleRate);
 		if (position < delayLen)
 		{
 			delayTaps[n] = delayBuf + (delayLen - position);
@@ -41,16 +41,26 @@ private:
 public:
 	DynFilterLP()
 	{
-		sinTable = wtSet.GetWavetable(WT_SIN);
+		sinTable = ctx->wt->GetWavetable(WT_SIN);
 		// this is for PI / sampleRate conversion...
-		frqTI = (synthParams.ftableLength / 2) / synthParams.sampleRate;
-		cosOffs = synthParams.itableLength / 4;
+		frqTI = (ctx->ftableLength / 2) / ctx->sampleRate;
+		cosOffs = ctx->itableLength / 4;
 		lastNdx = 0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	void SetContext(SynthContext *c)
+	{
+		BiQuadFilter::SetContext(c);
+		env.SetContext(c);
+		sinTable = ctx->wt->GetWavetable(WT_SIN);
+		frqTI = (ctx->ftableLength / 2) / ctx->sampleRate;
+		cosOffs = ctx->itableLength / 4;
+	}
+
 	void CalcCoef()
 	{
-		// c = 1 / tan((PI / synthParams.sampleRate) * cutoff);
+		// c = 1 / tan((PI / ctx->sampleRate) * cutoff);
 		double c = (double) sinTable[lastNdx+cosOffs] / (double) sinTable[lastNdx];
 		double c2 = c * c;
 		double csqr2 = sqr2 * c;
@@ -149,6 +159,12 @@ public:
 	{
 		env.Release();
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 //@}
 #endif
@@ -85,13 +85,13 @@ public:
 		attack = atk;
 		decay = dec;
 
-		totalSamples = (bsUint32) ((synthParams.sampleRate * duration) + 0.5);
+		totalSamples = (bsUint32) ((ctx->sampleRate * duration) + 0.5);
 		if (totalSamples < 3)
 			totalSamples = 3;
-		attackTime = (bsUint32) (attack * synthParams.sampleRate);
+		attackTime = (bsUint32) (attack * ctx->sampleRate);
 		if (attackTime < 1)
 			attackTime = 1;
-		decayTime  = (bsUint32) (decay * synthParams.sampleRate);
+		decayTime  = (bsUint32) (decay * ctx->sampleRate);
 		if (decayTime < 1)
 			decayTime = 1;
 		while ((attackTime + decayTime) >= totalSamples)
@@ -117,7 +117,7 @@ public:
 	{
 		if (initPhs >= 0)
 		{
-			index = (bsUint32) (initPhs * duration * synthParams.sampleRate);
+			index = (bsUint32) (initPhs * duration * ctx->sampleRate);
 			if (index < attackTime)
 			{
 				envInc = peakAmp / (AmpValue) attackTime;
@@ -20,6 +20,15 @@
 #ifndef _ENVGENSEG_H_
 #define _ENVGENSEG_H_
 
+/// Number of segments EnvGenSeg stores without allocating.
+#ifndef EGSEG_LOCAL
+#define EGSEG_LOCAL 6
+#endif
+
+/// Returned by ConstantFor() when the envelope value does
+/// not change until Release() or Reset() is called.
+#define EGSEG_CONSTANT 0x7fffffff
+
 /// Curve types for the multi-segment envelope generators.
 enum EGSegType
 {
@@ -80,7 +89,7 @@ public:
 	inline void SetRate(FrqValue r)
 	{ 
 		rate = r; 
-		count = (long) (rate * synthParams.sampleRate);
+		count = (long) (rate * ctx->sampleRate);
 	}
 
 	/// Initialize the segment. Sets the segment with explicit arguments
@@ -94,7 +103,7 @@ public:
 		rate = r;
 		start = s;
 		end = e;
-		count = (long) (rate * synthParams.sampleRate);
+		count = (long) (rate * ctx->sampleRate);
 		Reset();
 	}
 
@@ -132,7 +141,7 @@ public:
 	/// @sa InitSeg
 	virtual void InitSegTick(long r, AmpValue s, AmpValue e)
 	{
-		rate = (FrqValue)r * synthParams.sampleRate;
+		rate = (FrqValue)r * ctx->sampleRate;
 		count = r;
 		start = s;
 		end = e;
@@ -171,6 +180,29 @@ public:
 		return value;
 	}
 
+	/// Get the number of values remaining in the segment.
+	/// The segment is finished after this many calls to Gen().
+	/// @return remaining samples, zero or less when finished
+	inline long GetCount()
+	{
+		return count;
+	}
+
+	/// Generate a block of values.
+	/// The values are identical to calling Gen() for each sample.
+	/// Each curve type implements the loop directly so that there
+	/// is no virtual call per sample. Once the segment is finished
+	/// the remaining values are the final level.
+	/// @param out output buffer
+	/// @param frames number of values
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		AmpValue v = value;
+		for (int n = 0; n < frames; n++)
+			out[n] = v;
+		count -= frames;
+	}
+
 	/// Test if the envelope segment is finished. When the segment reaches the
 	/// end, this return true. This is used by multi-segment generators to
 	/// determine when to move to the next segment. It is also used 
@@ -223,6 +255,23 @@ public:
 		return end;
 	}
 
+	/// @copydoc EnvSeg::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		int n = 0;
+		int ramp = count > frames ? frames : (int) count - 1;
+		if (ramp < 0)
+			ramp = 0;
+		AmpValue v = value;
+		AmpValue dv = incr;
+		for ( ; n < ramp; n++)
+			out[n] = v += dv;
+		value = v;
+		for ( ; n < frames; n++)
+			out[n] = end;
+		count -= frames;
+	}
+
 };
 
 ///////////////////////////////////////////////////////////
@@ -296,6 +345,25 @@ public:
 		}
 		return end;
 	}
+
+	/// @copydoc EnvSeg::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		int n = 0;
+		int ramp = count > frames ? frames : (int) count - 1;
+		if (ramp < 0)
+			ramp = 0;
+		AmpValue v = value;
+		for ( ; n < ramp; n++)
+		{
+			v *= incr;
+			out[n] = ((v - bias) * range) + offs;
+		}
+		value = v;
+		for ( ; n < frames; n++)
+			out[n] = end;
+		count -= frames;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -316,7 +384,7 @@ public:
 	/// @copydoc EnvSeg::Reset
 	virtual void Reset(float initPhs = 0)
 	{
-		count = (long) (rate * synthParams.sampleRate);
+		count = (long) (rate * ctx->sampleRate);
 		value = 0;
 		range = fabs(end - start);
 		if (count > 0)
@@ -350,6 +418,25 @@ public:
 		}
 		return end;
 	}
+
+	/// @copydoc EnvSeg::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		int n = 0;
+		int ramp = count > frames ? frames : (int) count - 1;
+		if (ramp < 0)
+			ramp = 0;
+		AmpValue v = value;
+		for ( ; n < ramp; n++)
+		{
+			v *= incr;
+			out[n] = ((1.0 - (v - bias)) * range) + offs;
+		}
+		value = v;
+		for ( ; n < frames; n++)
+			out[n] = end;
+		count -= frames;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -400,6 +487,25 @@ public:
 		}
 		return end;
 	}
+
+	/// @copydoc EnvSeg::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		int n = 0;
+		int ramp = count > frames ? frames : (int) count - 1;
+		if (ramp < 0)
+			ramp = 0;
+		AmpValue v = value;
+		for ( ; n < ramp; n++)
+		{
+			v += incr;
+			out[n] = start + (range * (v * v));
+		}
+		value = v;
+		for ( ; n < frames; n++)
+			out[n] = end;
+		count -= frames;
+	}
 };
 
 /// Structure to hold values for an envelope segment.
@@ -628,6 +734,52 @@ public:
 		return Gen() * in;
 	}
 
+	/// Generate a block of values.
+	/// The values are identical to calling Gen() for each sample.
+	/// The default calls Gen(). Derived classes that override
+	/// Gen() should also override this method.
+	/// @param out output buffer
+	/// @param frames number of values
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		for (int n = 0; n < frames; n++)
+			out[n] = Gen();
+	}
+
+	/// Generate a block of values multiplied by the input.
+	/// @param block input and output buffers
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue eg[MAX_BLKLEN];
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		int n = block->size;
+		while (n > 0)
+		{
+			int span = n > MAX_BLKLEN ? MAX_BLKLEN : n;
+			GenBlock(eg, span);
+			for (int k = 0; k < span; k++)
+				out[k] = eg[k] * in[k];
+			in += span;
+			out += span;
+			n -= span;
+		}
+	}
+
+	/// Get the number of samples for which the value is constant.
+	/// The next N values returned by Gen() are all equal to \p val.
+	/// The generator must still be run for those samples unless the
+	/// result is EGSEG_CONSTANT, which is returned at the sustain level
+	/// and once the envelope is finished. Callers can then use the
+	/// value in place of a block of envelope values.
+	/// The default returns 0 (unknown).
+	/// @param val returns the constant value
+	/// @return number of samples with the same value
+	virtual bsInt32 ConstantFor(AmpValue& val)
+	{
+		return 0;
+	}
+
 	/// Move to the release segment.
 	virtual void Release() { }
 
@@ -653,7 +805,9 @@ public:
 /// type, thus allowing a mixture of linear, exponential,
 /// log curves. The segObj array is initialized to 
 /// the appropriate curve generator when the SetType
-/// method is called.
+/// method is called. Up to EGSEG_LOCAL segments are kept
+/// inside the object so that copying a voice from a template
+/// does not touch the heap. Longer envelopes allocate.
 ///
 /// This class does not implement indeterminate sustain. 
 /// However, it is possible to create a fixed duration 
@@ -673,6 +827,8 @@ protected:
 	int susOn;
 	SegVals *segRLT;
 	EnvSeg **segObj;
+	SegVals segLocal[EGSEG_LOCAL];
+	EnvSeg *objLocal[EGSEG_LOCAL];
 
 	EnvSegLin egsLin;
 	EnvSegExp egsExp;
@@ -699,10 +855,23 @@ public:
 		duration = 0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		egsLin.SetContext(c);
+		egsExp.SetContext(c);
+		egsLog.SetContext(c);
+		egsSqr.SetContext(c);
+		egsSus.SetContext(c);
+	}
+
 	virtual ~EnvGenSeg()
 	{
-		delete segRLT;
-		delete segObj;
+		if (segRLT != segLocal)
+			delete[] segRLT;
+		if (segObj != objLocal)
+			delete[] segObj;
 	}
 
 	/// @copydoc EnvGenUnit::Copy()
@@ -768,8 +937,10 @@ public:
 		return numSeg; 
 	}
 
-	/// Set the number of segments. This method allocates
-	/// an array of SegVals and initializes them to zero.
+	/// Set the number of segments. This method sets up
+	/// an array of SegVals and initializes new segments to zero.
+	/// Existing segment values are kept. The array is
+	/// allocated only when count is more than EGSEG_LOCAL.
 	/// @param count number of segments
 	virtual void SetSegs(int count)
 	{
@@ -778,12 +949,24 @@ public:
 		if (count == numSeg)
 			return;
 
-		SegVals *segRLTn = new SegVals[count];
-		EnvSeg **segObjn = new EnvSeg *[count];
+		SegVals *segRLTn;
+		EnvSeg **segObjn;
+		if (count <= EGSEG_LOCAL)
+		{
+			segRLTn = segLocal;
+			segObjn = objLocal;
+		}
+		else
+		{
+			segRLTn = new SegVals[count];
+			segObjn = new EnvSeg *[count];
+		}
 		for (int n = 0; n < count; n++)
 		{
 			if (n < numSeg)
 			{
+				if (segRLTn == segRLT)
+					continue;
 				segRLTn[n].level = segRLT[n].level;
 				segRLTn[n].rate = segRLT[n].rate;
 				segRLTn[n].type = segRLT[n].type;
@@ -802,10 +985,10 @@ public:
 			}
 		}
 		numSeg = count;
-		if (segRLT)
+		if (segRLT && segRLT != segRLTn && segRLT != segLocal)
 			delete[] segRLT;
 		segRLT = segRLTn;
-		if (segObj)
+		if (segObj && segObj != segObjn && segObj != objLocal)
 			delete[] segObj;
 		segObj = segObjn;
 	}
@@ -1078,6 +1261,79 @@ public:
 	{
 		return (index >= numSeg && seg->IsFinished());
 	}
+
+	/// @copydoc EnvGenUnit::GenBlock()
+	/// Each segment is generated as one run by the segment's
+	/// own loop, so there is one virtual call per segment
+	/// rather than one per sample.
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		while (frames > 0)
+		{
+			int span;
+			if (index >= numSeg && seg->IsFinished())
+				span = frames;
+			else
+				span = SegSpan(frames);
+			seg->GenBlock(out, span);
+			lastVal = out[span-1];
+			out += span;
+			frames -= span;
+			if (seg->IsFinished() && index < numSeg)
+				NextSeg();
+		}
+	}
+
+	/// @copydoc EnvGenUnit::ConstantFor()
+	virtual bsInt32 ConstantFor(AmpValue& val)
+	{
+		if (index >= numSeg && seg->IsFinished())
+			return SegFinal(val);
+		return SegConstant(val);
+	}
+
+protected:
+	/// Get the number of samples to generate from the current segment.
+	/// This is the rest of the segment, but at least one sample.
+	/// @param frames maximum number of samples
+	inline int SegSpan(int frames)
+	{
+		long cnt = seg->GetCount();
+		if (cnt < 1)
+			return 1;
+		if (cnt < frames)
+			return (int) cnt;
+		return frames;
+	}
+
+	/// Get the value of a finished segment.
+	/// @param val returns the value
+	/// @return EGSEG_CONSTANT, or 0 if Gen() has not returned the value yet
+	inline bsInt32 SegFinal(AmpValue& val)
+	{
+		if (seg->GetType() == susSeg)
+			val = seg->Value();
+		else
+			val = seg->GetLevel();
+		return val == lastVal ? EGSEG_CONSTANT : 0;
+	}
+
+	/// Get the constant run of the current segment.
+	/// Only sustain segments have a constant value.
+	/// @param val returns the value
+	/// @return number of samples in the run
+	inline bsInt32 SegConstant(AmpValue& val)
+	{
+		if (seg->GetType() != susSeg)
+			return 0;
+		val = seg->Value();
+		long cnt = seg->GetCount();
+		if (cnt < 1)
+			return 1;
+		if (cnt >= EGSEG_CONSTANT)
+			return EGSEG_CONSTANT - 1;
+		return (bsInt32) cnt;
+	}
 }; 
 
 ///////////////////////////////////////////////////////////
@@ -1162,6 +1418,58 @@ public:
 	{
 		return state == 3;
 	}
+
+	/// @copydoc EnvGenSeg::GenBlock()
+	/// While sustaining or after the release is finished the
+	/// remainder of the block is the last value.
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		while (frames > 0)
+		{
+			int span;
+			if (state == 0 || state == 2)
+			{
+				span = SegSpan(frames);
+				seg->GenBlock(out, span);
+				lastVal = out[span-1];
+				if (seg->IsFinished())
+				{
+					if (state == 2)
+						state = 3;
+					else if (index == relSeg)
+						state = 1;
+					else
+						NextSeg();
+				}
+			}
+			else if (state == 1 && !susOn)
+			{
+				NextSeg();
+				state = 2;
+				*out = lastVal = seg->Gen();
+				span = 1;
+			}
+			else
+			{
+				AmpValue v = lastVal;
+				for (span = 0; span < frames; span++)
+					out[span] = v;
+			}
+			out += span;
+			frames -= span;
+		}
+	}
+
+	/// @copydoc EnvGenUnit::ConstantFor()
+	virtual bsInt32 ConstantFor(AmpValue& val)
+	{
+		val = lastVal;
+		if (state == 3 || (state == 1 && susOn))
+			return EGSEG_CONSTANT;
+		if (state == 1)
+			return 0;
+		return SegConstant(val);
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -1401,6 +1709,14 @@ public:
 		segStart = 0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		atk.SetContext(c);
+		dec.SetContext(c);
+	}
+
 	/// @copydoc EnvGenUnit::Copy
 	virtual void Copy(EnvGenUnit *tp)
 	{
@@ -1616,7 +1932,7 @@ public:
 	virtual void Reset(float initPhs = 0)
 	{
 		if (initPhs >= 0)
-			index = (bsInt32) (initPhs * synthParams.sampleRate);
+			index = (bsInt32) (initPhs * ctx->sampleRate);
 	}
 
 	/// Initialize the envelope.
@@ -1636,7 +1952,7 @@ public:
 		for (segn = 0; segn < segs; segn++)
 			dcount += rt[segn];
 
-		count = (long) ((synthParams.sampleRate * dcount) + 0.5);
+		count = (long) ((ctx->sampleRate * dcount) + 0.5);
 		egTable = new AmpValue[count+1];
 
 		FrqValue ndxf = 0;
@@ -1648,6 +1964,10 @@ public:
 		EnvSegExp egsExp;
 		EnvSegLog egsLog;
 		EnvSeg    egsSus;
+		egsLin.SetContext(ctx);
+		egsExp.SetContext(ctx);
+		egsLog.SetContext(ctx);
+		egsSus.SetContext(ctx);
 
 		for (segn = 0; segn < segs; segn++)
 		{
@@ -1672,7 +1992,7 @@ public:
 				break;
 			}
 			segp->InitSeg(rt[segn], vbeg, vend);
-			FrqValue seglen = synthParams.sampleRate * rt[segn];
+			FrqValue seglen = ctx->sampleRate * rt[segn];
 			FrqValue segend = ndxf + seglen;
 			while (ndxf < segend)
 			{
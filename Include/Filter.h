@@ -21,6 +21,10 @@
 #ifndef _FILTER_H_
 #define _FILTER_H_
 
+#include "Convolve.h"
+
+/// Minimum FilterFIRn length that uses FFT convolution.
+#define FIRN_FFT_MIN 256
 
 ///////////////////////////////////////////////////////////
 /// FIR, one-zero filter. This filter implements the equation:
@@ -131,10 +135,10 @@ public:
 	/// @param hp when true, produce a high-passs
 	void CalcCoef(FrqValue fc, int hp = 0)
 	{
-		if (fc > synthParams.nyquist)
-			fc = synthParams.nyquist;
+		if (fc > ctx->nyquist)
+			fc = ctx->nyquist;
 
-		double x = exp(-twoPI * (fc/synthParams.sampleRate));
+		double x = exp(-twoPI * (fc/ctx->sampleRate));
 		if (hp)
 		{
 			inAmp = x;
@@ -215,10 +219,10 @@ public:
 	/// @param hp when true, produce a high-passs
 	void CalcCoef(FrqValue fc, int hp = 0)
 	{
-		if (fc > synthParams.nyquist)
-			fc = synthParams.nyquist;
+		if (fc > ctx->nyquist)
+			fc = ctx->nyquist;
 
-		double x = exp(-twoPI * (fc/synthParams.sampleRate));
+		double x = exp(-twoPI * (fc/ctx->sampleRate));
 		if (hp)
 		{
 			inAmp0 = AmpValue((1.0 + x) / 2.0);
@@ -297,6 +301,18 @@ public:
 		dlyAmp2 = out2;
 	}
 
+	/// Get the coefficients. This allows a caller to interpolate
+	/// between two sets of coefficients calculated by CalcCoef.
+	/// @param in0 input sample coefficient (a0)
+	/// @param out1 delayed sample coefficient (b1)
+	/// @param out2 delayed sample coefficient (b2)
+	void GetCoef(AmpValue& in0, AmpValue& out1, AmpValue& out2)
+	{
+		in0 = inAmp0;
+		out1 = dlyAmp1;
+		out2 = dlyAmp2;
+	}
+
 	/// Calculate coefficients. The coefficients are calculate to produce the indicated
 	/// cutoff frequency for a band-pass filter with resonance Q
 	/// @param fc cutoff frequency
@@ -310,14 +326,14 @@ public:
 			inAmp0 = 0;
 			return;
 		}
-		if (fc > synthParams.nyquist)
-			fc = synthParams.nyquist;
+		if (fc > ctx->nyquist)
+			fc = ctx->nyquist;
 		if (q < 0.5)
 			q = 0.5;
 
 		// Hal Chamberlin, Musical Applications of Microprocessors
-		double r = exp(-PI * fc / (q * synthParams.sampleRate));
-		dlyAmp1 = -2.0 * r * cos(synthParams.frqRad * fc);
+		double r = exp(-PI * fc / (q * ctx->sampleRate));
+		dlyAmp1 = -2.0 * r * cos(ctx->frqRad * fc);
 		dlyAmp2 = r * r;
 		inAmp0 = 1.0 + dlyAmp1 + dlyAmp2;
 	}
@@ -332,6 +348,29 @@ public:
 		delayY1 = out;
 		return out;
 	}
+
+	/// Process a block of samples.
+	/// @param block input and output buffers
+	void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue a0 = inAmp0;
+		AmpValue b1 = dlyAmp1;
+		AmpValue b2 = dlyAmp2;
+		AmpValue y1 = delayY1;
+		AmpValue y2 = delayY2;
+		int n = block->size;
+		while (--n >= 0)
+		{
+			AmpValue val = (a0 * *in++) - (b1 * y1) - (b2 * y2);
+			y2 = y1;
+			y1 = val;
+			*out++ = val;
+		}
+		delayY1 = y1;
+		delayY2 = y2;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -356,18 +395,21 @@ protected:
 	AmpValue *val; // input sample values
 	AmpValue *imp; // impulse response
 	int length;
+	ConvolveFFT *cnv; // FFT convolution for long responses
 public:
 	FilterFIRn()
 	{
 		val = NULL;
 		imp = NULL;
 		length = 0;
+		cnv = NULL;
 	}
 
 	~FilterFIRn()
 	{
-		delete val;
-		delete imp;
+		delete[] val;
+		delete[] imp;
+		delete cnv;
 	}
 
 	/// Allocate impulse response. 
@@ -375,23 +417,41 @@ public:
 	/// This array is allocated automatically when Init is called.
 	/// If coefficients are to be set individulally using SetCoef() this function
 	/// must be called first to create the buffer.
+	/// When the length is FIRN_FFT_MIN or more, the filter is calculated
+	/// with partitioned FFT convolution instead of directly.
 	/// @param n number of coefficients
 	void AllocImpResp(int n)
 	{
 		if (val)
 		{
-			delete val;
+			delete[] val;
 			val = NULL;
 		}
 		if (imp)
 		{
-			delete imp;
+			delete[] imp;
 			imp = NULL;
 		}
+		if (cnv)
+		{
+			delete cnv;
+			cnv = NULL;
+		}
 		if ((length = n) > 0)
 		{
 			val = new AmpValue[length];
 			imp = new AmpValue[length];
+			memset(val, 0, length*sizeof(AmpValue));
+			memset(imp, 0, length*sizeof(AmpValue));
+			if (length >= FIRN_FFT_MIN)
+			{
+				cnv = new ConvolveFFT;
+				if (cnv->InitConvolve(length) != 0)
+				{
+					delete cnv;
+					cnv = NULL;
+				}
+			}
 		}
 	}
 
@@ -411,6 +471,7 @@ public:
 			else
 				imp[i] = 0;
 		}
+		UpdateImpResp();
 	}
 
 	/// Set the impulse coefficients. The array must be of the same
@@ -420,8 +481,18 @@ public:
 	{
 		for (int i = 0; i < length; i++)
 			imp[i] = AmpValue(v[i]);
+		UpdateImpResp();
 	}
-	
+
+	/// Apply changed coefficients.
+	/// This must be called after the impulse response array is modified
+	/// other than through Init(), SetCoef() or CalcCoef().
+	void UpdateImpResp()
+	{
+		if (cnv)
+			cnv->SetImpulse(imp);
+	}
+
 	/// Calculate coefficients. 
 	/// The impulse responce coefficients are calculated for a low-pass
 	/// filter using the windowed sinc equation with a Hamming window.
@@ -433,37 +504,37 @@ public:
 	{
 		if (!(length & 1))
 			return;
-		if (fc > synthParams.nyquist)
-			fc = synthParams.nyquist;
+		if (fc > ctx->nyquist)
+			fc = ctx->nyquist;
 		int n2 = length/2;
 		int k;
 		// g is the sum of the coefficients and used
 		// to normalize gain.
 		double g = 0;
 		// ti1 is the sin() phase increment for sinc() calculation.
-		PhsAccum ti1 = fc * synthParams.frqTI;
+		PhsAccum ti1 = fc * ctx->frqTI;
 		// ti2 is the cos() phase increment for Hamming window.
-		PhsAccum ti2 = synthParams.ftableLength / (PhsAccum) (length - 1);
+		PhsAccum ti2 = ctx->ftableLength / (PhsAccum) (length - 1);
 		// Initial phase is at the right lobe of the function.
 		PhsAccum tph1 = ti1;
-		PhsAccum tph2 = ti2 + (synthParams.ftableLength / 4);
+		PhsAccum tph2 = ti2 + (ctx->ftableLength / 4);
 		AmpValue div = 1;
 		int ndx1 = n2 + 1;
 		int ndx2 = n2 - 1;
-		g = twoPI * (fc / synthParams.sampleRate);
+		g = twoPI * (fc / ctx->sampleRate);
 		imp[n2] = g;
 
 		AmpValue v;
 		for (k = 0; k < n2; k++)
 		{
-			v = (wtSet.SinWT(tph1) / div) * (0.54 + (0.46 * wtSet.SinWT(tph2)));
+			v = (ctx->wt->SinWT(tph1) / div) * (0.54 + (0.46 * ctx->wt->SinWT(tph2)));
 			g += v + v;
 			imp[ndx1++] = v;
 			imp[ndx2--] = v;
-			if ((tph1 += ti1) >= synthParams.ftableLength)
-				tph1 -= synthParams.ftableLength;
-			if ((tph2 += ti2) >= synthParams.ftableLength)
-				tph2 -= synthParams.ftableLength;
+			if ((tph1 += ti1) >= ctx->ftableLength)
+				tph1 -= ctx->ftableLength;
+			if ((tph2 += ti2) >= ctx->ftableLength)
+				tph2 -= ctx->ftableLength;
 			div += 1.0;
 		}
 
@@ -477,10 +548,11 @@ public:
 		}
 		if (hp)
 			imp[n2] += 1.0;
+		UpdateImpResp();
 
 		/**** Direct calculation (for reference) ******
 		double m = (double) length - 1;
-		double f = fc / synthParams.sampleRate;
+		double f = fc / ctx->sampleRate;
 		for (k = 0; k < length; k++)
 		{
 			double n = (double)k - (m / 2);
@@ -503,6 +575,8 @@ public:
 		AmpValue *v = val;
 		for (int n = length; n > 0; n--)
 			*v++ = 0;
+		if (cnv)
+			cnv->Reset();
 	}
 
 	/// Process the current sample. The current sample is pushed into the
@@ -510,6 +584,8 @@ public:
 	/// @param inval current sample value.
 	AmpValue Sample(AmpValue inval)
 	{
+		if (cnv)
+			return cnv->Sample(inval);
 		AmpValue out = imp[0] * inval;
 		int m = length-1;
 		AmpValue *vp = &val[m];
@@ -658,7 +734,7 @@ public:
 		bpOut = 0;
 		a = 0;
 		b = 0;
-		maxFc = synthParams.sampleRate / 6.0;
+		maxFc = ctx->sampleRate / 6.0;
 	}
 
 	/// Standard initializer.
@@ -672,7 +748,7 @@ public:
 	{
 		if (fc > maxFc)
 			fc = maxFc;
-		a = 2.0 * wtSet.SinWT(synthParams.maxIncrWT * fc / synthParams.sampleRate);
+		a = 2.0 * ctx->wt->SinWT(ctx->maxIncrWT * fc / ctx->sampleRate);
 		if (q > 0)
 			b = 1.0 / q;
 		else
@@ -40,6 +40,14 @@ public:
 		dlyFeedback = 0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		dlv.SetContext(c);
+		wv.SetContext(c);
+	}
+
 	/// Clear the delay line buffer to zero
 	void Clear()
 	{
@@ -70,8 +78,8 @@ public:
 		inlvl = dlyLvl;
 		mix = dlyMix;
 		fb = dlyFeedback;
-		center = dlyCenter / synthParams.sampleRate;
-		depth = (dlyRange * 2) / synthParams.sampleRate;
+		center = dlyCenter / ctx->sampleRate;
+		depth = (dlyRange * 2) / ctx->sampleRate;
 		sweep = wv.GetFrequency();
 	}
 
@@ -105,8 +113,8 @@ public:
 		dlyLvl = inlvl;
 		dlyMix = mix;
 		dlyFeedback = fb;
-		dlyRange = (depth * synthParams.sampleRate) / 2;
-		dlyCenter = (center * synthParams.sampleRate);
+		dlyRange = (depth * ctx->sampleRate) / 2;
+		dlyCenter = (center * ctx->sampleRate);
 	}
 
 	/// Pass the sample through the flanger unit.
@@ -21,16 +21,111 @@
 #define _GENNOISE_H_
 
 /// White Noise. 
+/// Each generator has its own random number generator so that
+/// no state is shared between voices and a render can be repeated
+/// by seeding each generator with a known value (e.g., the event ID).
+/// The generator is four interleaved xorshift32 sequences.
+/// Each value comes from the next sequence in turn, so a block
+/// of four values is four independent updates that can be
+/// calculated in parallel. Gen() and GenBlock() produce the same values.
 class GenNoise : public GenUnit
 {
+private:
+	bsUint32 state[4];
+	int lane;
+
+	// scramble the seed so that nearby seeds give unrelated sequences
+	static bsUint32 Hash(bsUint32 x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+		x ^= x >> 16;
+		return x;
+	}
+
+protected:
+	/// Generate the next white noise value in the range [-1,+1].
+	/// This is not virtual so that derived classes can call it directly.
+	inline AmpValue White()
+	{
+		bsUint32 x = state[lane];
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		state[lane] = x;
+		lane = (lane + 1) & 3;
+		return (AmpValue) (bsInt32) x * (AmpValue) (1.0 / 2147483648.0);
+	}
+
+	/// Generate a block of white noise values.
+	/// @param out output buffer
+	/// @param frames number of values
+	void WhiteBlock(AmpValue *out, int frames)
+	{
+		while (frames > 0 && lane != 0)
+		{
+			*out++ = White();
+			frames--;
+		}
+		bsUint32 s0 = state[0];
+		bsUint32 s1 = state[1];
+		bsUint32 s2 = state[2];
+		bsUint32 s3 = state[3];
+		const AmpValue scl = (AmpValue) (1.0 / 2147483648.0);
+		while (frames >= 4)
+		{
+			s0 ^= s0 << 13; s0 ^= s0 >> 17; s0 ^= s0 << 5;
+			s1 ^= s1 << 13; s1 ^= s1 >> 17; s1 ^= s1 << 5;
+			s2 ^= s2 << 13; s2 ^= s2 >> 17; s2 ^= s2 << 5;
+			s3 ^= s3 << 13; s3 ^= s3 >> 17; s3 ^= s3 << 5;
+			out[0] = (AmpValue) (bsInt32) s0 * scl;
+			out[1] = (AmpValue) (bsInt32) s1 * scl;
+			out[2] = (AmpValue) (bsInt32) s2 * scl;
+			out[3] = (AmpValue) (bsInt32) s3 * scl;
+			out += 4;
+			frames -= 4;
+		}
+		state[0] = s0;
+		state[1] = s1;
+		state[2] = s2;
+		state[3] = s3;
+		while (--frames >= 0)
+			*out++ = White();
+	}
+
 public:
+	GenNoise()
+	{
+		Seed(0);
+	}
+
 	/// Initialize. This currently has no effect but is needed
 	/// to implement all base class methods.
 	virtual void Init(int n, float *v) { }
 	/// Reset. This currently has no effect but is needed
-	/// to implement all base class methods.
+	/// to implement all base class methods. The random
+	/// sequence continues; use Seed() to restart it.
 	virtual void Reset(float initPhs = 0) { }
 
+	/// Seed the random number generator.
+	/// The same seed always produces the same sequence.
+	/// Instruments seed with the event ID so that each note
+	/// has a different, repeatable, noise signal.
+	/// @param s seed value
+	void Seed(bsUint32 s)
+	{
+		for (int n = 0; n < 4; n++)
+		{
+			bsUint32 x = Hash((s << 2) + (bsUint32) n + 1);
+			if (x == 0)
+				x = 0x9e3779b9U;
+			state[n] = x;
+		}
+		lane = 0;
+	}
+
 	/// Generate the next sample. The noise signal is
 	/// multiplied by the supplied amplitude level.
 	/// @param in peak amplitude level
@@ -45,9 +140,29 @@ public:
 	/// @returns sample value
 	virtual AmpValue Gen()
 	{
-		return ((AmpValue) rand() - (RAND_MAX/2)) / (RAND_MAX/2);
+		return White();
+	}
+
+	/// Generate a block of values normalized to [-1,+1].
+	/// The values are the same as calling Gen() for each sample.
+	/// Derived classes that override Gen() must also override this method.
+	/// @param out output buffer
+	/// @param frames number of values
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		WhiteBlock(out, frames);
 	}
 
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		int n = block->size;
+		GenBlock(out, n);
+		while (--n >= 0)
+			*out++ *= *in++;
+	}
 };
 
 /// Held noise. The frequency setting determines when a new random
@@ -63,7 +178,7 @@ private:
 public:
 	GenNoiseH()
 	{
-		freq = synthParams.sampleRate;
+		freq = ctx->sampleRate;
 		count = 0;
 		hcount = 1;
 		lastVal = 0;
@@ -91,7 +206,7 @@ public:
 	/// @param initPhs not used
 	virtual void Reset(float initPhs = 0)
 	{
-		hcount = (bsInt32) (synthParams.sampleRate / freq);
+		hcount = (bsInt32) (ctx->sampleRate / freq);
 		count = 0;
 	}
 
@@ -101,11 +216,35 @@ public:
 		if (--count <= 0)
 		{
 			count = hcount;
-			lastVal = GenNoise::Gen();
+			lastVal = White();
 		}
 		return lastVal;
 	}
 
+	/// @copydoc GenNoise::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		while (frames > 0)
+		{
+			if (--count <= 0)
+			{
+				count = hcount;
+				lastVal = White();
+			}
+			// this value is used for count samples
+			int span = count;
+			if (span > frames)
+				span = frames;
+			else if (span < 1)
+				span = 1;
+			AmpValue v = lastVal;
+			for (int n = 0; n < span; n++)
+				out[n] = v;
+			out += span;
+			frames -= span;
+			count -= span - 1;
+		}
+	}
 };
 
 /// Interpolated noise. The frequency setting determines when a new random
@@ -123,7 +262,7 @@ private:
 public:
 	GenNoiseI()
 	{
-		freq = synthParams.sampleRate;
+		freq = ctx->sampleRate;
 		hcount = 1;
 		count = 0;
 		lastVal = 0;
@@ -150,12 +289,12 @@ public:
 	/// @param initPhs not used
 	virtual void Reset(float initPhs = 0)
 	{
-		hcount = (bsInt32) (synthParams.sampleRate / freq);
+		hcount = (bsInt32) (ctx->sampleRate / freq);
 		if (hcount < 1)
 			hcount = 1;
 		count = 0;
-		lastVal = GenNoise::Gen();
-		nextVal = GenNoise::Gen();
+		lastVal = White();
+		nextVal = White();
 		incrVal = (nextVal - lastVal) / (AmpValue) hcount;
 	}
 
@@ -166,7 +305,7 @@ public:
 		{
 			count = hcount;
 			lastVal = nextVal;
-			nextVal = GenNoise::Gen();
+			nextVal = White();
 			incrVal = (nextVal - lastVal) / (AmpValue) count;
 		}
 		else
@@ -174,6 +313,29 @@ public:
 		return lastVal;
 	}
 
+	/// @copydoc GenNoise::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		AmpValue v = lastVal;
+		AmpValue incr = incrVal;
+		bsInt32 cnt = count;
+		while (--frames >= 0)
+		{
+			if (--cnt <= 0)
+			{
+				cnt = hcount;
+				v = nextVal;
+				nextVal = White();
+				incr = (nextVal - v) / (AmpValue) cnt;
+			}
+			else
+				v += incr;
+			*out++ = v;
+		}
+		lastVal = v;
+		incrVal = incr;
+		count = cnt;
+	}
 };
 
 /// "Pinkish" noise generator.
@@ -191,11 +353,25 @@ public:
 	/// @copydoc GenNoise::Gen()
 	virtual AmpValue Gen()
 	{
-		AmpValue val = GenNoise::Gen();
+		AmpValue val = White();
 		AmpValue out = (val + prev) / 2;
 		prev = val;
 		return out;
 	}
+
+	/// @copydoc GenNoise::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		WhiteBlock(out, frames);
+		AmpValue p = prev;
+		for (int n = 0; n < frames; n++)
+		{
+			AmpValue val = out[n];
+			out[n] = (val + p) / 2;
+			p = val;
+		}
+		prev = p;
+	}
 };
 
 /// "Pinkish" noise generator.
@@ -217,7 +393,17 @@ public:
 		//AmpValue out = (val + prev) / 2;
 		//prev = out;
 		//return out;
-		return prev = (GenNoise::Gen() + prev) / 2;
+		return prev = (White() + prev) / 2;
+	}
+
+	/// @copydoc GenNoise::GenBlock()
+	virtual void GenBlock(AmpValue *out, int frames)
+	{
+		WhiteBlock(out, frames);
+		AmpValue p = prev;
+		for (int n = 0; n < frames; n++)
+			out[n] = p = (out[n] + p) / 2;
+		prev = p;
 	}
 };
 //@}
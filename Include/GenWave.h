@@ -82,7 +82,7 @@ public:
 	/// @param initPhs phase in radians
 	virtual void Reset(float initPhs = 0)
 	{
-		indexIncr = (PhsAccum)frq * synthParams.frqRad;
+		indexIncr = (PhsAccum)frq * ctx->frqRad;
 		if (indexIncr > PI)
 			indexIncr = PI;
 		if (initPhs >= 0)
@@ -94,7 +94,7 @@ public:
 	/// @param d delta frequency in Hz
 	virtual void Modulate(FrqValue d)
 	{
-		indexIncr = (PhsAccum)(frq + d) * synthParams.frqRad;
+		indexIncr = (PhsAccum)(frq + d) * ctx->frqRad;
 		if (indexIncr > PI)
 			indexIncr = PI;
 	}
@@ -162,7 +162,7 @@ public:
 		PhsAccum f = (PhsAccum)(frq + d);
 		if (f < 0)
 			f = -f;
-		indexIncr = (2 * f) / synthParams.sampleRate;
+		indexIncr = (2 * f) / ctx->sampleRate;
 	}
 
 	/// @copydoc GenWave::PhaseMod()
@@ -180,7 +180,7 @@ public:
 	/// @copydoc GenWave::Reset()
 	virtual void Reset(float initPhs = 0)
 	{
-		indexIncr = (PhsAccum)((2 * frq) / synthParams.sampleRate);
+		indexIncr = (PhsAccum)((2 * frq) / ctx->sampleRate);
 		if (initPhs >= 0)
 		{
 			index = (initPhs * oneDivPI) - 1;
@@ -215,7 +215,7 @@ public:
 	/// @copydoc GenWave::Modulate()
 	virtual void Modulate(FrqValue d)
 	{
-		indexIncr = (PhsAccum)(frq + d) * synthParams.frqRad;
+		indexIncr = (PhsAccum)(frq + d) * ctx->frqRad;
 		if (indexIncr >= PI)
 			indexIncr -= twoPI;
 		else if (indexIncr < -PI)
@@ -347,7 +347,7 @@ private:
 
 	void inline CalcPeriod(FrqValue f)
 	{
-		sqPeriod = (bsInt32) ((synthParams.sampleRate / f) + 0.5);
+		sqPeriod = (bsInt32) ((ctx->sampleRate / f) + 0.5);
 		sqMidPoint = (bsInt32) (((float)sqPeriod * dutyCycle) / 100.0);
 	}
 
@@ -471,7 +471,7 @@ public:
 
 	void Reset(float initPhs = 0)
 	{
-		phsIncr = (PhsAccum)frq / synthParams.sampleRate;
+		phsIncr = (PhsAccum)frq / ctx->sampleRate;
 		if (initPhs >= 0)
 		{
 			phase = (initPhs / twoPI) * phsIncr;
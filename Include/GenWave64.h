@@ -45,7 +45,14 @@ public:
 	{
 		i64Index = 0;
 		i64IndexIncr = 0;
-		i64IndexMask = ((int64)synthParams.itableLength << 40) - 1;
+		i64IndexMask = ((int64)ctx->itableLength << 40) - 1;
+	}
+
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		i64IndexMask = ((int64)ctx->itableLength << 40) - 1;
 	}
 
 	inline void CalcPhase()
@@ -61,10 +68,10 @@ public:
 
 	virtual void PhaseModWT(PhsAccum phs)
 	{
-		if (phs >= synthParams.ftableLength)
-			phs -= synthParams.ftableLength;
+		if (phs >= ctx->ftableLength)
+			phs -= ctx->ftableLength;
 		else if (phs < 0)
-			phs += synthParams.ftableLength;
+			phs += ctx->ftableLength;
 		i64Index += (int64) ((double)phs * two40); //<-- can overflow with large tables
 		//i64Index += (int64) (phs * two32) << 8;  //<-- use this if tables > 16k
 		i64Index &= i64IndexMask;
@@ -88,6 +95,12 @@ public:
 		i64Index = (i64Index + i64IndexIncr) & i64IndexMask;
 		return v;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 //@}
 #endif
@@ -95,6 +95,14 @@ public:
 		SetWavetable(WT_SIN);
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		for (int n = 0; n < 4; n++)
+			osc[n].SetContext(c);
+	}
+
 	/// Set the range and spacing of harmonics.
 	/// Rational values for fr produce harmonic overtones.
 	/// Irrational values produce inharmonic overtones.
@@ -134,7 +142,7 @@ public:
 	{
 		beta = frq * frqRatio;
 		partN = FrqValue(harmNum);
-		FrqValue maxN = floor((synthParams.sampleRate / (2.0*beta)) - (1.0/frqRatio) - 1.0);
+		FrqValue maxN = floor((ctx->sampleRate / (2.0*beta)) - (1.0/frqRatio) - 1.0);
 		if (partN < 1 || partN > maxN)
 			partN = maxN;
 		ampTwo = ampRatio + ampRatio;
@@ -183,11 +191,11 @@ public:
 		osc[2].SetFrequency(frq + ((partN + 1)*beta));
 		osc[3].SetFrequency(frq + (partN * beta));
 
-		indexIncr = synthParams.frqTI * beta;
+		indexIncr = ctx->frqTI * beta;
 		if (initPhs >= 0)
 		{
-			index = (initPhs / twoPI) * synthParams.ftableLength;
-			index += synthParams.ftableLength / 4; // phase shift to make a cosine
+			index = (initPhs / twoPI) * ctx->ftableLength;
+			index += ctx->ftableLength / 4; // phase shift to make a cosine
 		}
 		osc[0].Reset(initPhs);
 		osc[1].Reset(initPhs);
@@ -201,11 +209,11 @@ public:
 	{
 		PhsAccum fo = frq + d;
 		PhsAccum fm = beta + d;
-		indexIncr = synthParams.frqTI * fm;
-		osc[0].indexIncr = synthParams.frqTI * fo;
-		osc[1].indexIncr = synthParams.frqTI * (fo - fm);
-		osc[2].indexIncr = synthParams.frqTI * (fo + ((partN + 1)*fm));
-		osc[3].indexIncr = synthParams.frqTI * (fo + (partN * fm));
+		indexIncr = ctx->frqTI * fm;
+		osc[0].indexIncr = ctx->frqTI * fo;
+		osc[1].indexIncr = ctx->frqTI * (fo - fm);
+		osc[2].indexIncr = ctx->frqTI * (fo + ((partN + 1)*fm));
+		osc[3].indexIncr = ctx->frqTI * (fo + (partN * fm));
 	}
 
 	/// Modulate the phase.
@@ -244,6 +252,12 @@ public:
 		osc[3].index += osc[3].indexIncr;
 		return 1.0;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 
@@ -337,7 +351,7 @@ public:
 	{
 		GenWaveWT::Reset(initPhs);
 		if (initPhs >= 0.0)
-			index2 = index + (synthParams.ftableLength / 4.0);
+			index2 = index + (ctx->ftableLength / 4.0);
 	}
 
 	/// @copydoc GenWaveWT::PhaseModWT()
@@ -358,11 +372,17 @@ public:
 	{
 		index  = PhaseWrapWT(index);
 		index2 = PhaseWrapWT(index2);
-		AmpValue2 out = amp1mSqr * wtSet.SinWT(index) / (amp1pSqr - (ampTwo * wtSet.SinWT(index2)));
+		AmpValue2 out = amp1mSqr * ctx->wt->SinWT(index) / (amp1pSqr - (ampTwo * ctx->wt->SinWT(index2)));
 		index  += indexIncr;
 		index2 += indexIncr;
 		return out;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 
@@ -434,7 +454,7 @@ public:
 		ampScale = 0.0;
 		index2 = 0.0;
 		indexIncr2 = 0.0;
-		frqTI = synthParams.ftableLength / (synthParams.sampleRate * 2.0);
+		frqTI = ctx->ftableLength / (ctx->sampleRate * 2.0);
 	}
 
 	/// @copydoc GenWave::Init
@@ -465,7 +485,7 @@ public:
 	/// @copydoc GenWave::Reset
 	virtual void Reset(float initPhs = 0.0)
 	{
-		bsInt32 maxN = (bsInt32) (synthParams.sampleRate / (2.0 * frq)) - 1;
+		bsInt32 maxN = (bsInt32) (ctx->sampleRate / (2.0 * frq)) - 1;
 		bsInt32 N = (numHarm > maxN) ? maxN : numHarm;
 		if (N <= 0)
 		{
@@ -479,7 +499,7 @@ public:
 		}
 		CalcIncr(frq);
 		if (initPhs >= 0.0)
-			index  = synthParams.radTI * initPhs;
+			index  = ctx->radTI * initPhs;
 		index2 = index * num2p1;
 	}
 
@@ -506,15 +526,21 @@ public:
 	{
 		index = PhaseWrapWT(index);
 		index2 = PhaseWrapWT(index2);
-		AmpValue2 out = wtSet.SinWT(index);
+		AmpValue2 out = ctx->wt->SinWT(index);
 		if (out != 0.0)
-			out = ampScale * ((wtSet.SinWT(index2) / out) - 1.0);
+			out = ampScale * ((ctx->wt->SinWT(index2) / out) - 1.0);
 		else
 			out = 1.0;
 		index  += indexIncr;
 		index2 += indexIncr2;
 		return out;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -562,7 +588,7 @@ public:
 		indexIncr1 = 0.0;
 		index2 = 0.0;
 		indexIncr2 = 0.0;
-		frqTI = synthParams.ftableLength / (synthParams.sampleRate * 2.0);
+		frqTI = ctx->ftableLength / (ctx->sampleRate * 2.0);
 	}
 
 	/// @copydoc GenWave::Init
@@ -593,7 +619,7 @@ public:
 	/// @copydoc GenWave::Reset
 	virtual void Reset(float initPhs = 0.0)
 	{
-		bsInt32 maxN = (bsInt32) (synthParams.sampleRate / (2.0 * frq)) - 1;
+		bsInt32 maxN = (bsInt32) (ctx->sampleRate / (2.0 * frq)) - 1;
 		bsInt32 N = (numHarm > maxN) ? maxN : numHarm;
 		if (N <= 1)
 		{
@@ -608,7 +634,7 @@ public:
 		nump1 = num + 1.0;
 		CalcIncr(frq);
 		if (initPhs >= 0.0)
-			index  = synthParams.radTI * initPhs;
+			index  = ctx->radTI * initPhs;
 		index1 = index * num;
 		index2 = index * nump1;
 	}
@@ -638,9 +664,9 @@ public:
 		index = PhaseWrapWT(index);
 		index1 = PhaseWrapWT(index1);
 		index2 = PhaseWrapWT(index2);
-		AmpValue2 out = wtSet.SinWT(index);
+		AmpValue2 out = ctx->wt->SinWT(index);
 		if (out != 0.0)
-			out = ampScale * wtSet.SinWT(index1) * wtSet.SinWT(index2) / out;
+			out = ampScale * ctx->wt->SinWT(index1) * ctx->wt->SinWT(index2) / out;
 		else
 			out = 1.0;
 		index  += indexIncr;
@@ -648,6 +674,12 @@ public:
 		index2 += indexIncr2;
 		return out;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -682,9 +714,22 @@ public:
 		num2p1 = 2;
 		osca = 0;
 		oscb = 0;
-		bsInt32 midpt = synthParams.itableLength/2;
-		a0 = wtSet.wavSin[midpt-1];
-		a1 = wtSet.wavSin[midpt+1];
+		bsInt32 midpt = ctx->itableLength/2;
+		a0 = ctx->wt->wavSin[midpt-1];
+		a1 = ctx->wt->wavSin[midpt+1];
+	}
+
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		if (osca)
+			osca->SetContext(c);
+		if (oscb)
+			oscb->SetContext(c);
+		bsInt32 midpt = ctx->itableLength/2;
+		a0 = ctx->wt->wavSin[midpt-1];
+		a1 = ctx->wt->wavSin[midpt+1];
 	}
 
 	~GenWaveBuzzA()
@@ -736,7 +781,7 @@ public:
 	/// @copydoc GenWave::Reset
 	void Reset(float initPhs = 0.0)
 	{
-		bsInt32 maxN = (bsInt32) ((synthParams.sampleRate - frq) / (2.0 * frq)) - 1;
+		bsInt32 maxN = (bsInt32) ((ctx->sampleRate - frq) / (2.0 * frq)) - 1;
 		bsInt32 N = (numHarm > maxN) ? maxN : numHarm;
 		if (N <= 0)
 		{
@@ -751,11 +796,13 @@ public:
 		if (osca == NULL)
 		{
 			osca = new GenWaveWT;
+			osca->SetContext(ctx);
 			osca->SetWavetable(WT_SIN);
 		}
 		if (oscb == NULL)
 		{
 			oscb = new GenWaveWT;
+			oscb->SetContext(ctx);
 			oscb->SetWavetable(WT_SIN);
 		}
 		FrqValue f = frq * 0.5;
@@ -793,6 +840,12 @@ public:
 			return ampScale * ((a / b) - 1.0);
 		return 1.0;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 //@}
@@ -23,44 +23,70 @@
 #include "GenWave.h"
 
 /// Generic wavetable based generator (oscillator).
-/// The wave tables are stored in the global \ref wtSet object
+/// The wave tables are stored in the wavetable set of the context
+/// (by default the global \ref wtSet object)
 /// and referenced by index number.
+/// If the table has a mip-map, the band-limited level for
+/// the phase increment is used whenever the frequency changes.
 class GenWaveWT : public GenWave
 {
 public:
 	AmpValue *waveTable;
+	AmpValue **mipMap;
 	int   wtIndex;
 
 	GenWaveWT()
 	{
 		wtIndex = WT_SIN;
-		waveTable = 0; //wtSet.GetWavetable(wtIndex);
+		waveTable = 0; //ctx->wt->GetWavetable(wtIndex);
+		mipMap = 0;
 	}
 
 	/// @copydoc GenWave::Reset()
 	virtual void Reset(float initPhs = 0)
 	{
 		if (waveTable == 0)
-			waveTable = wtSet.GetWavetable(WT_SIN);
+			waveTable = ctx->wt->GetWavetable(WT_SIN);
 
-		indexIncr = PhsAccum(frq) * synthParams.frqTI;
+		indexIncr = PhsAccum(frq) * ctx->frqTI;
 		if (initPhs >= 0)
-			index = (initPhs / twoPI) * synthParams.ftableLength;
+			index = (initPhs / twoPI) * ctx->ftableLength;
+		SelectMip();
 	}
 
 	/// @copydoc GenWave::Modulate()
 	virtual void Modulate(FrqValue d)
 	{
-		indexIncr = (PhsAccum)(frq + d) * synthParams.frqTI;
-		if (indexIncr >= synthParams.maxIncrWT)
-			indexIncr = synthParams.maxIncrWT-1;
+		indexIncr = (PhsAccum)(frq + d) * ctx->frqTI;
+		if (indexIncr >= ctx->maxIncrWT)
+			indexIncr = ctx->maxIncrWT-1;
+		SelectMip();
+	}
+
+	/// Select the mip-map level for the phase increment.
+	/// Level n is used for increments up to 2^n.
+	inline void SelectMip()
+	{
+		if (mipMap)
+		{
+			PhsAccum incr = indexIncr < 0 ? -indexIncr : indexIncr;
+			PhsAccum lim = 1.0;
+			int lvl = 0;
+			int top = ctx->wt->mipLevels - 1;
+			while (lvl < top && incr > lim)
+			{
+				lim += lim;
+				lvl++;
+			}
+			waveTable = mipMap[lvl];
+		}
 	}
 
 	/// @copydoc GenWave::PhaseMod()
 	virtual void PhaseMod(PhsAccum phs)
 	{
-		PhaseModWT(phs * synthParams.radTI);
-		//index += phs * synthParams.radTI;
+		PhaseModWT(phs * ctx->radTI);
+		//index += phs * ctx->radTI;
 	}
 
 	/// Modulate phase for wavetable.
@@ -77,12 +103,15 @@ public:
 	}
 
 	/// Set the wavetable. The wavetable index is used to
-	/// get one of the wavetables allocated in wtSet. If
+	/// get one of the wavetables allocated in the context wavetable set. If
 	/// the index is invalid, the SIN wave table is used.
 	/// @param wti wavetable index
 	inline void SetWavetable(int wti)
 	{
-		waveTable = wtSet.GetWavetable(wtSet.FindWavetable(wtIndex = wti));
+		bsInt32 ndx = ctx->wt->FindWavetable(wtIndex = wti);
+		waveTable = ctx->wt->GetWavetable(ndx);
+		mipMap = ctx->wt->GetMipMap(ndx);
+		SelectMip();
 	}
 
 	/// Get the wavetable index
@@ -123,16 +152,16 @@ public:
 	/// @return phase limited to table length.
 	inline PhsAccum PhaseWrapWT(PhsAccum phs)
 	{
-		if (phs >= synthParams.ftableLength)
+		if (phs >= ctx->ftableLength)
 		{
 			do
-				phs -= synthParams.ftableLength;
-			while (phs >= synthParams.ftableLength);
+				phs -= ctx->ftableLength;
+			while (phs >= ctx->ftableLength);
 		}
 		else if (phs < 0)
 		{
 			do
-				phs += synthParams.ftableLength;
+				phs += ctx->ftableLength;
 			while (phs < 0);
 		}
 		return phs;
@@ -147,6 +176,27 @@ public:
 		index += indexIncr;
 		return waveTable[n];
 	}
+
+	/// @copydoc GenUnit::Samples()
+	/// The phase and table are held in locals for the whole block
+	/// so that no virtual call is made per sample. Derived classes
+	/// that override Gen() must also override this method.
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue *wt = waveTable;
+		PhsAccum phs = index;
+		PhsAccum incr = indexIncr;
+		int n = block->size;
+		while (--n >= 0)
+		{
+			phs = PhaseWrapWT(phs);
+			*out++ = wt[(int) (phs + 0.5)] * *in++;
+			phs += incr;
+		}
+		index = phs;
+	}
 };
 
 
@@ -175,6 +225,28 @@ public:
 		AmpValue2 v2 = (AmpValue2) waveTable[intIndex+1];
 		return (v1 + ((v2 - v1) * fract));
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue *wt = waveTable;
+		PhsAccum phs = index;
+		PhsAccum incr = indexIncr;
+		int n = block->size;
+		while (--n >= 0)
+		{
+			phs = PhaseWrapWT(phs);
+			int intIndex = (int) phs;
+			PhsAccum fract = phs - (PhsAccum) intIndex;
+			phs += incr;
+			AmpValue2 v1 = (AmpValue2) wt[intIndex];
+			AmpValue2 v2 = (AmpValue2) wt[intIndex+1];
+			*out++ = (AmpValue) (v1 + ((v2 - v1) * fract)) * *in++;
+		}
+		index = phs;
+	}
 };
 
 /// Fast wavetable generator. 
@@ -201,7 +273,14 @@ public:
 	{
 		i32Index = 0;
 		i32IndexIncr = 0;
-		i32IndexMask = (synthParams.itableLength << 16) - 1;
+		i32IndexMask = (ctx->itableLength << 16) - 1;
+	}
+
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		i32IndexMask = (ctx->itableLength << 16) - 1;
 	}
 
 	/// @copydoc GenWave::Modulate()
@@ -234,6 +313,29 @@ public:
 		i32Index = (i32Index + i32IndexIncr) & i32IndexMask;
 		return v; 
 	}
+
+	/// @copydoc GenUnit::Samples()
+	/// Since the table length is a power of two, the index for
+	/// sample n is (start + n*incr) & mask. That removes the
+	/// dependency between iterations so the index calculation
+	/// and the amplitude multiply can be vectorized.
+	virtual void Samples(SampleBlock *block)
+	{
+		int n = block->size;
+		if (n <= 0)
+			return;
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		AmpValue *wt = waveTable;
+		bsUint32 incr = (bsUint32) i32IndexIncr;
+		bsUint32 mask = (bsUint32) i32IndexMask;
+		// the first index may be unmasked after PhaseModWT()
+		out[0] = wt[(i32Index + 0x8000) >> 16] * in[0];
+		bsUint32 start = (bsUint32) i32Index;
+		for (int k = 1; k < n; k++)
+			out[k] = wt[(((start + (bsUint32) k * incr) & mask) + 0x8000) >> 16] * in[k];
+		i32Index = (bsInt32) ((start + (bsUint32) n * incr) & mask);
+	}
 };
 
 /// Specialized wavetable oscillator for sample playback.
@@ -325,7 +427,7 @@ public:
 	{
 		frq = fo;
 		recFrq = fr;
-		rateRatio = (FrqValue) sr / synthParams.sampleRate;
+		rateRatio = (FrqValue) sr / ctx->sampleRate;
 		piMult = rateRatio / recFrq; // pre-calculate for Modulate code
 		period = sr / recFrq;
 		tableEnd = (PhsAccum) te;
@@ -400,6 +502,91 @@ public:
 		return v1 + ((v2 - v1) * fr);
 	}
 
+	/// Get the current phase increment.
+	inline PhsAccum GetPhaseIncr()
+	{
+		return phsIncr;
+	}
+
+	/// Count the samples that can be produced before a boundary.
+	/// This returns the number of samples (up to frames) for which
+	/// the phase is known to stay between 0 and the loop end
+	/// (or table end when not looping). Within that span, Gen()
+	/// would never wrap or stop, so the caller can run the
+	/// interpolation without any per-sample tests.
+	/// The phase increment may change by incrStep each sample.
+	/// @param frames maximum number of samples
+	/// @param incrStep change in phase increment per sample
+	/// @return number of samples before the boundary, or 0
+	int SpanCount(int frames, PhsAccum incrStep)
+	{
+		if (phase < 0)
+			return 0;
+		PhsAccum limit = loopMode ? loopEnd : tableEnd;
+		PhsAccum incrEnd = phsIncr + (incrStep * (PhsAccum) (frames - 1));
+		PhsAccum incrMax = phsIncr > incrEnd ? phsIncr : incrEnd;
+		if (phsIncr <= 0 || incrEnd <= 0 || phase >= limit)
+			return 0;
+		PhsAccum count = (limit - phase) / incrMax;
+		if (count >= (PhsAccum) frames)
+			return frames;
+		// leave the sample nearest the boundary to Gen()
+		return (int) count - 1;
+	}
+
+	/// Generate a block of samples.
+	/// Spans between loop and end boundaries are produced
+	/// in a tight loop, while the samples at a boundary are
+	/// produced by Gen(). The output is identical to calling
+	/// Gen() for each sample, adding incrStep to the phase
+	/// increment after each.
+	/// @param out output buffer
+	/// @param frames number of samples
+	/// @param incrStep change in phase increment per sample
+	void GenBlock(AmpValue *out, int frames, PhsAccum incrStep = 0)
+	{
+		while (frames > 0)
+		{
+			int count = SpanCount(frames, incrStep);
+			if (count > 0)
+			{
+				AmpValue *wt = wavetable;
+				PhsAccum phs = phase;
+				PhsAccum incr = phsIncr;
+				for (int n = 0; n < count; n++)
+				{
+					int ndx = (int) phs;
+					PhsAccum fract = phs - (PhsAccum) ndx;
+					phs += incr;
+					incr += incrStep;
+					AmpValue v1 = wt[ndx];
+					out[n] = v1 + ((wt[ndx+1] - v1) * fract);
+				}
+				phase = phs;
+				phsIncr = incr;
+				out += count;
+				frames -= count;
+			}
+			else
+			{
+				*out++ = Gen();
+				phsIncr += incrStep;
+				frames--;
+			}
+		}
+	}
+
+	/// @copydoc GenUnit::Samples()
+	void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		int n = block->size;
+		GenBlock(out, n);
+		while (--n >= 0)
+			*out++ *= *in++;
+	}
+
 	/// Determine if the wavetable end has been reached.
 	/// For wavetables with values past the loop end, you must call
 	/// Release() to transition past the loop end.
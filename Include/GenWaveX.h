@@ -182,7 +182,7 @@ public:
 	/// that exceed the Nyquist limit are eliminated.
 	void CalcParts()
 	{
-		FrqValue tld2 = synthParams.ftableLength / 2;
+		FrqValue tld2 = ctx->ftableLength / 2;
 		scale = 0;
 		cntPart = 0;
 		AmpValue sigK = 0;
@@ -203,8 +203,8 @@ public:
 				if (gibbs && pp->mul > 0)
 				{
 					sigN = sigK * pp->mul;
-					//pp->sigma = (wtSet.wavSin[(int)((sigN*sigTL)+0.5)] / sigN) * pp->amp;
-					pp->sigma = pp->amp * wtSet.SinWT(sigN*sigTL) / sigN;
+					//pp->sigma = (ctx->wt->wavSin[(int)((sigN*sigTL)+0.5)] / sigN) * pp->amp;
+					pp->sigma = pp->amp * ctx->wt->SinWT(sigN*sigTL) / sigN;
 				}
 				else
 					pp->sigma = pp->amp;
@@ -235,6 +235,12 @@ public:
 		}
 		return val / scale;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 
@@ -291,15 +297,15 @@ public:
 	/// is changed and does not normally need to be called directly.
 	inline void CalcModAmp()
 	{
-		//modAmp = synthParams.frqTI * indexOfMod * frq * modMult;
+		//modAmp = ctx->frqTI * indexOfMod * frq * modMult;
 		modAmp = indexOfMod * modIncr;
 	}
 
 	inline void CalcModIncr()
 	{
 		modIncr = indexIncr * modMult;
-		if (modIncr > synthParams.maxIncrWT)
-			modIncr = synthParams.maxIncrWT;
+		if (modIncr > ctx->maxIncrWT)
+			modIncr = ctx->maxIncrWT;
 		CalcModAmp();
 	}
 
@@ -334,7 +340,7 @@ public:
 	{
 		GenWaveWT::Reset(initPhs);
 		if (initPhs >= 0)
-			modIndex = initPhs * synthParams.radTI;
+			modIndex = initPhs * ctx->radTI;
 		CalcModIncr();
 	}
 
@@ -363,6 +369,12 @@ public:
 
 		return valCar;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 /// Amplitude modulation (AM) Generator (2-quadrant multiply)
@@ -415,15 +427,15 @@ public:
 	virtual void Reset(float initPhs = 0)
 	{
 		GenWaveWT::Reset(initPhs);
-		modIncr = synthParams.frqTI * PhsAccum(modFrq);
+		modIncr = ctx->frqTI * PhsAccum(modFrq);
 		if (initPhs >= 0)
-			modIndex = initPhs * synthParams.radTI;
+			modIndex = initPhs * ctx->radTI;
 	}
 
 	virtual void Modulate(FrqValue d)
 	{
 		GenWaveWT::Modulate(d);
-		modIncr = synthParams.frqTI * PhsAccum(modFrq+d);
+		modIncr = ctx->frqTI * PhsAccum(modFrq+d);
 	}
 
 	virtual void PhaseModWT(PhsAccum phs)
@@ -444,6 +456,12 @@ public:
 		modIndex += modIncr;
 		return out;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 /// Ring modulation (RM) generator (i.e. 4-quadrant multiply)
@@ -474,6 +492,14 @@ private:
 	GenNoiseI nz;
 
 public:
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		osc.SetContext(c);
+		nz.SetContext(c);
+	}
+
 	/// Initialize the oscillator.
 	/// The array of values contains {Fo WT Fn}
 	/// where Fo is the oscillator frequency,
@@ -504,6 +530,13 @@ public:
 		nz.Reset(initPhs);
 	}
 
+	/// Seed the noise generator.
+	/// @param s seed value
+	void Seed(bsUint32 s)
+	{
+		nz.Seed(s);
+	}
+
 	/// @copydoc GenWave::Sample
 	virtual AmpValue Sample(AmpValue in)
 	{
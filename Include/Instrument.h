@@ -14,6 +14,7 @@
 #define _INSTRDEF_
 
 class InstrManager; // forward reference for type defs below
+class InstrPool;
 class Sequencer;
 
 ///////////////////////////////////////////////////////////
@@ -26,7 +27,24 @@ class Sequencer;
 class Instrument
 {
 public:
+	InstrPool *pool; ///< Pool that keeps this instance when deallocated
+
+	Instrument() { pool = 0; }
 	virtual ~Instrument() { }
+
+	/// Allocate instance memory from the voice arena.
+	/// Instances of the same size are carved from shared,
+	/// cache-line aligned chunks so that the voices of one
+	/// instrument type sit next to each other in memory.
+	/// Freed slots are kept for the next instance of the
+	/// same size. The chunks are never returned to the heap.
+	/// @param size size of the derived instrument object
+	static void *operator new(size_t size);
+
+	/// Return instance memory to the voice arena.
+	/// @param ptr instance memory
+	/// @param size size of the derived instrument object
+	static void operator delete(void *ptr, size_t size);
 	
 	/// Start output.
 	/// This method is called when the current playback time
@@ -35,6 +53,18 @@ public:
 	/// parameters for note initialization.
 	/// @param evt the start event
 	virtual void Start(SeqEvent *evt) { }
+
+	/// Catch up with an event that started earlier.
+	/// This method is called in place of Start when the sequencer
+	/// begins playback after the event start time and event chase
+	/// is on (see Sequencer::SetChase). The instrument should apply
+	/// any lasting effect of the event as it would be after the
+	/// elapsed time, without producing samples. The default does
+	/// nothing, which is right for ordinary notes.
+	/// @param evt the start event
+	/// @param elapsed samples between the event start and the playback start
+	/// @return non-zero to keep the instrument active with the remaining duration
+	virtual int Chase(SeqEvent *evt, bsInt32 elapsed) { return 0; }
 	
 	/// Change parameters. 
 	/// Used to alter parameters while playing.
@@ -63,6 +93,19 @@ public:
 	/// set by the instrument factory function.
 	virtual void Tick() { }
 
+	/// Produce a block of samples.
+	/// This method is called by the sequencer when block rendering
+	/// is enabled. Output should be done through the block output
+	/// methods on the instrument manager (OutputBlock, Output2Block,
+	/// FxSendBlock) which place samples starting at the current 
+	/// block position. The number of frames will not exceed MAX_BLKLEN.
+	/// The default implementation returns 0 to indicate the instrument
+	/// only supports Tick(). The caller then invokes Tick() once for 
+	/// each frame.
+	/// @param frames number of samples to generate
+	/// @return non-zero if the block was generated
+	virtual int TickBlock(int frames) { return 0; }
+
 	/// Test for output complete.
 	/// IsFinished is called for each sample after Stop has been sent
 	/// to determine if the instrument can be removed from
@@ -77,6 +120,19 @@ public:
 	/// this method would not actually delete the instance.
 	virtual void Destroy() { delete this; }
 
+	/// Prepare the instance for reuse.
+	/// This is called when a pooled instance is returned to
+	/// the instrument manager, in place of Destroy(). The instrument
+	/// should release per-note resources and restore the settings
+	/// copied from the template, so that the next Start() behaves
+	/// as on a new instance. This is called on the playback thread
+	/// and should not allocate memory. The default returns 0 to
+	/// indicate the instrument cannot be reused. The instance is
+	/// then destroyed and must be left unchanged.
+	/// @param tmplt the template used to create the instance
+	/// @return non-zero if the instance can be reused
+	virtual int Recycle(Opaque tmplt) { return 0; }
+
 	/// Load instrument settings.
 	/// Called to load the instrument configuration from an XML file
 	virtual int Load(XmlSynthElem *parent) { return -1; }
@@ -244,6 +300,99 @@ public:
 	}
 };
 
+///////////////////////////////////////////////////////////
+/// A pool of instrument instances.
+/// The pool holds instances of one instrument configuration
+/// that have finished playing so that they can be reused
+/// without heap allocation. The capacity is set ahead of
+/// playback (see InstrManager::Preallocate) and instances
+/// returned to a full pool are destroyed.
+///////////////////////////////////////////////////////////
+class InstrPool
+{
+private:
+	Instrument **items;
+	int count;
+	int maxItems;
+	Opaque tmplt;
+
+public:
+	InstrPool()
+	{
+		items = 0;
+		count = 0;
+		maxItems = 0;
+		tmplt = 0;
+	}
+
+	~InstrPool()
+	{
+		Clear();
+		delete[] items;
+	}
+
+	/// Set the template passed to Instrument::Recycle.
+	void SetTemplate(Opaque tp) { tmplt = tp; }
+
+	/// Get the template passed to Instrument::Recycle.
+	Opaque GetTemplate() { return tmplt; }
+
+	/// Set the capacity.
+	/// The capacity can only grow.
+	/// @param n maximum number of idle instances
+	void SetMax(int n)
+	{
+		if (n <= maxItems)
+			return;
+		Instrument **newItems = new Instrument*[n];
+		for (int i = 0; i < count; i++)
+			newItems[i] = items[i];
+		delete[] items;
+		items = newItems;
+		maxItems = n;
+	}
+
+	/// Get the capacity.
+	int GetMax() { return maxItems; }
+
+	/// Get the number of idle instances.
+	int GetCount() { return count; }
+
+	/// Take an idle instance from the pool.
+	/// @return instance or null if the pool is empty
+	Instrument *Get()
+	{
+		if (count > 0)
+			return items[--count];
+		return 0;
+	}
+
+	/// Return an instance to the pool.
+	/// The instance is recycled if there is room.
+	/// @param ip instance
+	/// @return non-zero if the pool kept the instance
+	int Put(Instrument *ip)
+	{
+		if (count < maxItems && ip->Recycle(tmplt))
+		{
+			items[count++] = ip;
+			return 1;
+		}
+		return 0;
+	}
+
+	/// Destroy all idle instances.
+	void Clear()
+	{
+		while (count > 0)
+		{
+			Instrument *ip = items[--count];
+			ip->pool = 0;
+			ip->Destroy();
+		}
+	}
+};
+
 ///////////////////////////////////////////////////////////
 /// An instrment configuration.
 /// This class is used by the instrument manager
@@ -261,6 +410,7 @@ public:
 	bsString desc;  ///< Instrument description
 	Opaque instrTmplt; ///< Template to create new instance.
 	InstrMapEntry *instrType; ///< Instrument type entry
+	InstrPool pool; ///< Idle instances for reuse
 
 	InstrConfig()
 	{
@@ -278,6 +428,7 @@ public:
 
 	~InstrConfig()
 	{
+		pool.Clear();
 		if (instrType && instrType->dumpTmplt && instrTmplt)
 			instrType->dumpTmplt(instrTmplt);
 	}
@@ -387,6 +538,11 @@ protected:
 	Mixer *mix;               ///< Mixer - accumulator for instrument output
 	WaveOut *wvf;             ///< Audio endpoint
 	Sequencer *seq;           ///< The sequencer (when appropriate)
+	SynthContext *ctx;        ///< Sample rate and wavetables for this engine
+	int blkLen;               ///< Block length (0 = per-sample output)
+	int blkPos;               ///< Current frame in the block
+	AmpValue *blkOut;         ///< Mixer output for a block (left, right)
+	int busOn;                ///< Output may be redirected to a MixBus
 	bsInt16 internalID;       ///< Counter for next auto instrument ID
 	Instrument *exclNotes[16*16]; ///< SF2/DLS exclusive notes 16 channels, 16 groups each
 
@@ -398,6 +554,11 @@ public:
 		mix = 0;
 		wvf = 0;
 		seq = 0;
+		ctx = SynthContext::Current();
+		blkLen = 0;
+		blkPos = 0;
+		blkOut = 0;
+		busOn = 0;
 		internalID = 16384;
 		for (int ch = 0; ch < 16; ch++)
 			channel[ch].Reset();
@@ -407,6 +568,7 @@ public:
 
 	virtual ~InstrManager() 
 	{
+		delete[] blkOut;
 		Clear();
 		InstrMapEntry *ime;
 		while ((ime = typeList) != 0)
@@ -439,8 +601,29 @@ public:
 	{
 		mix =  m;
 		wvf = w;
+		if (mix)
+			mix->SetContext(ctx);
 	}
 
+	/// Set the synthesis context.
+	/// The context supplies the sample rate and wavetables
+	/// used by instruments created through this manager.
+	/// It is made current on the calling thread while
+	/// instruments and templates are constructed, and
+	/// is passed on to the mixer.
+	/// Set the context before loading instruments.
+	/// @param c synthesis context
+	void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		if (mix)
+			mix->SetContext(c);
+	}
+
+	/// Get the synthesis context.
+	/// @return synthesis context
+	inline SynthContext *GetContext() { return ctx; }
+
 	inline void SetSequencer(Sequencer *s) { seq = s; }
 	inline void SetMixer(Mixer *m) { mix = m; }
 	inline Mixer *GetMixer() { return mix; }
@@ -614,7 +797,17 @@ public:
 	virtual Instrument *Allocate(InstrConfig *in)
 	{
 		if (in)
-			return in->MakeInstance(this);
+		{
+			Instrument *ip = in->pool.Get();
+			if (ip)
+				return ip;
+			SynthContext *prev = SynthContext::MakeCurrent(ctx);
+			ip = in->MakeInstance(this);
+			SynthContext::MakeCurrent(prev);
+			if (ip && in->pool.GetMax() > 0)
+				ip->pool = &in->pool;
+			return ip;
+		}
 		return new Instrument;
 	}
 
@@ -623,17 +816,67 @@ public:
 	virtual Instrument *Allocate(SeqEvent *evt)
 	{
 		if (evt->im)
-			return evt->im->MakeInstance(this);
+			return Allocate(evt->im);
 		return Allocate(FindInstr(evt->inum));
 	}
 
 	/// Deallocate an instrument instance.
+	/// Pooled instances are kept for reuse if possible,
+	/// otherwise the instance is destroyed.
 	/// @param ip pointer to the instrument object
 	virtual void Deallocate(Instrument *ip)
 	{
+		InstrPool *pp = ip->pool;
+		if (pp && pp->Put(ip))
+			return;
 		ip->Destroy();
 	}
 
+	/// Create instrument instances ahead of playback.
+	/// The instances are kept in a pool for the instrument
+	/// configuration and used by Allocate before creating new
+	/// ones. Instances returned by Deallocate go back to the pool
+	/// while it has fewer than count idle instances.
+	/// Only instruments that implement Instrument::Recycle are pooled.
+	/// This should be called after the instrument is loaded
+	/// and before playback starts.
+	/// @param inum instrument number
+	/// @param count number of instances
+	/// @return number of idle instances, or -1 if the instrument cannot be pooled
+	int Preallocate(bsInt16 inum, int count)
+	{
+		return Preallocate(FindInstr(inum), count);
+	}
+
+	/// Create instrument instances ahead of playback.
+	/// @param in instrument configuration
+	/// @param count number of instances
+	/// @return number of idle instances, or -1 if the instrument cannot be pooled
+	int Preallocate(InstrConfig *in, int count)
+	{
+		if (in == 0 || in->instrType == 0)
+			return -1;
+		InstrPool *pp = &in->pool;
+		pp->SetTemplate(in->instrTmplt);
+		pp->SetMax(count);
+		SynthContext *prev = SynthContext::MakeCurrent(ctx);
+		while (pp->GetCount() < count)
+		{
+			Instrument *ip = in->MakeInstance(this);
+			if (ip == 0)
+				break;
+			ip->pool = pp;
+			if (!pp->Put(ip))
+			{
+				ip->Destroy();
+				SynthContext::MakeCurrent(prev);
+				return -1;
+			}
+		}
+		SynthContext::MakeCurrent(prev);
+		return pp->GetCount();
+	}
+
 	/// Allocate a new event for an instrument.
 	/// @param inum instrument number
 	virtual SeqEvent *ManufEvent(bsInt16 inum)
@@ -689,13 +932,155 @@ public:
 		wvf->Output2(outLft, outRgt);
 	}
 
+	/// Set the block length.
+	/// This is called by the sequencer before playback when block
+	/// rendering is enabled, and with a length of zero when playback
+	/// ends. While a block length is set, instruments output samples
+	/// starting at the frame set by SetBlockPos() and the sequencer
+	/// calls TickBlock() instead of Tick(). Derived classes that
+	/// override Output() or Tick() must also override this method
+	/// and the block output methods, or return 0 to indicate block
+	/// rendering is not supported.
+	/// @param frames maximum frames in a block
+	/// @return non-zero if block rendering is supported
+	virtual int SetBlockLength(int frames)
+	{
+		blkLen = frames;
+		blkPos = 0;
+		delete[] blkOut;
+		blkOut = 0;
+		if (frames > 0)
+			blkOut = new AmpValue[frames*2];
+		if (mix)
+			mix->SetBlockLength(frames);
+		return 1;
+	}
+
+	/// Get the block length.
+	inline int GetBlockLength() { return blkLen; }
+
+	/// Set the position in the block for output.
+	/// @param n frame in the block
+	inline void SetBlockPos(int n)
+	{
+		blkPos = n;
+		if (mix)
+			mix->SetBlockPos(n);
+	}
+
+	/// Get the position in the block for output.
+	inline int GetBlockPos() { return blkPos; }
+
+	/// Enable output to a MixBus.
+	/// This is called by the sequencer when voices are rendered
+	/// on more than one thread. While enabled, output from a thread
+	/// with a current MixBus goes to that bus instead of the mixer.
+	/// Derived classes that override the output methods must check
+	/// ThreadBus() in each of them, or return 0 to indicate
+	/// redirected output is not supported.
+	/// @param on 1 to enable, 0 to disable
+	/// @return non-zero if redirected output is supported
+	virtual int EnableBus(int on)
+	{
+		busOn = on;
+		return 1;
+	}
+
+	/// Get the MixBus for the calling thread.
+	/// @return current bus, or null when output goes to the mixer
+	inline MixBus *ThreadBus()
+	{
+		if (busOn)
+			return MixBus::Current();
+		return 0;
+	}
+
+	/// Output the contents of a bus.
+	/// The values are sent through the output methods on
+	/// the calling thread, which must not have a current bus,
+	/// starting at frame 0 in the block. The bus is cleared.
+	/// @param bus the bus to output
+	/// @param frames number of frames in the block
+	void OutputBus(MixBus *bus, int frames)
+	{
+		AmpValue *bp;
+		int n;
+		int chnls = bus->GetChannels();
+		int fxUnits = bus->GetFxUnits();
+		int rgt = bus->GetBlockLength();
+		SetBlockPos(0);
+		for (n = 0; n < chnls; n++)
+		{
+			if ((bp = bus->GetMono(n)) != 0)
+				OutputBlock(n, bp, frames);
+			if ((bp = bus->GetDirect(n)) != 0)
+				Output2Block(n, bp, bp + rgt, frames);
+		}
+		for (n = 0; n < fxUnits; n++)
+		{
+			if ((bp = bus->GetFx(n)) != 0)
+				FxSendBlock(n, bp, frames);
+		}
+		bus->Clear(frames);
+	}
+
+	/// Get the dry stereo output of a bus.
+	/// This is called by the sequencer when voices are rendered
+	/// as stems, before the bus is output. It may be called
+	/// on a worker thread and must not change the mixer.
+	/// The default applies the mixer channel and master settings
+	/// without effects (see MixBus::StemBlock).
+	/// @param bus the bus holding the stem
+	/// @param lft left output values
+	/// @param rgt right output values
+	/// @param frames number of frames in the block
+	virtual void StemBlock(MixBus *bus, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		bus->StemBlock(mix, lft, rgt, frames);
+	}
+
+	/// TickBlock is called by the sequencer at the end of each block
+	/// when block rendering is enabled. All active instruments have
+	/// produced values for the frames in the block. The default
+	/// mixes the whole block with Mixer::OutBlock() and sends
+	/// the result to the output. Derived classes that override
+	/// Tick() must also override this method.
+	/// @param frames number of frames in the block
+	virtual void TickBlock(int frames)
+	{
+		AmpValue *lp = blkOut;
+		AmpValue *rp = blkOut + blkLen;
+		mix->OutBlock(lp, rp, frames);
+		for (int n = 0; n < frames; n++)
+			wvf->Output2(lp[n], rp[n]);
+		SetBlockPos(0);
+	}
+
 	/// Direct output to effects units. This bypasses the
 	/// normal input channel volume, pan, and fx send values.
 	/// @param unit effects unit number
 	/// @param val amplitude value to send
 	virtual void FxSend(int unit, AmpValue val)
 	{
-		mix->FxIn(unit, val);
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->FxIn(unit, val);
+		else
+			mix->FxIn(unit, val);
+	}
+
+	/// Direct output of a block to effects units.
+	/// Values are placed starting at the current block position.
+	/// @param unit effects unit number
+	/// @param val amplitude values to send
+	/// @param frames number of values
+	virtual void FxSendBlock(int unit, AmpValue *val, int frames)
+	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->FxInBlock(unit, val, frames);
+		else
+			mix->FxInBlock(unit, val, frames);
 	}
 
 	/// Output a sample on the indicated channel.
@@ -705,7 +1090,11 @@ public:
 	/// @param val amplitude value
 	virtual void Output(int ch, AmpValue val)
 	{
-		mix->ChannelIn(ch, val);
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->In(ch, val);
+		else
+			mix->ChannelIn(ch, val);
 	}
 
 	/// Output a left/right sample on the indicated channel.
@@ -717,7 +1106,40 @@ public:
 	/// @param rgt right output amplitude value
 	virtual void Output2(int ch, AmpValue lft, AmpValue rgt)
 	{
-		mix->ChannelIn2(ch, lft, rgt);
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->In2(ch, lft, rgt);
+		else
+			mix->ChannelIn2(ch, lft, rgt);
+	}
+
+	/// Output a block of samples on the indicated channel.
+	/// Values are placed starting at the current block position.
+	/// @param ch mixer input channel
+	/// @param val amplitude values
+	/// @param frames number of values
+	virtual void OutputBlock(int ch, AmpValue *val, int frames)
+	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->InBlock(ch, val, frames);
+		else
+			mix->ChannelInBlock(ch, val, frames);
+	}
+
+	/// Output a block of left/right samples on the indicated channel.
+	/// Values are placed starting at the current block position.
+	/// @param ch mixer input channel
+	/// @param lft left output amplitude values
+	/// @param rgt right output amplitude values
+	/// @param frames number of values
+	virtual void Output2Block(int ch, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->In2Block(ch, lft, rgt, frames);
+		else
+			mix->ChannelIn2Block(ch, lft, rgt, frames);
 	}
 
 	/// Controller change (MIDI).
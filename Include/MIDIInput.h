@@ -45,8 +45,8 @@ typedef ULONG_PTR DWORD_PTR;
 class MIDIInput
 {
 protected:
-	bsUint8 noteOn[128];
-	bsUint8 noteOff[128];
+	bsUint8 noteOn[16][128];  ///< note-on count by channel and key
+	bsUint8 noteOff[16][128]; ///< note-off count by channel and key
 	int devNum;
 	bsString devName;
 	Sequencer *seq;
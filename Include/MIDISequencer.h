@@ -199,7 +199,7 @@ public:
 		}
 		mix.MasterVolume(0.5, 0.5);
 		ppqn = 24.0e6;
-		srTicks = (0.5 * synthParams.sampleRate) / 24.0;
+		srTicks = (0.5 * SynthContext::Current()->sampleRate) / 24.0;
 	}
 
 	~MIDISequence()
@@ -268,7 +268,7 @@ public:
 
 	void Tempo(long val)
 	{
-		srTicks = ((FrqValue)val * synthParams.sampleRate) / ppqn;
+		srTicks = ((FrqValue)val * SynthContext::Current()->sampleRate) / ppqn;
 	}
 
 	void ProgChange(short chnl, short val)
@@ -73,12 +73,21 @@ public:
 	AmpValue panval;
 	AmpValue panlft;
 	AmpValue panrgt;
+	SynthContext *ctx;
 
 	Panner()
 	{
 		panval = 0.0;
 		panlft = 0.5;
 		panrgt = 0.5;
+		ctx = SynthContext::Current();
+	}
+
+	/// Set the synthesis context that holds the pan tables.
+	/// @param c synthesis context
+	void SetContext(SynthContext *c)
+	{
+		ctx = c;
 	}
 
 	/// Set the pan method and value.
@@ -110,15 +119,15 @@ public:
 		{
 			//panlft = sin(panlft * PI/2) * sqrt(2)/2;
 			//panrgt = sin(panrgt * PI/2) * sqrt(2)/2;
-			panlft = synthParams.sinquad[(int)(panlft * synthParams.sqNdx)];
-			panrgt = synthParams.sinquad[(int)(panrgt * synthParams.sqNdx)];
+			panlft = ctx->sinquad[(int)(panlft * ctx->sqNdx)];
+			panrgt = ctx->sinquad[(int)(panrgt * ctx->sqNdx)];
 		}
 		else if (pm == panSqr)
 		{
 			//panlft = sqrt(panlft) * sqrt(2)/2;
 			//panrgt = sqrt(panrgt) * sqrt(2)/2;
-			panlft = synthParams.sqrttbl[(int)(panlft * synthParams.sqNdx)];
-			panrgt = synthParams.sqrttbl[(int)(panrgt * synthParams.sqNdx)];
+			panlft = ctx->sqrttbl[(int)(panlft * ctx->sqNdx)];
+			panrgt = ctx->sqrttbl[(int)(panrgt * ctx->sqNdx)];
 		}
 	}
 };
@@ -153,6 +162,7 @@ public:
 	AmpValue *fxlvl; // one for each input channel
 	AmpValue value;  // total input
 	AmpValue fxmix;  // output level
+	AmpValue *blk;   // direct input, one for each frame in a block
 	Panner   pan;
 	int init;
 
@@ -163,11 +173,61 @@ public:
 		fxlvl = 0;
 		value = 0;
 		fxmix = 0;
+		blk = 0;
 	}
 
 	~FxChannel()
 	{
 		delete[] fxlvl;
+		delete[] blk;
+	}
+
+	/// Set the synthesis context used for panning.
+	/// The effects unit has its own context.
+	void SetContext(SynthContext *c)
+	{
+		pan.SetContext(c);
+	}
+
+	/// Set the block length.
+	/// A length of zero discards the block buffer.
+	/// @param frames maximum frames in a block
+	void SetBlockLength(int frames)
+	{
+		delete[] blk;
+		blk = 0;
+		if (frames > 0)
+		{
+			blk = new AmpValue[frames];
+			memset(blk, 0, frames*sizeof(AmpValue));
+		}
+	}
+
+	/// Effects in direct at a position in the block.
+	/// @param n frame in the block
+	/// @param val input amplitude value
+	void FxInAt(int n, AmpValue val)
+	{
+		blk[n] += val;
+	}
+
+	/// Effects in direct for a run of frames.
+	/// @param n first frame in the block
+	/// @param val input amplitude values
+	/// @param frames number of values
+	void FxInBlock(int n, AmpValue *val, int frames)
+	{
+		AmpValue *bp = &blk[n];
+		while (--frames >= 0)
+			*bp++ += *val++;
+	}
+
+	/// Move the block input for one frame to the accumulator.
+	/// @param n frame in the block
+	void Load(int n)
+	{
+		value += blk[n];
+		blk[n] = 0;
 	}
 
 	/// Effects in from input channel.
@@ -200,6 +260,49 @@ public:
 		value = 0;
 	}
 
+	/// Send a block of input channel levels to the effects unit.
+	/// The values are added to the block buffer.
+	/// @param lvl send level for the input channel
+	/// @param val input channel values
+	/// @param frames number of values
+	void FxSendBlock(AmpValue lvl, AmpValue *val, int frames)
+	{
+		AmpValue *bp = blk;
+		for (int i = 0; i < frames; i++)
+			bp[i] += lvl * val[i];
+	}
+
+	/// Effects output for a block. The block buffer is processed
+	/// by the effects unit and added to the output with panning.
+	/// The block buffer is cleared.
+	/// @param lft left output values
+	/// @param rgt right output values
+	/// @param tmp buffer for effects output
+	/// @param frames number of frames
+	void FxOutBlock(AmpValue *lft, AmpValue *rgt, AmpValue *tmp, int frames)
+	{
+		if (fx)
+		{
+			blk[0] += value;
+			SampleBlock sb;
+			sb.size = frames;
+			sb.in = blk;
+			sb.out = tmp;
+			fx->Samples(&sb);
+			AmpValue pl = pan.panlft;
+			AmpValue pr = pan.panrgt;
+			AmpValue mx = fxmix;
+			for (int i = 0; i < frames; i++)
+			{
+				AmpValue out = tmp[i] * mx;
+				lft[i] += out * pl;
+				rgt[i] += out * pr;
+			}
+		}
+		value = 0;
+		memset(blk, 0, frames*sizeof(AmpValue));
+	}
+
 	/// Effects initialization.
 	/// @param p generator unit (e.g., reverb, chorus)
 	/// @param ch number of input channel
@@ -264,9 +367,11 @@ public:
 	}
 
 	/// Clear the effects unit to zero.
-	void Clear()
+	void Clear(int frames = 0)
 	{
 		value = 0;
+		if (blk)
+			memset(blk, 0, frames*sizeof(AmpValue));
 		if (fx)
 			fx->Reset();
 	}
@@ -305,19 +410,55 @@ private:
 	AmpValue right;
 	AmpValue volume;
 	AmpValue panset;
+	AmpValue *lblk;
+	AmpValue *rblk;
 	Panner pan;
 	int   method;
 	int   on;
+	int   used;
 
 public:
 	MixChannel()
 	{
 		volume = 0.5;
 		on = false;
+		used = 0;
 		left = 0;
 		right = 0;
 		panset = 0;
 		method = 0;
+		lblk = 0;
+		rblk = 0;
+	}
+
+	~MixChannel()
+	{
+		delete[] lblk;
+	}
+
+	/// Set the synthesis context used for panning.
+	void SetContext(SynthContext *c)
+	{
+		pan.SetContext(c);
+	}
+
+	/// Set the block length.
+	/// When a block length is set, input can be placed
+	/// at any frame in the block and is moved to the
+	/// accumulator by Load(). A length of zero discards
+	/// the block buffer.
+	/// @param frames maximum frames in a block
+	void SetBlockLength(int frames)
+	{
+		delete[] lblk;
+		lblk = 0;
+		rblk = 0;
+		if (frames > 0)
+		{
+			lblk = new AmpValue[frames*2];
+			memset(lblk, 0, frames*2*sizeof(AmpValue));
+			rblk = &lblk[frames];
+		}
 	}
 
 	/// Set channel on/off
@@ -382,6 +523,74 @@ public:
 		right += rgt;
 	}
 
+	/// Add a value to the block buffer.
+	/// Panning is applied here.
+	/// @param n frame in the block
+	/// @param val sample value
+	void InAt(int n, AmpValue val)
+	{
+		used = 1;
+		lblk[n] += val * pan.panlft;
+		rblk[n] += val * pan.panrgt;
+	}
+
+	/// Add a value to the block buffer directly.
+	/// @param n frame in the block
+	/// @param lft left amplitude value
+	/// @param rgt right amplitude value
+	void In2At(int n, AmpValue lft, AmpValue rgt)
+	{
+		used = 1;
+		lblk[n] += lft;
+		rblk[n] += rgt;
+	}
+
+	/// Add a run of values to the block buffer.
+	/// Panning is applied here.
+	/// @param n first frame in the block
+	/// @param val sample values
+	/// @param frames number of values
+	void InBlock(int n, AmpValue *val, int frames)
+	{
+		AmpValue *lp = &lblk[n];
+		AmpValue *rp = &rblk[n];
+		AmpValue pl = pan.panlft;
+		AmpValue pr = pan.panrgt;
+		used = 1;
+		for (int i = 0; i < frames; i++)
+		{
+			lp[i] += val[i] * pl;
+			rp[i] += val[i] * pr;
+		}
+	}
+
+	/// Add a run of values to the block buffer directly.
+	/// @param n first frame in the block
+	/// @param lft left amplitude values
+	/// @param rgt right amplitude values
+	/// @param frames number of values
+	void In2Block(int n, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		AmpValue *lp = &lblk[n];
+		AmpValue *rp = &rblk[n];
+		used = 1;
+		for (int i = 0; i < frames; i++)
+		{
+			lp[i] += lft[i];
+			rp[i] += rgt[i];
+		}
+	}
+
+	/// Move the block input for one frame to the accumulator.
+	/// @param n frame in the block
+	void Load(int n)
+	{
+		left += lblk[n];
+		right += rblk[n];
+		lblk[n] = 0;
+		rblk[n] = 0;
+	}
+
 	/// Get the current level as monophonic value
 	AmpValue Level()
 	{
@@ -400,11 +609,82 @@ public:
 		right = 0;
 	}
 
+	/// Test for block input since the last OutBlock().
+	int IsUsed()
+	{
+		return used;
+	}
+
+	/// Get the level for a block as monophonic values.
+	/// @param lvl output values
+	/// @param frames number of frames
+	void LevelBlock(AmpValue *lvl, int frames)
+	{
+		AmpValue v = volume;
+		for (int i = 0; i < frames; i++)
+			lvl[i] = (lblk[i] + rblk[i]) * v;
+	}
+
+	/// Add the block to the output and clear the block buffer.
+	/// @param lval left output values
+	/// @param rval right output values
+	/// @param frames number of frames
+	void OutBlock(AmpValue *lval, AmpValue *rval, int frames)
+	{
+		AmpValue v = volume;
+		for (int i = 0; i < frames; i++)
+		{
+			lval[i] += lblk[i] * v;
+			rval[i] += rblk[i] * v;
+		}
+		memset(lblk, 0, frames*sizeof(AmpValue));
+		memset(rblk, 0, frames*sizeof(AmpValue));
+		used = 0;
+	}
+
+	/// Add the output for input held apart from the channel.
+	/// This produces the values OutBlock() would for the same
+	/// input, without using the block buffer. It is used to
+	/// render the dry output of a MixBus as a stem.
+	/// @param mono mono input values, or null
+	/// @param lft direct left input values, or null
+	/// @param rgt direct right input values, or null if lft is null
+	/// @param lval left output values
+	/// @param rval right output values
+	/// @param frames number of frames
+	void StemBlock(const AmpValue *mono, const AmpValue *lft, const AmpValue *rgt,
+	               AmpValue *lval, AmpValue *rval, int frames)
+	{
+		AmpValue v = volume;
+		int i;
+		if (mono)
+		{
+			AmpValue pl = pan.panlft;
+			AmpValue pr = pan.panrgt;
+			for (i = 0; i < frames; i++)
+			{
+				lval[i] += (mono[i] * pl) * v;
+				rval[i] += (mono[i] * pr) * v;
+			}
+		}
+		if (lft)
+		{
+			for (i = 0; i < frames; i++)
+			{
+				lval[i] += lft[i] * v;
+				rval[i] += rgt[i] * v;
+			}
+		}
+	}
+
 	/// Clear the input buffer to zero.
-	void Clear()
+	void Clear(int frames = 0)
 	{
+		used = 0;
 		left = 0;
 		right = 0;
+		if (lblk)
+			memset(lblk, 0, frames*2*sizeof(AmpValue));
 	}
 };
 
@@ -425,6 +705,14 @@ public:
 /// get the final output samples. The Out method combines inputs
 /// and applies Fx units, before applying the final master output
 /// level. 
+///
+/// For block rendering, SetBlockLength() allocates a buffer with
+/// one slot per frame on each input and effects channel. Inputs
+/// are then placed at the frame selected by SetBlockPos(), or
+/// a run of frames starting at that position can be added with
+/// ChannelInBlock(). Each call to Out() mixes the frame at the
+/// current block position. Channel volume, pan and send levels
+/// are applied as they are set when the frame is mixed.
 ///////////////////////////////////////////////////////////////
 class Mixer
 {
@@ -437,10 +725,18 @@ private:
 	AmpValue rvol;
 	AmpValue lpeak;
 	AmpValue rpeak;
+	int blkLen;
+	int blkPos;
+	AmpValue *blkTmp;  // channel level and fx output for OutBlock
+	SynthContext *ctx;
 
 public:
 	Mixer()
 	{
+		ctx = SynthContext::Current();
+		blkTmp = 0;
+		blkLen = 0;
+		blkPos = 0;
 		mixInputs = 0;
 		fxUnits = 0;
 		lvol = 1.0;
@@ -457,6 +753,27 @@ public:
 			delete[] inBuf;
 		if (fxBuf)
 			delete[] fxBuf;
+		delete[] blkTmp;
+	}
+
+	/// Set the synthesis context.
+	/// The context is normally the one current when the mixer is constructed.
+	/// Channels allocated later use the same context.
+	/// @param c synthesis context
+	void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		int n;
+		for (n = 0; n < mixInputs; n++)
+			inBuf[n].SetContext(c);
+		for (n = 0; n < fxUnits; n++)
+			fxBuf[n].SetContext(c);
+	}
+
+	/// Get the synthesis context.
+	SynthContext *GetContext()
+	{
+		return ctx;
 	}
 
 	/// Set the master volume values.
@@ -468,6 +785,15 @@ public:
 		rvol = rv;
 	}
 
+	/// Get the master volume values.
+	/// @param lv left channel output volume
+	/// @param rv right channel output volume
+	void GetMasterVolume(AmpValue& lv, AmpValue& rv)
+	{
+		lv = lvol;
+		rv = rvol;
+	}
+
 	/// Set the number of channels.
 	/// This must be called before the mixer is put into use.
 	/// Calling this again clears the old buffers.
@@ -482,7 +808,15 @@ public:
 		}
 		mixInputs = nchnl;
 		if (nchnl > 0)
+		{
 			inBuf = new MixChannel[nchnl];
+			for (int n = 0; n < nchnl; n++)
+			{
+				inBuf[n].SetContext(ctx);
+				if (blkLen > 0)
+					inBuf[n].SetBlockLength(blkLen);
+			}
+		}
 	}
 
 	/// Get the number of input channels.
@@ -525,7 +859,10 @@ public:
 	void ChannelIn(int ch, AmpValue val)
 	{
 		// warning - no runtime range check here...
-		inBuf[ch].In(val);
+		if (blkLen)
+			inBuf[ch].InAt(blkPos, val);
+		else
+			inBuf[ch].In(val);
 	}
 
 	/// Send a sample to an input channel, direct.
@@ -536,7 +873,33 @@ public:
 	void ChannelIn2(int ch, AmpValue lft, AmpValue rgt)
 	{
 		// warning - no runtime range check here...
-		inBuf[ch].In2(lft, rgt);
+		if (blkLen)
+			inBuf[ch].In2At(blkPos, lft, rgt);
+		else
+			inBuf[ch].In2(lft, rgt);
+	}
+
+	/// Send a run of samples to an input channel.
+	/// Values are added to the block starting at the
+	/// current block position. Block input must be
+	/// enabled with SetBlockLength().
+	/// @param ch channel number
+	/// @param val sample amplitude values
+	/// @param frames number of samples
+	void ChannelInBlock(int ch, AmpValue *val, int frames)
+	{
+		inBuf[ch].InBlock(blkPos, val, frames);
+	}
+
+	/// Send a run of samples to an input channel, direct.
+	/// This bypasses channel panning.
+	/// @param ch channel number
+	/// @param lft left sample amplitude values
+	/// @param rgt right sample amplitude values
+	/// @param frames number of samples
+	void ChannelIn2Block(int ch, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		inBuf[ch].In2Block(blkPos, lft, rgt, frames);
 	}
 
 	/// Set the number of effects channels.
@@ -552,7 +915,58 @@ public:
 		}
 		fxUnits = n;
 		if (n > 0)
+		{
 			fxBuf = new FxChannel[n];
+			for (int f = 0; f < n; f++)
+			{
+				fxBuf[f].SetContext(ctx);
+				if (blkLen > 0)
+					fxBuf[f].SetBlockLength(blkLen);
+			}
+		}
+	}
+
+	/// Set the block length.
+	/// A non-zero length enables block input. Input values
+	/// are stored at the current block position and mixed
+	/// when Out() is called for that position.
+	/// Setting the length to zero returns to immediate input.
+	/// @param frames maximum number of frames in a block
+	void SetBlockLength(int frames)
+	{
+		if (frames < 0)
+			frames = 0;
+		blkLen = frames;
+		blkPos = 0;
+		delete[] blkTmp;
+		blkTmp = 0;
+		if (frames > 0)
+			blkTmp = new AmpValue[frames];
+		int n;
+		for (n = 0; n < mixInputs; n++)
+			inBuf[n].SetBlockLength(frames);
+		for (n = 0; n < fxUnits; n++)
+			fxBuf[n].SetBlockLength(frames);
+	}
+
+	/// Get the block length
+	int GetBlockLength()
+	{
+		return blkLen;
+	}
+
+	/// Set the block position.
+	/// Subsequent input and output is applied to this frame.
+	/// @param n frame in the block
+	void SetBlockPos(int n)
+	{
+		blkPos = n;
+	}
+
+	/// Get the block position.
+	int GetBlockPos()
+	{
+		return blkPos;
 	}
 
 	/// Get the number of effects channels.
@@ -610,7 +1024,24 @@ public:
 	void FxIn(int f, AmpValue val)
 	{
 		if (f >= 0 && f < fxUnits)
-			fxBuf[f].FxIn(val);
+		{
+			if (blkLen)
+				fxBuf[f].FxInAt(blkPos, val);
+			else
+				fxBuf[f].FxIn(val);
+		}
+	}
+
+	/// Effects input direct for a run of samples.
+	/// Values are added to the block starting at the
+	/// current block position.
+	/// @param f effects channel
+	/// @param val sample values
+	/// @param frames number of samples
+	void FxInBlock(int f, AmpValue *val, int frames)
+	{
+		if (f >= 0 && f < fxUnits)
+			fxBuf[f].FxInBlock(blkPos, val, frames);
 	}
 
 	/// Get the mixed output.
@@ -625,11 +1056,19 @@ public:
 		AmpValue rvalOut = 0;
 		FxChannel *fx, *fxe;
 		MixChannel *pin = inBuf;
+		// Pick up direct fx input for this frame.
+		if (blkLen)
+		{
+			for (n = 0; n < fxUnits; n++)
+				fxBuf[n].Load(blkPos);
+		}
 		// Add inputs and send to fx units.
 		for (n = 0; n < mixInputs; n++)
 		{
 			if (pin->IsOn())
 			{
+				if (blkLen)
+					pin->Load(blkPos);
 				if ((fx = fxBuf) != 0)
 				{
 					AmpValue lvl = pin->Level();
@@ -664,6 +1103,67 @@ public:
 			rpeak = *rval;
 	}
 
+	/// Get the mixed output for a block.
+	/// This produces the same values as calling Out() for
+	/// each frame, but works on one channel at a time. Channels
+	/// that received no input in the block are skipped, as are
+	/// effects sends set to zero. Block input must be
+	/// enabled with SetBlockLength().
+	/// @param lval left output values
+	/// @param rval right output values
+	/// @param frames number of frames, no more than the block length
+	void OutBlock(AmpValue *lval, AmpValue *rval, int frames)
+	{
+		int n, f;
+		memset(lval, 0, frames*sizeof(AmpValue));
+		memset(rval, 0, frames*sizeof(AmpValue));
+
+		// Add inputs and send to fx units.
+		MixChannel *pin = inBuf;
+		for (n = 0; n < mixInputs; n++, pin++)
+		{
+			if (!pin->IsOn() || !pin->IsUsed())
+				continue;
+			int lvlSet = 0;
+			for (f = 0; f < fxUnits; f++)
+			{
+				FxChannel *fx = &fxBuf[f];
+				if (fx->fxlvl && fx->fxlvl[n] != 0)
+				{
+					if (!lvlSet)
+					{
+						pin->LevelBlock(blkTmp, frames);
+						lvlSet = 1;
+					}
+					fx->FxSendBlock(fx->fxlvl[n], blkTmp, frames);
+				}
+			}
+			pin->OutBlock(lval, rval, frames);
+		}
+
+		// Add outputs from fx units
+		for (f = 0; f < fxUnits; f++)
+			fxBuf[f].FxOutBlock(lval, rval, blkTmp, frames);
+
+		AmpValue lv = lvol;
+		AmpValue rv = rvol;
+		AmpValue lpk = lpeak;
+		AmpValue rpk = rpeak;
+		for (n = 0; n < frames; n++)
+		{
+			AmpValue l = lval[n] * lv;
+			AmpValue r = rval[n] * rv;
+			lval[n] = l;
+			rval[n] = r;
+			if (l > lpk)
+				lpk = l;
+			if (r > rpk)
+				rpk = r;
+		}
+		lpeak = lpk;
+		rpeak = rpk;
+	}
+
 	/// Get the peak value.
 	/// The peak value is reset to zero
 	/// @param lval left channel peak
@@ -682,9 +1182,9 @@ public:
 	{
 		int n;
 		for (n = 0; n < mixInputs; n++)
-			inBuf[n].Clear();
+			inBuf[n].Clear(blkLen);
 		for (n = 0; n < fxUnits; n++)
-			fxBuf[n].Clear();
+			fxBuf[n].Clear(blkLen);
 		lpeak = 0.0;
 		rpeak = 0.0;
 	}
@@ -712,5 +1212,301 @@ public:
 		return 0;
 	}
 };
+///////////////////////////////////////////////////////////////
+/// Private accumulator for instrument output.
+///
+/// A MixBus holds block buffers for a group of instruments
+/// rendered apart from the mixer, e.g. on a worker thread.
+/// Values are kept per input channel and effects unit in the
+/// form the instrument sent them: mono values to be panned by the
+/// channel, direct left/right values, and effects sends.
+/// The owner later passes the buffers on to the mixer, and
+/// Clear() readies the bus for the next block. Buffers are
+/// allocated on first use of a channel and flagged when used,
+/// so only channels that received a value are passed on and
+/// cleared. StemBlock() gives the dry stereo output of the
+/// bus, e.g. to write the voices of one track to a file.
+///
+/// While rendering, the bus is made current on the rendering
+/// thread with MakeCurrent(). The instrument manager checks
+/// for a current bus and redirects output to it.
+///////////////////////////////////////////////////////////////
+class MixBus
+{
+private:
+	int blkLen;
+	int blkPos;
+	int chnls;
+	int fxUnits;
+	AmpValue **chBuf;  // per channel: mono, left, right
+	AmpValue **fxBuf;  // per effects unit
+	bsInt16 *chUsed;   // 1 = mono used, 2 = direct used
+	bsInt16 *fxUsed;
+
+	// Get the buffer for index n, allocating as needed.
+	// Each buffer holds parts*blkLen values.
+	AmpValue *Buf(AmpValue **&tbl, bsInt16 *&used, int &count, int n, int parts)
+	{
+		if (n >= count)
+		{
+			int newCount = n + 4;
+			AmpValue **newTbl = new AmpValue*[newCount];
+			bsInt16 *newUsed = new bsInt16[newCount];
+			int i;
+			for (i = 0; i < count; i++)
+			{
+				newTbl[i] = tbl[i];
+				newUsed[i] = used[i];
+			}
+			while (i < newCount)
+			{
+				newTbl[i] = 0;
+				newUsed[i++] = 0;
+			}
+			delete[] tbl;
+			delete[] used;
+			tbl = newTbl;
+			used = newUsed;
+			count = newCount;
+		}
+		AmpValue *bp = tbl[n];
+		if (bp == 0)
+		{
+			bp = new AmpValue[blkLen*parts];
+			memset(bp, 0, blkLen*parts*sizeof(AmpValue));
+			tbl[n] = bp;
+		}
+		return bp;
+	}
+
+	void Free(AmpValue **&tbl, bsInt16 *&used, int &count)
+	{
+		for (int n = 0; n < count; n++)
+			delete[] tbl[n];
+		delete[] tbl;
+		delete[] used;
+		tbl = 0;
+		used = 0;
+		count = 0;
+	}
+
+	inline AmpValue *Chnl(int ch, int part)
+	{
+		AmpValue *bp = Buf(chBuf, chUsed, chnls, ch, 3);
+		chUsed[ch] |= part;
+		return bp;
+	}
+
+	inline AmpValue *Fx(int f)
+	{
+		AmpValue *bp = Buf(fxBuf, fxUsed, fxUnits, f, 1);
+		fxUsed[f] = 1;
+		return bp;
+	}
+
+public:
+	MixBus()
+	{
+		blkLen = 0;
+		blkPos = 0;
+		chnls = 0;
+		fxUnits = 0;
+		chBuf = 0;
+		fxBuf = 0;
+		chUsed = 0;
+		fxUsed = 0;
+	}
+
+	~MixBus()
+	{
+		SetBlockLength(0);
+	}
+
+	/// Get the bus current on this thread.
+	/// @return current bus or null
+	static MixBus *Current();
+
+	/// Make a bus current on this thread.
+	/// @param bus the bus to receive output, or null to restore mixer output
+	/// @return previous bus
+	static MixBus *MakeCurrent(MixBus *bus);
+
+	/// Set the block length.
+	/// This discards all buffers.
+	/// @param frames maximum frames in a block
+	void SetBlockLength(int frames)
+	{
+		Free(chBuf, chUsed, chnls);
+		Free(fxBuf, fxUsed, fxUnits);
+		blkLen = frames;
+		blkPos = 0;
+	}
+
+	/// Get the block length.
+	inline int GetBlockLength() { return blkLen; }
+
+	/// Set the position in the block for output.
+	/// @param n frame in the block
+	inline void SetBlockPos(int n) { blkPos = n; }
+
+	/// Get the position in the block for output.
+	inline int GetBlockPos() { return blkPos; }
+
+	/// Get the number of channel slots.
+	/// Only channels below this value can have values.
+	inline int GetChannels() { return chnls; }
+
+	/// Get the number of effects unit slots.
+	inline int GetFxUnits() { return fxUnits; }
+
+	/// Get the mono input for a channel.
+	/// @param ch channel number
+	/// @return block buffer or null if unused in this block
+	inline AmpValue *GetMono(int ch)
+	{
+		return (chUsed[ch] & 1) ? chBuf[ch] : 0;
+	}
+
+	/// Get the direct input for a channel.
+	/// Right channel values follow the left at GetBlockLength().
+	/// @param ch channel number
+	/// @return block buffer or null if unused in this block
+	inline AmpValue *GetDirect(int ch)
+	{
+		return (chUsed[ch] & 2) ? chBuf[ch] + blkLen : 0;
+	}
+
+	/// Get the effects send for a unit.
+	/// @param f effects unit number
+	/// @return block buffer or null if unused in this block
+	inline AmpValue *GetFx(int f)
+	{
+		return fxUsed[f] ? fxBuf[f] : 0;
+	}
+
+	/// Add a value at the current block position.
+	/// @param ch channel number
+	/// @param val sample value
+	void In(int ch, AmpValue val)
+	{
+		Chnl(ch, 1)[blkPos] += val;
+	}
+
+	/// Add a direct value at the current block position.
+	/// @param ch channel number
+	/// @param lft left sample value
+	/// @param rgt right sample value
+	void In2(int ch, AmpValue lft, AmpValue rgt)
+	{
+		AmpValue *bp = Chnl(ch, 2) + blkLen + blkPos;
+		bp[0] += lft;
+		bp[blkLen] += rgt;
+	}
+
+	/// Add a run of values starting at the current block position.
+	/// @param ch channel number
+	/// @param val sample values
+	/// @param frames number of values
+	void InBlock(int ch, AmpValue *val, int frames)
+	{
+		AmpValue *bp = Chnl(ch, 1) + blkPos;
+		for (int i = 0; i < frames; i++)
+			bp[i] += val[i];
+	}
+
+	/// Add a run of direct values starting at the current block position.
+	/// @param ch channel number
+	/// @param lft left sample values
+	/// @param rgt right sample values
+	/// @param frames number of values
+	void In2Block(int ch, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		AmpValue *lp = Chnl(ch, 2) + blkLen + blkPos;
+		AmpValue *rp = lp + blkLen;
+		for (int i = 0; i < frames; i++)
+		{
+			lp[i] += lft[i];
+			rp[i] += rgt[i];
+		}
+	}
+
+	/// Add an effects send at the current block position.
+	/// @param f effects unit number
+	/// @param val sample value
+	void FxIn(int f, AmpValue val)
+	{
+		Fx(f)[blkPos] += val;
+	}
+
+	/// Add a run of effects sends starting at the current block position.
+	/// @param f effects unit number
+	/// @param val sample values
+	/// @param frames number of values
+	void FxInBlock(int f, AmpValue *val, int frames)
+	{
+		AmpValue *bp = Fx(f) + blkPos;
+		for (int i = 0; i < frames; i++)
+			bp[i] += val[i];
+	}
+
+	/// Get the dry output of the bus.
+	/// Channel input is passed through the volume and panning
+	/// of the mixer channel and the master volume, the same as
+	/// the mixer would, but the effects are not applied.
+	/// Channels that are off produce no output.
+	/// @param mix the mixer that holds the channel settings
+	/// @param lval left output values
+	/// @param rval right output values
+	/// @param frames number of frames
+	void StemBlock(Mixer *mix, AmpValue *lval, AmpValue *rval, int frames)
+	{
+		memset(lval, 0, frames*sizeof(AmpValue));
+		memset(rval, 0, frames*sizeof(AmpValue));
+		int mixChnls = mix->GetChannels();
+		int n;
+		for (n = 0; n < chnls && n < mixChnls; n++)
+		{
+			if (chUsed[n] == 0)
+				continue;
+			MixChannel *pin = mix->GetChannelPtr(n);
+			if (!pin->IsOn())
+				continue;
+			AmpValue *lft = GetDirect(n);
+			pin->StemBlock(GetMono(n), lft, lft ? lft + blkLen : 0, lval, rval, frames);
+		}
+		AmpValue lv, rv;
+		mix->GetMasterVolume(lv, rv);
+		for (n = 0; n < frames; n++)
+		{
+			lval[n] *= lv;
+			rval[n] *= rv;
+		}
+	}
+
+	/// Clear the buffers used in this block.
+	/// @param frames number of frames used in the block
+	void Clear(int frames)
+	{
+		int n;
+		for (n = 0; n < chnls; n++)
+		{
+			if (chUsed[n] & 1)
+				memset(chBuf[n], 0, frames*sizeof(AmpValue));
+			if (chUsed[n] & 2)
+			{
+				memset(chBuf[n]+blkLen, 0, frames*sizeof(AmpValue));
+				memset(chBuf[n]+blkLen*2, 0, frames*sizeof(AmpValue));
+			}
+			chUsed[n] = 0;
+		}
+		for (n = 0; n < fxUnits; n++)
+		{
+			if (fxUsed[n])
+				memset(fxBuf[n], 0, frames*sizeof(AmpValue));
+			fxUsed[n] = 0;
+		}
+		blkPos = 0;
+	}
+};
 //@}
 #endif
@@ -5,6 +5,7 @@
 //
 // Reverb1 - Single resonator with LP filter
 // Reverb2 - Schroeder type reverb unit
+// ReverbIR - Convolution reverb
 //
 // Copyright 2008, Daniel R. Mitchell
 // License: Creative Commons/GNU-GPL 
@@ -17,6 +18,8 @@
 #define _REVERB_H_
 
 //#include "DelayLine.h"
+#include "Convolve.h"
+#include "WaveFile.h"
 
 /// Single resonator reverb.
 /// Includes a LP filter in the feedback loop.
@@ -66,6 +69,12 @@ public:
 			delayPos = delayBuf;
 		return out;
 	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		GenUnit::Samples(block);
+	}
 };
 
 /// Schroeder reverb.
@@ -82,6 +91,16 @@ public:
 		atten = 1.0;
 	}
 
+	/// @copydoc GenUnit::SetContext
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+		for (int n = 0; n < 4; n++)
+			dlr[n].SetContext(c);
+		ap[0].SetContext(c);
+		ap[1].SetContext(c);
+	}
+
 	/// Initialize the reverb.
 	/// @param n number of values (2)
 	/// @param v values, v[0] = atten v[1] = RT
@@ -163,5 +182,137 @@ public:
 	}
 };
 
+/// Convolution reverb.
+/// The input is convolved with the impulse response of a room,
+/// usually recorded or calculated and stored in a WAV file.
+/// Convolution uses the partitioned FFT method (ConvolveFFT) so that
+/// responses several seconds long can be used without latency.
+/// Like the other reverb units, only the reverberated signal is
+/// returned and the mix with the dry signal is set by the caller, usually
+/// as the FxChannel output level in the Mixer.
+class ReverbIR : public GenUnit
+{
+private:
+	ConvolveFFT cnv;
+	AmpValue atten;
+public:
+	ReverbIR()
+	{
+		atten = 1.0;
+	}
+
+	/// Initialize the reverb.
+	/// The impulse response must be set with InitReverb() or LoadImpulse().
+	/// @param n number of values (1)
+	/// @param v values, v[0] = atten
+	void Init(int n, float *v)
+	{
+		if (n > 0)
+			atten = AmpValue(v[0]);
+	}
+
+	/// Reset the reverb.
+	/// Clears the input history to zero.
+	/// @param initPhs not used
+	void Reset(float initPhs = 0)
+	{
+		cnv.Reset();
+	}
+
+	/// Initialize the reverb from an impulse response.
+	/// The impulse response is used as given.
+	/// @param a attenuation value for input
+	/// @param imp impulse response samples
+	/// @param len number of samples
+	/// @return 0 on success, -1 on error
+	int InitReverb(AmpValue a, const AmpValue *imp, bsInt32 len)
+	{
+		atten = a;
+		if (cnv.InitConvolve(len) != 0)
+			return -1;
+		cnv.SetImpulse(imp);
+		return 0;
+	}
+
+	/// Load the impulse response from a WAV file.
+	/// Stereo files are mixed to one channel.
+	/// When the file sample rate is different from the context
+	/// sample rate, the response is resampled with linear interpolation.
+	/// The response is normalized to unit energy so that the level
+	/// of the reverb is similar for different files.
+	/// @param fname path to the WAV file
+	/// @param a attenuation value for input
+	/// @param maxtm maximum length in seconds, 0 for the whole file
+	/// @return 0 on success, negative on error
+	int LoadImpulse(const char *fname, AmpValue a = 1.0, FrqValue maxtm = 0)
+	{
+		WaveFileIn wf;
+		int err = wf.LoadWaveFile(fname, 0);
+		if (err != 0)
+			return err;
+		AmpValue *src = wf.GetSampleBuffer();
+		bsInt32 srcLen = (bsInt32) wf.GetInputLength();
+		bsInt32 srcRate = wf.GetSampleRate();
+		if (src == 0 || srcLen <= 0 || srcRate <= 0)
+			return -1;
+
+		double step = (double) srcRate / (double) ctx->sampleRate;
+		bsInt32 len = (bsInt32) ((double) srcLen / step);
+		if (maxtm > 0 && len > (bsInt32) (maxtm * ctx->sampleRate))
+			len = (bsInt32) (maxtm * ctx->sampleRate);
+		if (len <= 0)
+			return -1;
+
+		AmpValue *imp = new AmpValue[len];
+		double energy = 0;
+		double pos = 0;
+		for (bsInt32 n = 0; n < len; n++)
+		{
+			bsInt32 ndx = (bsInt32) pos;
+			AmpValue v = src[ndx];
+			if (ndx + 1 < srcLen)
+				v += (src[ndx+1] - v) * AmpValue(pos - (double) ndx);
+			imp[n] = v;
+			energy += (double) v * (double) v;
+			pos += step;
+		}
+		if (energy > 0)
+		{
+			AmpValue scl = AmpValue(1.0 / sqrt(energy));
+			for (bsInt32 n = 0; n < len; n++)
+				imp[n] *= scl;
+		}
+		err = InitReverb(a, imp, len);
+		delete[] imp;
+		return err;
+	}
+
+	/// Process the current sample.
+	/// The input value is passed to the reverb.
+	/// The reverberated sample is returned.
+	/// @param vin current sample
+	AmpValue Sample(AmpValue vin)
+	{
+		if (cnv.GetLength() == 0)
+			return 0;
+		return cnv.Sample(vin * atten);
+	}
+
+	/// @copydoc GenUnit::Samples()
+	virtual void Samples(SampleBlock *block)
+	{
+		int n = block->size;
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		if (cnv.GetLength() == 0)
+		{
+			memset(out, 0, n*sizeof(AmpValue));
+			return;
+		}
+		while (--n >= 0)
+			*out++ = cnv.Sample(*in++ * atten);
+	}
+};
+
 //@}
 #endif
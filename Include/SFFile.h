@@ -50,6 +50,7 @@ public:
 	sfSample *shdr;
 
 	int preload;
+	int mapped;
 
 	FileReadBuf file;
 	SoundBank *sfbnk;
@@ -114,9 +115,13 @@ public:
 	/// it is better to load each instrument's sample data explicitly.
 	/// The caller is responsible for deleteing the returned object.
 	/// @param fname path to the file
+	/// When map is true, sample data is used in place from a
+	/// read-only mapping of the file (@sa SoundBank::MapSample).
+	/// @param fname path to the file
 	/// @param pre preload all samples
+	/// @param map map the sample data
 	/// @returns pointer to SoundBank object.
-	SoundBank *LoadSoundBank(const char *fname, int pre = 1);
+	SoundBank *LoadSoundBank(const char *fname, int pre = 1, int map = 0);
 };
 //@}
 #endif
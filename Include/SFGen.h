@@ -17,9 +17,22 @@
 #define SFGEN_H
 
 /// Oscillator that initializes directly from a SBZone.
+/// Samples kept in 16-bit or 24-bit form are converted
+/// to AmpValue as they are interpolated.
 class GenWaveSB : public GenWaveWTLoop
 {
+protected:
+	bsInt16 *wave16;  ///< 16-bit samples (or high 16 bits of 24)
+	bsUint8 *wave8;   ///< low 8 bits of 24-bit samples
+
 public:
+	GenWaveSB()
+	{
+		wavetable = 0;
+		wave16 = 0;
+		wave8 = 0;
+	}
+
 	/// Init the wavetable oscillator.
 	/// @param zone sample information.
 	/// @param pi frequency in phase increment
@@ -29,7 +42,7 @@ public:
 		//frq = fo;
 		phsIncr = pi;
 		recFrq = zone->recFreq;
-		rateRatio = zone->rate / synthParams.sampleRate;
+		rateRatio = zone->rate / ctx->sampleRate;
 		piMult = rateRatio / recFrq; // pre-calculate for Modulate code
 		period = zone->rate / recFrq;
 		phase = (PhsAccum) zone->tableStart;
@@ -41,6 +54,39 @@ public:
 		if (skipAttack && loopMode == 1)
 			phase = loopStart;
 		wavetable = zone->sample->sample;
+		wave16 = zone->sample->sample16;
+		wave8 = zone->sample->sample8;
+	}
+
+	/// Generate the next sample.
+	AmpValue Gen()
+	{
+		if (wavetable)
+			return GenWaveWTLoop::Gen();
+
+		if (phase < 0)
+			phase += period;
+		if (loopMode && phase >= loopEnd)
+			phase -= loopLen;
+		else if (phase >= tableEnd)
+			return 0.0;
+
+		ii = (int) phase;
+		fr = phase - (PhsAccum) ii;
+		phase += phsIncr;
+		AmpValue v1;
+		AmpValue v2;
+		if (wave8)
+		{
+			v1 = (AmpValue) ((bsInt32) wave16[ii] * 256 + wave8[ii]) * (AmpValue) (1.0 / 8388608.0);
+			v2 = (AmpValue) ((bsInt32) wave16[ii+1] * 256 + wave8[ii+1]) * (AmpValue) (1.0 / 8388608.0);
+		}
+		else
+		{
+			v1 = (AmpValue) wave16[ii] * (AmpValue) (1.0 / 32768.0);
+			v2 = (AmpValue) wave16[ii+1] * (AmpValue) (1.0 / 32768.0);
+		}
+		return v1 + ((v2 - v1) * fr);
 	}
 
 	inline void UpdatePhaseIncr(PhsAccum p)
@@ -48,6 +94,81 @@ public:
 		phsIncr = p;
 	}
 
+	/// Generate a block of samples.
+	/// This is GenWaveWTLoop::GenBlock() with the 16-bit
+	/// and 24-bit conversions done inside the span loops.
+	/// @param out output buffer
+	/// @param frames number of samples
+	/// @param incrStep change in phase increment per sample
+	void GenBlock(AmpValue *out, int frames, PhsAccum incrStep = 0)
+	{
+		if (wavetable)
+		{
+			GenWaveWTLoop::GenBlock(out, frames, incrStep);
+			return;
+		}
+
+		while (frames > 0)
+		{
+			int count = SpanCount(frames, incrStep);
+			if (count > 0)
+			{
+				PhsAccum phs = phase;
+				PhsAccum incr = phsIncr;
+				int n;
+				if (wave8)
+				{
+					bsInt16 *w16 = wave16;
+					bsUint8 *w8 = wave8;
+					for (n = 0; n < count; n++)
+					{
+						int ndx = (int) phs;
+						PhsAccum fract = phs - (PhsAccum) ndx;
+						phs += incr;
+						incr += incrStep;
+						AmpValue v1 = (AmpValue) ((bsInt32) w16[ndx] * 256 + w8[ndx]) * (AmpValue) (1.0 / 8388608.0);
+						AmpValue v2 = (AmpValue) ((bsInt32) w16[ndx+1] * 256 + w8[ndx+1]) * (AmpValue) (1.0 / 8388608.0);
+						out[n] = v1 + ((v2 - v1) * fract);
+					}
+				}
+				else
+				{
+					bsInt16 *w16 = wave16;
+					for (n = 0; n < count; n++)
+					{
+						int ndx = (int) phs;
+						PhsAccum fract = phs - (PhsAccum) ndx;
+						phs += incr;
+						incr += incrStep;
+						AmpValue v1 = (AmpValue) w16[ndx] * (AmpValue) (1.0 / 32768.0);
+						AmpValue v2 = (AmpValue) w16[ndx+1] * (AmpValue) (1.0 / 32768.0);
+						out[n] = v1 + ((v2 - v1) * fract);
+					}
+				}
+				phase = phs;
+				phsIncr = incr;
+				out += count;
+				frames -= count;
+			}
+			else
+			{
+				*out++ = Gen();
+				phsIncr += incrStep;
+				frames--;
+			}
+		}
+	}
+
+	/// @copydoc GenUnit::Samples()
+	void Samples(SampleBlock *block)
+	{
+		AmpValue *in = block->in;
+		AmpValue *out = block->out;
+		int n = block->size;
+		GenBlock(out, n);
+		while (--n >= 0)
+			*out++ *= *in++;
+	}
 };
 
 /// Envelope generator for sound founts.
@@ -104,12 +225,12 @@ public:
 
 	inline void SetDelay(FrqValue rt)
 	{
-		delayCount = (bsInt32) (synthParams.sampleRate * rt);
+		delayCount = (bsInt32) (ctx->sampleRate * rt);
 	}
 
 	inline void SetAttack(FrqValue rt)
 	{
-		FrqValue count = floor(synthParams.sampleRate * rt);
+		FrqValue count = floor(ctx->sampleRate * rt);
 		if (count > 0)
 			atkIncr = 1.0 / count;
 		else
@@ -118,12 +239,12 @@ public:
 
 	inline void SetHold(FrqValue rt)
 	{
-		holdCount = (bsInt32) (synthParams.sampleRate * rt);
+		holdCount = (bsInt32) (ctx->sampleRate * rt);
 	}
 
 	inline void SetDecay(FrqValue rt)
 	{
-		FrqValue count = floor(synthParams.sampleRate * rt);
+		FrqValue count = floor(ctx->sampleRate * rt);
 		if (count > 0)
 			decIncr = 1.0 / count;
 		else
@@ -137,7 +258,7 @@ public:
 
 	inline void SetRelease(FrqValue rt)
 	{
-		FrqValue count = floor(synthParams.sampleRate * rt);
+		FrqValue count = floor(ctx->sampleRate * rt);
 		if (count > 0)
 			relIncr = 1.0 / count;
 		else
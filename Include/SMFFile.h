@@ -48,20 +48,31 @@ public:
 class SMFFile; // forward reference
 
 /// MIDI track.
-/// This is the class that maintains a list of MIDI events.
-/// To produce a playable set of events, the SMFFile class
-/// repeatedly evokes Generate() until the track is finished.
+/// A track holds MIDI events in one of two ways. A track
+/// loaded from a file refers to the track data in the
+/// file mapping and decodes each event as it is needed.
+/// A track built by the program holds a list of MIDIEvent
+/// objects added with AddEvent. To produce a playable set
+/// of events, the SMFFile class merges the tracks by time,
+/// calling Generate for each track at the time of its next event.
 class SMFTrack : public SynthList<SMFTrack>
 {
 public:
 	SMFFile   *smf;
 	MIDIEvent evtHead;
 	MIDIEvent evtTail;
-	MIDIEvent *evtLast;
+	MIDIEvent *evtLast;  ///< current event
+	MIDIEvent evtCur;    ///< event decoded from the track data
+	const bsUint8 *inpBeg;  ///< start of mapped track data, or null
+	const bsUint8 *inpPos;  ///< next byte to decode
+	const bsUint8 *inpEnd;  ///< end of mapped track data
+	const bsUint8 *evtData; ///< data of the decoded META or SYSEX event
+	bsUint32 evtLen;        ///< length of evtData
+	bsUint16 lastMsg;       ///< running status
 	int eot;
 	int trkNum;
 
-	bsUint32 deltaTime;
+	bsUint32 evtTick;    ///< absolute time in MIDI ticks of the current event
 
 	SMFTrack()
 	{
@@ -85,8 +96,14 @@ public:
 		evtTail.deltat = 0;
 		evtTail.mevent = MIDI_META;
 		evtTail.chan  = MIDI_META_EOT;
+		inpBeg = 0;
+		inpPos = 0;
+		inpEnd = 0;
+		evtData = 0;
+		evtLen = 0;
+		lastMsg = 0;
 		eot = 0;
-		deltaTime = 0;
+		evtTick = 0;
 	}
 
 	~SMFTrack()
@@ -98,49 +115,106 @@ public:
 		}
 	}
 
+	/// Set the track data.
+	/// The data must remain valid while the track is used.
+	/// @param data first byte after the MTrk chunk header
+	/// @param len length of the chunk data
+	void SetData(const bsUint8 *data, bsUint32 len)
+	{
+		inpBeg = data;
+		inpPos = data;
+		inpEnd = data + len;
+		lastMsg = 0;
+	}
+
 	/// Add an event to the track.
 	void AddEvent(MIDIEvent *evt)
 	{
-		//deltaTime += evt->deltat;
 		//printf("TRACK(%02d): @%08d (%04d) %02d %02x %3d %3d\n", 
-		//	   trkNum, deltaTime, evt->deltat, evt->chan, evt->mevent, evt->val1, evt->val2);
+		//	   trkNum, evtTick, evt->deltat, evt->chan, evt->mevent, evt->val1, evt->val2);
 		evtTail.InsertBefore(evt);
 	}
 
 	/// Set the delta-time before end-of-track marker.
 	void EOTOffset(bsInt32 deltat)
 	{
-		//printf("TRACK(%02d): @%08d EOT ======================\n", trkNum, deltaTime);
+		//printf("TRACK(%02d): @%08d EOT ======================\n", trkNum, evtTick);
 		// Not really necessary, but might 
 		// be used to extend the track with silence?
 		evtTail.deltat = deltat;
 	}
 
+	/// Decode the next event from the track data.
+	/// The event is stored in evtCur and is replaced by
+	/// the next call. For META and SYSEX events, evtData and
+	/// evtLen locate the event data. For tempo, val3 holds
+	/// the tempo value.
+	/// @returns the event, or null at the end of the data
+	MIDIEvent *ReadEvent();
+
+	/// Get the next event after evtLast.
+	MIDIEvent *NextEvent()
+	{
+		if (inpBeg)
+			return ReadEvent();
+		return evtLast->next;
+	}
+
 	/// Start the track.
-	/// We reset the list pointer and deltatime.
+	/// We go to the first event and set its time.
+	/// @returns 0 if the track has no events
 	int Start(SMFFile *p)
 	{
 		smf = p;
-		evtLast = evtHead.next;
-		if (evtLast == &evtTail)
+		evtTick = 0;
+		if (inpBeg)
+		{
+			inpPos = inpBeg;
+			lastMsg = 0;
+			evtLast = ReadEvent();
+		}
+		else
+			evtLast = evtHead.next;
+		if (evtLast == 0 || (evtLast->mevent == MIDI_META && evtLast->chan == MIDI_META_EOT))
 		{
 			eot = true;
-			deltaTime = 0;
 			return 0;
 		}
-		deltaTime = evtLast->deltat;
+		evtTick = evtLast->deltat;
 		eot = false;
 		return 1;
 	}
 
-	/// Generate checks for the next MIDI event and produces
-	/// the appropriate BasicSynth sequencer event. This 
-	/// function simply passes the event back to the SMFFile object
-	/// for processing.
+	/// Generate the events at the current time (evtTick).
+	/// Each MIDI event is passed back to the SMFFile object
+	/// to produce the appropriate BasicSynth sequencer event.
+	/// On return, evtTick is the time of the next event.
+	/// @returns 0 when the end of track is reached
 	int Generate();
 
+	/// Enumerate the events.
+	/// On the first call, set evt = NULL, then
+	/// pass the previous event until the return
+	/// value is NULL. For a track loaded from a file, the
+	/// event is decoded into evtCur and is only valid until
+	/// the next call. Enumerating a loaded track while
+	/// generating a sequence from it is not supported.
+	/// @param evt previous event
+	/// @returns next event, not including end of track
 	MIDIEvent *Enum(MIDIEvent *evt)
 	{
+		if (inpBeg)
+		{
+			if (evt == 0)
+			{
+				inpPos = inpBeg;
+				lastMsg = 0;
+			}
+			evt = ReadEvent();
+			if (evt && evt->mevent == MIDI_META && evt->chan == MIDI_META_EOT)
+				return 0;
+			return evt;
+		}
 		if (evt == 0)
 			evt = &evtHead;
 		evt = evt->next;
@@ -225,13 +299,13 @@ public:
 
 /// Processor for a Standard MIDI format file (SMF a/k/a .mid).
 /// Processing a file is a two step process. The file is first
-/// read into memory and stored as a list of tracks. Each track
-/// maintains a list of raw MIDI events for the track. If desired,
-/// that information can be used to edit the MIDI file. To play
-/// using the BasicSynth sequencer, invoke the Generate method, passing
-/// in the sequencer object and an instrument map. Generate converts
-/// the MIDI events into absolute time events and merges Note ON/OFF
-/// into a single START event with duration.
+/// mapped into memory and divided into tracks. The track
+/// data is read in place; no copy of the events is made.
+/// To play using the BasicSynth sequencer, invoke the GenerateSeq method,
+/// passing in the sequencer object and an instrument map. GenerateSeq
+/// merges the tracks by time, converts the MIDI events into absolute
+/// time events and merges Note ON/OFF into a single START event
+/// with duration.
 ///
 /// The tracks can also be loaded manually. Call AddTrack and then 
 /// add MIDIEvent objects directly to the track. Optionally, use
@@ -246,18 +320,13 @@ public:
 class SMFFile
 {
 protected:
-	FileReadBuf fp;
+	FileMap fmap;
 	MTHDchunk hdr;
 	bsString metaText;
 	bsString metaCpyr;
 	bsString metaSeqName;
 	bsString timeSig;
 	bsString keySig;
-	bsUint8 *inpBuf;
-	bsUint8 *inpPos;
-	bsUint8 *inpEnd;
-	bsUint16 lastMsg;
-	bsUint32 deltaT;
 	double srTicks;
 	double ppqn;
 	FrqValue theTick;
@@ -270,47 +339,32 @@ protected:
 	int gmbank;
 	int explNoteOff;
 
-	/// Process META messages.
-	void MetaEvent();
-	/// Process System common messages.
-	void SysCommon(bsUint16 msg);
-	/// Process channel messages.
-	void ChnlMessage(bsUint16 msg);
+	/// Process META messages found when the file is loaded.
+	void MetaEvent(bsUint16 meta, const bsUint8 *data, bsUint32 len);
+	/// Process System exclusive messages found when the file is loaded.
+	void SysCommon(bsUint16 msg, const bsUint8 *data, bsUint32 len);
 	
 	/// Read a string and append to str
 	/// @param str output string
+	/// @param data characters to read
 	/// @param len length to read
-	void ReadString(bsString& str, bsUint32 len)
+	void ReadString(bsString& str, const bsUint8 *data, bsUint32 len)
 	{
 		while (len-- > 0)
-			str += (long)*inpPos++;
+			str += (long)*data++;
 		str += "\r\n";
 	}
 	
 	/// Read a 4-byte value in a portable manner.
-	bsUint32 ReadLong()
+	bsUint32 ReadLong(const bsUint8 *data)
 	{
-		return ((bsUint32) ReadShort() << 16) + (bsUint32) ReadShort();
+		return ((bsUint32) ReadShort(data) << 16) + (bsUint32) ReadShort(data+2);
 	}
 
 	/// Read a 2-byte value in a portable manner.
-	bsUint16 ReadShort()
+	bsUint16 ReadShort(const bsUint8 *data)
 	{
-		return (bsUint16) (fp.ReadCh() << 8) + fp.ReadCh();
-	}
-
-	/// Read a variable length value.
-	/// MIDI files have values larger than 127 stored as
-	/// a series of 7-bit values. We have to catenate them
-	/// into a long. This function works off of the in-memory
-	/// chunk data.
-	bsUint32 GetVarLen()
-	{
-		bsUint32 value = 0;
-		do
-			value = (value << 7) + (bsUint32) (*inpPos & 0x7F);
-		while (*inpPos++ & 0x80);
-		return value;
+		return (bsUint16) ((data[0] << 8) + data[1]);
 	}
 
 	/// Format an integer into a bsString
@@ -321,15 +375,12 @@ protected:
 		str += (char) ((val % 10) + '0');
 	}
 
-	// Close the input file.
+	// Close the input file. The tracks refer to
+	// the file mapping and are discarded first.
 	void CloseFile()
 	{
-		fp.FileClose();
-		if (inpBuf)
-			delete inpBuf;
-		inpBuf = 0;
-		inpPos = 0;
-		inpEnd = 0;
+		trackList.Clear();
+		fmap.MapClose();
 	}
 
 public:
@@ -441,11 +492,17 @@ public:
 	//@}
 
 	/// Load a SMF file.
+	/// The file stays mapped until the next LoadFile or Reset.
+	/// The META and SYSEX information is available on return.
+	/// Any tracks already loaded are discarded.
 	/// @param file path to file in SMF format.
 	/// @returns 0 on success, -1 file not found or read error, -2 invalid format (SMTPE)
 	int LoadFile(const char *file);
 
 	/// Generate sequencer events from the SMF file.
+	/// The tracks are merged in one pass, taking the events
+	/// with the earliest time next. Events at the same time
+	/// are taken in track order.
 	/// The instrument map is used to locate the entry in the
 	/// instrument manager corresponding to the current patch.
 	/// The optional SoundBank allows loading samples dynamically,
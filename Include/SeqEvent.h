@@ -82,6 +82,7 @@ public:
 	bsInt32 evid;     ///< event ID or reference to earlier event
 	bsInt32 start;    ///< start time in samples
 	bsInt32 duration; ///< duration in samples
+	bsInt32 order;    ///< arrival order of a live event (see Sequencer::AddImmediate)
 	InstrConfig *im;  ///< instrument object
 
 	SeqEvent()
@@ -93,6 +94,7 @@ public:
 		chnl = 0;
 		start = 0;
 		duration = 0;
+		order = 0;
 		im = 0;
 	}
 
@@ -134,10 +136,10 @@ public:
 			SetChannel((bsInt16) v);
 			break;
 		case P_START: // in seconds
-			SetStart((bsInt32) (synthParams.sampleRate * v));
+			SetStart((bsInt32) (SynthContext::Current()->sampleRate * v));
 			break;
 		case P_DUR: // in seconds
-			SetDuration((bsInt32) (synthParams.sampleRate * v));
+			SetDuration((bsInt32) (SynthContext::Current()->sampleRate * v));
 			break;
 		}
 	}
@@ -163,9 +165,9 @@ public:
 		case P_CHNL:
 			return (float) chnl;
 		case P_START:
-			return (float) start / synthParams.sampleRate;
+			return (float) start / SynthContext::Current()->sampleRate;
 		case P_DUR:
-			return (float) duration / synthParams.sampleRate;
+			return (float) duration / SynthContext::Current()->sampleRate;
 		}
 		return 0;
 	}
@@ -239,7 +241,7 @@ public:
 	virtual void SetFrequency(FrqValue f) { frq = f; }
 	virtual void SetPitch(bsInt16 p) 
 	{
-		SetFrequency(synthParams.GetFrequency(pitch = p));
+		SetFrequency(SynthContext::Current()->GetFrequency(pitch = p));
 	}
 	virtual void SetVolume(AmpValue v) { vol = v; }
 	virtual void SetVelocity(bsInt16 v) { noteonvel = v; }
@@ -28,6 +28,54 @@
 /// @param usr user supplied argument.
 typedef void (*SeqTickCB)(bsInt32 count, Opaque usr);
 
+/// Stem callback function.
+/// When stems are enabled, this is called at the end of each
+/// block for every stem, in order of the stem number.
+/// The values are the dry output of the voices
+/// in the stem (see InstrManager::StemBlock). Stems appear
+/// when the first voice for a track or channel starts
+/// and are then passed on every block until playback stops.
+/// The callback is made on the sequencer thread.
+/// @sa Sequencer::SetStems
+/// @param stem track or channel number
+/// @param tick sequencer time of the first frame
+/// @param lft left values
+/// @param rgt right values
+/// @param frames number of frames
+/// @param usr user supplied argument.
+typedef void (*SeqStemCB)(bsInt16 stem, bsUint32 tick, AmpValue *lft, AmpValue *rgt, int frames, Opaque usr);
+
+/// Number of consecutive active events rendered into one MixBus
+/// when voices are rendered on multiple threads.
+#define SEQ_VOICE_GROUP 4
+
+/// Stem option: voices are grouped by SEQ_VOICE_GROUP.
+#define SEQ_STEM_OFF   0
+/// Stem option: voices are grouped by track.
+#define SEQ_STEM_TRACK 1
+/// Stem option: voices are grouped by mixer input channel.
+#define SEQ_STEM_CHNL  2
+
+class SeqVoiceThread;
+struct SeqVoiceGroup;
+class SeqChaser;
+
+/// Number of hash buckets used to find active events by ID.
+/// Must be a power of 2.
+#define SEQ_EVID_HASH 256
+/// Flag bit set on event IDs generated for live MIDI notes.
+/// These IDs hold the channel in bits 16-19 and the key
+/// in bits 8-14 and are indexed by channel and key.
+#define SEQ_EVID_MIDI 0x80000000
+/// Size of the channel/key table for MIDI event IDs.
+#define SEQ_EVID_NOTES (16*128)
+/// Default size of the live event queue.
+#define SEQ_LIVE_QUEUE 256
+/// Chase option: replay state changes that occur before the start time.
+#define SEQ_CHASE_CTL   0x01
+/// Chase option: start notes that are still sounding at the start time.
+#define SEQ_CHASE_NOTES 0x02
+
 ///////////////////////////////////////////////////////////
 /// Active note sequencer event
 //
@@ -69,6 +117,17 @@ struct ActiveEvent : public SynthList<ActiveEvent>
 	bsInt16 flags;  ///< event options
 	bsInt16 chnl;   ///< output channel
 	bsInt16 trk;    ///< track number
+	ActiveEvent *hnext;  ///< next event in the ID index slot
+	ActiveEvent *hprev;  ///< previous event in the ID index slot
+	ActiveEvent **hslot; ///< ID index slot, null when not indexed
+
+	ActiveEvent()
+	{
+		ip = 0;
+		hnext = 0;
+		hprev = 0;
+		hslot = 0;
+	}
 };
 
 ///////////////////////////////////////////////////////////
@@ -120,14 +179,23 @@ typedef int SeqState;
 /// Track 0 is the main track and is started automatically.
 /// All other tracks must be started by an event on track 0.
 /// Tracks are evaluated at tickRes intervals.
+///
+/// The events are held in an array. Events added in time order
+/// are appended. When an event is added out of order, the array
+/// is sorted once, the next time the track is started or searched.
+/// Events with the same start time stay in the order added.
+/// The array always ends with a tail event whose start time
+/// is 0x7FFFFFFF.
 //////////////////////////////////////////////////////////
 class SeqTrack : public SynthList<SeqTrack>
 {
 protected:
-	SeqEvent *evtHead;   ///< event list head
-	SeqEvent *evtTail;   ///< event list tail
-	SeqEvent *evtLast;   ///< last used event list position
-	SeqEvent *evtPlay;   ///< next event to play
+	SeqEvent **evtList;  ///< events, followed by evtTail
+	SeqEvent *evtTail;   ///< end of list marker
+	bsInt32 evtCount;    ///< number of events in the track
+	bsInt32 evtAlloc;    ///< allocated size of evtList, not counting the tail
+	bsInt32 evtPlay;     ///< index of the next event to play
+	bsInt16 evtSorted;   ///< events are in time order
 	bsInt32 loopCount;   ///< number of times to repeat the track
 	bsInt32 startTime;   ///< time (in samples) of first event
 	bsInt32 seqLength;   ///< time (in samples) of the track
@@ -146,25 +214,19 @@ public:
 		seqLength = 0;
 		seqResLen = 0;
 		tickRes = 1;
-		evtHead = new SeqEvent;
 		evtTail = new SeqEvent;
-		//evtHead->Insert(evtTail);
-		evtHead->next = evtTail;
-		evtHead->prev = evtTail;
-		evtTail->next = evtHead;
-		evtTail->prev = evtHead;
-		evtLast = evtHead;
-		evtHead->start = 0;
 		evtTail->start = 0x7FFFFFFFL;
-		evtHead->evid = -1;
 		evtTail->evid = -2;
-		evtPlay = evtTail;
+		evtList = &evtTail;
+		evtCount = 0;
+		evtAlloc = 0;
+		evtPlay = 0;
+		evtSorted = 1;
 	}
 
 	~SeqTrack()
 	{
 		Reset();
-		delete evtHead;
 		delete evtTail;
 	}
 
@@ -174,6 +236,36 @@ public:
 	inline bsInt16 Enable(bsInt16 e) { return enable = e; }
 	inline bsInt32 LoopCount(bsInt32 c) { return loopCount = c; }
 
+	/// Get the number of events.
+	inline bsInt32 EventCount() { return evtCount; }
+
+	/// Get an event by position.
+	/// Positions are in time order once the track has been
+	/// started or searched with Find. Position EventCount()
+	/// returns the tail event with a start time of 0x7FFFFFFF.
+	/// @param n position from 0 to EventCount()
+	inline SeqEvent *Event(bsInt32 n) { return evtList[n]; }
+
+	/// Make room for events.
+	/// This avoids growing the event array while a sequence
+	/// with a known number of events is loaded.
+	/// @param count number of events the track will hold
+	void Reserve(bsInt32 count);
+
+	/// Sort the events by time.
+	/// This only does work when events were added out of order
+	/// since the last sort. Start and Find sort the track
+	/// as needed. The sequencer sorts all tracks before playback
+	/// so that a track started by an event is ready to play.
+	void Sort();
+
+	/// Find the first event at or after a time.
+	/// The track is sorted first if needed and then
+	/// searched with a binary search.
+	/// @param st time relative to start of track
+	/// @returns position of the first event with start >= st
+	bsInt32 Find(bsInt32 st);
+
 	/// Start the track.
 	/// @param st start time relative to start of track (usually 0)
 	/// @param res timing resolution, i.e. samples between calls to Tick()
@@ -184,9 +276,7 @@ public:
 		tickRes = res;
 		// round up to integer multipler of res
 		seqResLen = ((seqLength / res) + 1) * res;
-		evtPlay = evtHead->next;
-		while (evtPlay != evtTail && evtPlay->start < st)
-			evtPlay = evtPlay->next;
+		evtPlay = Find(st);
 	}
 
 	/// Stop the track.
@@ -198,8 +288,8 @@ public:
 	/// Determine if the track is playing or not.
 	/// Tick adds the number of samples for one tick
 	/// and checks to see if the track is finished.
-	/// Note that we don't test for evtPlay == tail
-	/// because the start time for tail is set to
+	/// Note that we don't test for the end of the list
+	/// because the start time for the tail is set to
 	/// a maximum time value.
 	/// @returns true if the track is still running
 	int Tick()
@@ -214,13 +304,47 @@ public:
 				else
 				{
 					startTime -= seqResLen;
-					evtPlay = evtHead->next;
+					evtPlay = 0;
 				}
 			}
 		}
 		return enable;
 	}
 
+	/// Get the number of ticks that can pass before the track
+	/// has an event ready or reaches the end. This is called
+	/// after Tick() to find how many more ticks can be
+	/// rendered without checking the track.
+	/// @param max largest value needed
+	/// @returns number of ticks from 0 to max
+	bsInt32 TicksFree(bsInt32 max)
+	{
+		if (!enable)
+			return max;
+		bsInt32 gap = evtList[evtPlay]->start - startTime;
+		if (gap <= 0)
+			return 0;
+		bsInt32 k = max;
+		if (gap < k * tickRes)
+			k = (gap + tickRes - 1) / tickRes;
+		bsInt32 end = (seqResLen - startTime) / tickRes + 1;
+		if (end < k)
+			k = end;
+		return k;
+	}
+
+	/// Advance the track by several ticks.
+	/// Events are not checked; see TicksFree().
+	/// @param n number of ticks
+	/// @returns true if the track is still running
+	int Skip(bsInt32 n)
+	{
+		int on = enable;
+		while (n-- > 0)
+			on = Tick();
+		return on;
+	}
+
 	/// Get the next ready event.
 	/// An event is considered "ready" if the track
 	/// is running and we have passed the start time
@@ -228,11 +352,14 @@ public:
 	/// @returns next event to play, or NULL
 	inline SeqEvent *NextEvent()
 	{
-		if (enable && evtPlay->start <= startTime)
+		if (enable)
 		{
-			SeqEvent *evt = evtPlay;
-			evtPlay = evt->next;
-			return evt;
+			SeqEvent *evt = evtList[evtPlay];
+			if (evt->start <= startTime)
+			{
+				evtPlay++;
+				return evt;
+			}
 		}
 		return 0;
 	}
@@ -272,18 +399,48 @@ protected:
 	bsInt32 tickCount;
 	bsInt32 tickWrap;
 	bsInt32 tickRes;
+	bsInt32 tickRun;    ///< ticks rendered by the next call to Tick()
 	bsInt32 maxNote;    ///< maximum number of active notes
 	bsInt32 evtActive;  ///< number of active notes
 	bsInt32 trkActive;  ///< number of active tracks
 	Opaque  tickArg;
 	bsInt32 wrapCount;
+	bsInt16 blkMode;    ///< block rendering requested
+	bsInt16 blkOn;      ///< block rendering active
+	bsInt16 thrdReq;    ///< threads requested for voice rendering
+	bsInt16 thrdOn;     ///< threads rendering voices (0 = serial)
+	bsInt16 chase;      ///< SEQ_CHASE_* options used when starting late
+	SeqVoiceThread **thrdList; ///< worker threads (thrdOn-1)
+	SynthSemaphore thrdDone;   ///< signaled when a worker finishes a block
+	ActiveEvent **voiceList;   ///< active events for the current block
+	bsInt32 voiceMax;   ///< allocated size of voiceList
+	bsInt32 voiceCount; ///< number of events in voiceList
+	SeqVoiceGroup **voiceGrp;  ///< voice groups, stems are sorted by number
+	bsInt32 grpMax;     ///< allocated size of voiceGrp
+	bsInt32 grpAlloc;   ///< number of groups created
+	bsInt32 grpCount;   ///< number of groups in the current block
+	volatile int grpNext; ///< next group to render
+	int voiceFrames;    ///< frames in the current block
+	bsInt16 stemMode;   ///< SEQ_STEM_* voice grouping
+	SeqStemCB stemCB;
+	Opaque stemArg;
 
 	ActiveEvent *actHead;
 	ActiveEvent *actTail;
+	ActiveEvent *actFree;   ///< unused active event entries
+	ActiveEvent *actHash[SEQ_EVID_HASH];    ///< active events by ID
+	ActiveEvent *actNotes[SEQ_EVID_NOTES];  ///< active MIDI notes by channel and key
 
 	// v 1.2 - add immediate events
-	SeqEvent *immHead;
+	SeqEvent *immHead;  ///< live events waiting for an earlier one, by order
 	SeqEvent *immTail;
+	SynthQueue<SeqEvent> immQueue; ///< live events from other threads
+	void * volatile immOver; ///< events added while immQueue was full, newest first
+	volatile int immSeq;     ///< order given to the next live event
+	bsInt32 immNext;         ///< order of the next live event to play
+	SeqEvent *liveHead; ///< live events waiting to play, sorted by start
+	SeqEvent *liveTail;
+	bsInt16 liveOn;     ///< live events are played during Tick
 
 	SynthMutex critMutex;
 	SynthSignal pauseSignal;
@@ -294,9 +451,35 @@ protected:
 
 	virtual void ProcessEvent(SeqEvent *evt, bsInt16 flags);
 	virtual int Tick();
+	virtual int TickBlock();
+	bsInt32 TickRun(SeqTrack *tp, int all, bsUint32 endTime);
 	virtual void Wait();
 
 	void ClearActive();
+	ActiveEvent *NewActive();
+	void FreeActive(ActiveEvent *act);
+	ActiveEvent **ActiveSlot(bsInt32 evid);
+	ActiveEvent *FindActive(bsInt32 evid);
+	void IndexActive(ActiveEvent *act);
+	bsInt32 TickLive(bsInt32 frames);
+	void HoldLive(SeqEvent *evt);
+	void ClearLive();
+	void BlockStart();
+	void BlockStop();
+	int TickVoice(ActiveEvent *act, int frames, MixBus *bus);
+	int TickVoices(int frames);
+	int GroupVoices();
+	int StemVoices();
+	SeqVoiceGroup *NewGroup(bsInt16 key, int at);
+	void FreeGroups();
+	void TickGroups();
+	void ThreadStart();
+	void ThreadStop();
+	void Chase(bsInt32 st, int multi);
+	void ChaseStart(SeqEvent *evt, bsInt32 elapsed);
+
+	friend class SeqVoiceThread;
+	friend class SeqChaser;
 
 public:
 	Sequencer();
@@ -338,6 +521,15 @@ public:
 		maxNote = n;
 	}
 
+	/// Allocate active event entries ahead of playback.
+	/// An active event entry tracks each sounding note.
+	/// Entries are kept for reuse when a note finishes, so
+	/// once enough entries exist starting a note does not
+	/// allocate memory. Use InstrManager::Preallocate to do
+	/// the same for instrument instances.
+	/// @param count number of entries to have available
+	void Preallocate(bsInt32 count);
+
 	/// Set the tick callback function. 
 	/// @param cb callback function
 	/// @param wrap number of ticks between callbacks
@@ -401,9 +593,39 @@ public:
 	/// Add the event for immediate playback.
 	/// The caller is responsible for setting
 	/// valid values for inum, type and event id where appropriate.
+	/// The start time is a sequencer time in samples (see GetTick).
+	/// Events with a start time at or before the current time
+	/// play on the next sample. Later events are held until
+	/// the sequencer reaches the start time. This is safe to call
+	/// from another thread and does not block the sequencer.
 	/// @param evt the event to schedule
 	virtual void AddImmediate(SeqEvent *evt);
 
+	/// Set the size of the live event queue.
+	/// Events passed to AddImmediate go through a lock-free queue.
+	/// When only one thread calls AddImmediate, set producers to 0
+	/// to avoid the atomic slot claim. If the queue is full, events
+	/// go to a lock-free overflow list and are not lost. Either way,
+	/// events play in the order AddImmediate was called.
+	/// This must be called while the sequencer is stopped.
+	/// @param size number of events the queue holds
+	/// @param producers non-zero if multiple threads add events
+	virtual void SetLiveQueue(int size, int producers)
+	{
+		if (state == seqOff)
+		{
+			ClearLive();
+			immQueue.Init(size, producers);
+		}
+	}
+
+	/// Get the current sequencer time.
+	/// @return time in samples
+	bsUint32 GetTick()
+	{
+		return seqTick;
+	}
+
 	virtual void Broadcast(SeqEvent *evt);
 
 	/// The sequencer loop. 
@@ -458,7 +680,115 @@ public:
 	/// @param res resolution in seconds
 	virtual void SetResolution(FrqValue res)
 	{
-		tickRes = (bsInt32) (res * synthParams.sampleRate);
+		tickRes = (bsInt32) (res * SynthContext::Current()->sampleRate);
+	}
+
+	/// Set block rendering.
+	/// When block rendering is on, each active instrument is invoked
+	/// once for each tick (see SetResolution) rather than once per
+	/// sample, and the instrument manager outputs the whole block
+	/// at the end of the tick. Instruments that do not implement
+	/// Instrument::TickBlock are still called once per sample.
+	/// Block rendering is only used if the instrument manager
+	/// supports it. Changes to the mixer made by instruments
+	/// take effect at the next block. The setting applies
+	/// the next time playback starts.
+	/// @param on 1 to render by blocks, 0 to render by samples
+	virtual void SetBlockMode(int on)
+	{
+		blkMode = (bsInt16) on;
+	}
+
+	/// Get block rendering setting.
+	virtual int GetBlockMode()
+	{
+		return blkMode;
+	}
+
+	/// Set the number of threads used to render voices.
+	/// With a value of 1 or more, each block the active events are
+	/// split into groups of SEQ_VOICE_GROUP in list order, or into
+	/// stems (see SetStems). The groups
+	/// are rendered on the calling thread plus count-1 worker threads,
+	/// each group into its own MixBus, and the buses are passed to
+	/// the instrument manager in group order before the mixer runs.
+	/// The grouping does not depend on the thread count, so the output
+	/// is identical for any count of 1 or more. It can differ in
+	/// rounding from serial rendering (count of 0).
+	/// Threads are only used with block rendering (see SetBlockMode)
+	/// and when the instrument manager supports redirected output.
+	/// Instruments must not share state that changes while rendering.
+	/// To limit the cost of synchronization, blocks rendered with
+	/// threads span several ticks, up to MAX_BLKLEN frames, and are
+	/// only split at a tick where a track has an event ready.
+	/// The setting applies the next time playback starts.
+	/// @param count number of threads, 0 to render voices serially
+	virtual void SetThreads(int count)
+	{
+		if (count < 0)
+			count = 0;
+		thrdReq = (bsInt16) count;
+	}
+
+	/// Get the number of threads used to render voices.
+	virtual int GetThreads()
+	{
+		return thrdReq;
+	}
+
+	/// Set stem rendering.
+	/// Stems group the active events by track or by mixer input
+	/// channel in place of the groups set by SetThreads. Each stem
+	/// is rendered into its own MixBus on one of the threads, so a
+	/// sequence renders in about the time of the busiest stem when
+	/// there is a thread for every stem. The buses are passed to the
+	/// instrument manager in order of the stem number, then the mixer
+	/// applies the effects and produces the master output as usual.
+	/// The output does not depend on the thread count, and a count of 0
+	/// renders the stems on the calling thread. When a callback is set,
+	/// it receives the dry output of each stem for every block,
+	/// e.g. to write each stem to its own file.
+	/// Stems are only used with block rendering (see SetBlockMode)
+	/// and when the instrument manager supports redirected output.
+	/// The setting applies the next time playback starts.
+	/// @param mode SEQ_STEM_TRACK, SEQ_STEM_CHNL or SEQ_STEM_OFF
+	/// @param cb stem output callback, or null
+	/// @param arg caller supplied data
+	virtual void SetStems(int mode, SeqStemCB cb = 0, Opaque arg = 0)
+	{
+		stemMode = (bsInt16) mode;
+		stemCB = cb;
+		stemArg = arg;
+	}
+
+	/// Get the stem rendering option.
+	virtual int GetStems()
+	{
+		return stemMode;
+	}
+
+	/// Set event chase options.
+	/// When playback starts after the beginning of the sequence,
+	/// events before the start time are normally skipped. Chase
+	/// replays those events, in time order across all tracks,
+	/// before the first sample is generated. No samples are produced
+	/// while chasing.
+	/// - SEQ_CHASE_CTL replays control events and calls Instrument::Chase
+	///   for start events so that instruments such as mixer controls
+	///   can apply their changes. Tracks started before the start time
+	///   are positioned to continue from the start time.
+	/// - SEQ_CHASE_NOTES starts notes that are still sounding at the
+	///   start time with the remaining duration.
+	/// @param flags combination of SEQ_CHASE_CTL and SEQ_CHASE_NOTES, 0 for none
+	virtual void SetChase(int flags)
+	{
+		chase = (bsInt16) flags;
+	}
+
+	/// Get the event chase options.
+	virtual int GetChase()
+	{
+		return chase;
 	}
 };
 
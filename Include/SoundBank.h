@@ -209,11 +209,20 @@ public:
 /// DLS files have multiple blocks, potentially one for each region.
 /// The filepos member is included to allow for incremental loading of sample information.
 /// (@sa SoundBank::GetSample())
+/// Mono 16-bit and SF2 24-bit samples are normally kept in their
+/// file format (sample16 and sample8) and converted to AmpValue
+/// by the oscillator. Other formats are converted to AmpValue
+/// when loaded (sample). Only one form is loaded at a time.
+/// When the sound bank maps the sample file, sample16 and
+/// sample8 point into the mapping and are not owned by
+/// the sample object.
 class SBSample : public SynthList<SBSample>
 {
 public:
 	AmpValue *sample;    ///< mono sample
 	AmpValue *linked;    ///< second array for 2 channel
+	bsInt16  *sample16;  ///< mono sample, 16-bit PCM (compact storage)
+	bsUint8  *sample8;   ///< low 8 bits of SF2 24-bit samples (compact storage)
 	SBSample *linkSamp;  ///< linked, phase-locked sample object
 	bsUint32  filepos;   ///< file offset for samples
 	bsUint32  filepos2;  ///< offset for LSB in SF2 24-bit format
@@ -222,12 +231,15 @@ public:
 	bsInt32   index;     ///< index/id number
 	bsInt16   format;    ///< 0 = 8-bit, 1=16-bit, 2=IEEE float, 3=SF2 24-bit
 	bsInt16   channels;  ///< 1 = mono, 2 = stero (others not supported)
+	bsInt16   mapped;    ///< sample16/sample8 point into the file mapping
 
 	SBSample(int n = 0)
 	{
 		index = n;
 		sample = 0;
 		linked = 0;
+		sample16 = 0;
+		sample8 = 0;
 		linkSamp = 0;
 		sampleLen = 0;
 		rate = 44100;
@@ -235,12 +247,36 @@ public:
 		filepos2 = 0;
 		format = -1;
 		channels = 0;
+		mapped = 0;
 	}
 
 	~SBSample()
 	{
-		delete sample;
-		delete linked;
+		delete[] sample;
+		delete[] linked;
+		if (!mapped)
+		{
+			delete[] sample16;
+			delete[] sample8;
+		}
+	}
+
+	/// Test for sample data in either form.
+	int IsLoaded()
+	{
+		return sample != 0 || sample16 != 0;
+	}
+
+	/// Get one sample value, converted to AmpValue.
+	/// @param n sample number
+	/// @return sample value
+	AmpValue Value(bsInt32 n)
+	{
+		if (sample)
+			return sample[n];
+		if (sample8)
+			return (AmpValue) ((bsInt32) sample16[n] * 256 + sample8[n]) / 8388608.0;
+		return (AmpValue) sample16[n] / 32768.0;
 	}
 };
 
@@ -699,6 +735,10 @@ public:
 	SBSample *samples;             ///< list of sample blocks
 	FileReadBuf sampleFile;        ///< file for on-demand loading of samples
 	int sampleFileOpen;
+	int compact;                   ///< keep 16/24-bit samples in file format
+	FileMap sampleMap;             ///< read-only mapping of the file
+	int sampleMapOpen;             ///< 1 = mapped, -1 = mapping failed
+	int mapSamples;                ///< use sample data in place from the mapped file
 
 	static SoundBank SoundBankList; ///< List of loaded soundbanks
 	static void DeleteBankList();  ///< Remove all soundbanks
@@ -783,6 +823,9 @@ public:
 	SoundBank()
 	{
 		sampleFileOpen = 0;
+		compact = 1;
+		sampleMapOpen = 0;
+		mapSamples = 0;
 		lockCount = 0;
 		samples = 0;
 		chnls = 0xffff;
@@ -791,7 +834,7 @@ public:
 		InitPow2n1200();
 		InitPow10n200();
 		InitTransform();
-		maxFilter = log2((synthParams.sampleRate/4)/8.175) * 1200;
+		maxFilter = log2((SynthContext::Current()->sampleRate/4)/8.175) * 1200;
 		minFilter = log2(20.0/8.175) * 1200;
 	}
 
@@ -940,7 +983,7 @@ public:
 		{
 			if (samp->index == ndx)
 			{
-				if (samp->sample == 0 && load)
+				if (!samp->IsLoaded() && load)
 					LoadSample(samp);
 				return samp;
 			}
@@ -953,16 +996,27 @@ public:
 	/// Load sample data from the original file.
 	/// If the sample cannot be loaded, a block of zeros is allocated.
 	/// @param samp pointer to sample block object.
+	/// When mapSamples is set, mono 16 and 24-bit samples
+	/// are used directly from a read-only mapping of the file
+	/// rather than read into memory. The mapped pages are shared with
+	/// other processes using the same file and only touched
+	/// when played. A sample that cannot be used in place (odd
+	/// alignment, no zero guard points after the data, big-endian host)
+	/// is read as usual.
+	/// @param samp pointer to sample block object.
 	/// @param f already open file
 	/// @return 0 on success, non-zero on failure.
 	/// @{
 	int OpenSampleFile();
+	int OpenSampleMap();
+	int MapSample(SBSample *samp);
 	int LoadSample(SBSample *samp);
 	int LoadSample(SBSample *samp, FileReadBuf& f);
 	int LoadInstr(SBInstr *instr);
 	int LoadInstr(SBInstr *instr, FileReadBuf& f);
 	int ReadSamples1(SBSample *samp, FileReadBuf& f);
 	int ReadSamples2(SBSample *samp, FileReadBuf& f);
+	int ReadSamples16(SBSample *samp, FileReadBuf& f);
 	/// @}
 };
 
@@ -43,6 +43,12 @@ typedef unsigned char  bsUint8;
 typedef unsigned short bsUint16;
 /// 32-bit unsigned type
 typedef unsigned int   bsUint32;
+/// 64-bit data type
+#if defined(_MSC_VER)
+typedef __int64 bsInt64;
+#else
+typedef long long bsInt64;
+#endif
 /// transparent data type
 typedef void* Opaque;
 
@@ -68,11 +74,13 @@ typedef float ParamValue;
 
 #define PANTBLLEN 4096
 #define MAX_AMPCB 1440
+/// Maximum number of frames in one rendering block
+#define MAX_BLKLEN 256
 
 /// Global parameters for the synthesizer. SynthConfig holds global information for the synthesizer.
 /// This includes sample rate, wave table size, phase increment calculation constants, 
-/// and the tuning table for conversion of pitch to frequency. Exactly one instance of 
-/// this class exists and is named \ref synthParams. Library classes utilize this object rather
+/// and the tuning table for conversion of pitch to frequency. The default instance of 
+/// this class is named \ref synthParams. Library classes utilize a SynthContext object rather
 /// than store sample rate and other parameters internally. 
 class SynthConfig
 {
@@ -241,14 +249,71 @@ public:
 
 };
 
+class WaveTableSet;
+
+/// Synthesis context.
+/// A SynthContext is a SynthConfig (sample rate, table length, tuning,
+/// cents, pan and cB tables) together with the wavetable set used
+/// by oscillators. Each rendering engine can have its own context,
+/// allowing multiple renders at different sample rates or table sizes
+/// in one process.
+///
+/// The global \ref synthParams object is the default context and uses the
+/// global \ref wtSet object for its wavetables. Other contexts are created
+/// by the application and initialized with InitContext(), which allocates
+/// a private wavetable set.
+///
+/// Unit generators take the context that is current on the calling thread
+/// when they are constructed. SynthContext::MakeCurrent() sets the current
+/// context for a thread; when none is set the default context is current.
+/// InstrManager makes its own context current while it creates instruments.
+class SynthContext : public SynthConfig
+{
+private:
+	int ownWT;
+
+public:
+	/// wavetables for this context
+	WaveTableSet *wt;
+
+	/// Constructor.
+	/// @param w wavetable set, or NULL to allocate one in InitContext()
+	SynthContext(WaveTableSet *w = 0)
+	{
+		wt = w;
+		ownWT = 0;
+	}
+
+	~SynthContext();
+
+	/// Initialize sample rate, table length and wavetables.
+	/// This is the equivalent of InitSynthesizer() for this context.
+	/// @param sr sample rate
+	/// @param wtLen wavetable length
+	/// @param wtUsr number of user wavetables
+	/// @return 0 on success
+	int InitContext(bsInt32 sr = 44100, bsInt32 wtLen = 16384, bsInt32 wtUsr = 0);
+
+	/// Get the context current on this thread.
+	/// @return current context, never NULL
+	static SynthContext *Current();
+
+	/// Set the context current on this thread.
+	/// @param ctx context, NULL for the default context
+	/// @return previous context
+	static SynthContext *MakeCurrent(SynthContext *ctx);
+};
+
 /// Global synthesizer parameteres object
 /// This global must be defined somewhere in the main code.
 /// The simplest way is to include the common library. 
 /// It initializes automatically in the constructor to default values,
 /// but typically InitSynthesizer() is called to initialize the values.
-extern SynthConfig synthParams;
+/// This is also the default SynthContext.
+extern SynthContext synthParams;
 
 /// Initialize the global synthesizer parameters and wavetables.
+/// This initializes the default context (synthParams.InitContext()).
 /// Both synthParams and wtSet must be initialized before using any other
 /// class or function in the library. This is easily accomplished by calling InitSynthesizer 
 /// during program startup or after synthesizer settings have been configured.
@@ -286,9 +351,34 @@ public:
 /// Derived classes should implement the Init, Reset, and Sample methods.
 class GenUnit
 {
+protected:
+	/// synthesis context for this unit
+	SynthContext *ctx;
+
 public:
+	GenUnit()
+	{
+		ctx = SynthContext::Current();
+	}
+
 	virtual ~GenUnit() { }
 
+	/// Set the synthesis context.
+	/// The context is normally the one current when the unit is constructed.
+	/// When changed, it must be set before Init() or Reset() is called.
+	/// Units that contain other units pass the context along.
+	/// @param c synthesis context
+	virtual void SetContext(SynthContext *c)
+	{
+		ctx = c;
+	}
+
+	/// Get the synthesis context.
+	inline SynthContext *GetContext()
+	{
+		return ctx;
+	}
+
 	/// Initialize the generator.
 	/// The Init method sets initial values for the object. The count argument
 	/// indicates the number of values in the values array. This method provides
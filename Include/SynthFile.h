@@ -129,6 +129,41 @@ public:
 	int FileClose();
 };
 
+/// Read-only file mapping. The whole file is mapped into memory
+/// and the pages are shared with any other process that maps
+/// the same file. Nothing is read until the data is touched.
+/// This is used for sample data in large sound banks.
+class FileMap
+{
+private:
+	bsUint8 *data;
+	bsUint32 size;
+#if defined(WIN32)
+	HANDLE fh;
+	HANDLE mh;
+#endif
+
+public:
+	FileMap();
+	~FileMap();
+
+	/// Map a file.
+	/// @param fname path name to the file
+	/// @return 0 on success, a negative value on errors
+	int MapOpen(const char *fname);
+
+	/// Remove the mapping. Pointers into the data are no longer valid.
+	int MapClose();
+
+	/// Get the mapped data.
+	/// @return pointer to the first byte of the file, or 0 if not mapped
+	const bsUint8 *GetData() { return data; }
+
+	/// Get the size of the mapping.
+	/// @return file size in bytes
+	bsUint32 GetSize() { return size; }
+};
+
 /// Check for existence of a file or directory.
 /// @param fname full path to the file or directory.
 int SynthFileExists(const char *fname);
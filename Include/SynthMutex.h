@@ -66,5 +66,232 @@ public:
 	/// Wakeup a thread waiting on a signal.
 	void Wakeup();
 };
+
+/// Semaphore object.
+/// A semaphore keeps a count of posted wakeups so that
+/// a post made before the other thread waits is not lost.
+/// This is used to hand work to a pool of threads and to
+/// wait for the work to complete.
+class SynthSemaphore
+{
+private:
+	void *sem;
+public:
+	SynthSemaphore()
+	{
+		sem = 0;
+	}
+
+	~SynthSemaphore()
+	{
+		Destroy();
+	}
+
+	/// Create the semaphore with a count of zero.
+	void Create();
+	/// Destroy the semaphore.
+	void Destroy();
+	/// Wait until the count is non-zero, then decrement it.
+	void Wait();
+	/// Increment the count, waking one waiting thread.
+	void Post();
+};
+
+/// Atomic operations on 32-bit values and pointers.
+/// These are used by lock-free queues shared between threads.
+/// Load has acquire ordering, Store has release ordering
+/// and the other operations are a full barrier.
+class SynthAtomic
+{
+public:
+	/// Read a value written by another thread.
+	/// @param p pointer to the value
+	/// @return current value
+	static int Load(volatile int *p);
+	/// Write a value to be read by another thread.
+	/// @param p pointer to the value
+	/// @param v new value
+	static void Store(volatile int *p, int v);
+	/// Replace a value if it has not changed.
+	/// @param p pointer to the value
+	/// @param cmp expected current value
+	/// @param v new value
+	/// @return non-zero if the value was replaced
+	static int CompareExchange(volatile int *p, int cmp, int v);
+	/// Add to a value.
+	/// @param p pointer to the value
+	/// @param v amount to add
+	/// @return value before the add
+	static int Add(volatile int *p, int v);
+	/// Read a pointer written by another thread.
+	/// @param p pointer to the pointer
+	/// @return current pointer
+	static void *LoadPtr(void * volatile *p);
+	/// Replace a pointer.
+	/// @param p pointer to the pointer
+	/// @param v new pointer
+	/// @return previous pointer
+	static void *ExchangePtr(void * volatile *p, void *v);
+	/// Replace a pointer if it has not changed.
+	/// @param p pointer to the pointer
+	/// @param cmp expected current pointer
+	/// @param v new pointer
+	/// @return non-zero if the pointer was replaced
+	static int CompareExchangePtr(void * volatile *p, void *cmp, void *v);
+};
+
+/// Lock-free queue of object pointers.
+/// The queue is a fixed size ring buffer that passes objects
+/// from producer threads to a single consumer thread without
+/// blocking either side. With one producer, Put only reads and
+/// writes the ring. With multiple producers, Put claims a slot
+/// with an atomic compare-exchange. Each slot holds a sequence
+/// number that tells the consumer when the item is ready and
+/// tells producers when the slot has been emptied.
+template<class T> class SynthQueue
+{
+private:
+	struct Slot
+	{
+		volatile int seq;
+		T *item;
+	};
+	Slot *slots;
+	int mask;
+	int multi;
+	volatile int head;  ///< next slot to read (consumer only)
+	volatile int tail;  ///< next slot to write
+
+	static int Diff(int a, int b)
+	{
+		return (int) ((unsigned int) a - (unsigned int) b);
+	}
+
+	static int Next(int a)
+	{
+		return (int) ((unsigned int) a + 1);
+	}
+
+public:
+	SynthQueue()
+	{
+		slots = 0;
+		mask = -1;
+		multi = 0;
+		head = 0;
+		tail = 0;
+	}
+
+	~SynthQueue()
+	{
+		delete[] slots;
+	}
+
+	/// Allocate the ring.
+	/// This must be called before any thread uses the queue.
+	/// Items still in the queue are discarded.
+	/// @param size number of slots, rounded up to a power of 2
+	/// @param producers non-zero if more than one thread calls Put
+	/// @return 0 on success, -1 if memory cannot be allocated
+	int Init(int size, int producers)
+	{
+		int n = 2;
+		while (n < size)
+			n <<= 1;
+		delete[] slots;
+		slots = new Slot[n];
+		if (slots == 0)
+		{
+			mask = -1;
+			return -1;
+		}
+		for (int i = 0; i < n; i++)
+		{
+			slots[i].seq = i;
+			slots[i].item = 0;
+		}
+		mask = n - 1;
+		multi = producers;
+		head = 0;
+		tail = 0;
+		return 0;
+	}
+
+	/// Get the number of slots.
+	int GetSize()
+	{
+		return mask + 1;
+	}
+
+	/// Add an item (producer side).
+	/// @param item object to add
+	/// @return non-zero if added, 0 if the queue is full
+	int Put(T *item)
+	{
+		if (slots == 0)
+			return 0;
+		Slot *sp;
+		int pos;
+		if (multi)
+		{
+			pos = SynthAtomic::Load(&tail);
+			for (;;)
+			{
+				sp = &slots[pos & mask];
+				int d = Diff(SynthAtomic::Load(&sp->seq), pos);
+				if (d == 0)
+				{
+					if (SynthAtomic::CompareExchange(&tail, pos, Next(pos)))
+						break;
+					pos = SynthAtomic::Load(&tail);
+				}
+				else if (d < 0)
+					return 0;
+				else
+					pos = SynthAtomic::Load(&tail);
+			}
+		}
+		else
+		{
+			pos = tail;
+			sp = &slots[pos & mask];
+			if (Diff(SynthAtomic::Load(&sp->seq), pos) != 0)
+				return 0;
+			tail = Next(pos);
+		}
+		sp->item = item;
+		SynthAtomic::Store(&sp->seq, Next(pos));
+		return 1;
+	}
+
+	/// Look at the next item without removing it (consumer side).
+	/// @return next item or null if the queue is empty
+	T *Peek()
+	{
+		if (slots == 0)
+			return 0;
+		Slot *sp = &slots[head & mask];
+		if (Diff(SynthAtomic::Load(&sp->seq), Next(head)) != 0)
+			return 0;
+		return sp->item;
+	}
+
+	/// Remove the next item (consumer side).
+	/// @return next item or null if the queue is empty
+	T *Get()
+	{
+		if (slots == 0)
+			return 0;
+		int pos = head;
+		Slot *sp = &slots[pos & mask];
+		if (Diff(SynthAtomic::Load(&sp->seq), Next(pos)) != 0)
+			return 0;
+		T *item = sp->item;
+		sp->item = 0;
+		SynthAtomic::Store(&sp->seq, (int) ((unsigned int) pos + mask + 1));
+		head = Next(pos);
+		return item;
+	}
+};
 #endif
 ///@}
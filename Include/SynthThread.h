@@ -56,6 +56,12 @@ public:
 	/// @brief Delay minimum amount.
 	/// @details Used for spin locks.
 	virtual void ShortWait();
+
+	/// @brief Give up the rest of the time slice.
+	/// @details Used by spin locks that are held briefly
+	/// so that a waiting thread does not keep the owner
+	/// from running.
+	static void YieldThread();
 };
 
 #endif
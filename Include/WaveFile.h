@@ -83,6 +83,22 @@ struct WavHDR32
 	RiffChunk data;      // 'data' chunk
 };
 
+/// RF64 size chunk. This is written as a JUNK chunk
+/// when the file is opened and changed to ds64 if the
+/// file grows beyond the 4GB RIFF limit.
+/// 64-bit values are stored as low, high 32-bit pairs.
+struct Ds64Chunk
+{
+	RiffChunk ds64;      // 'ds64' or 'JUNK' chunk
+	bsUint32 riffSizeLow;
+	bsUint32 riffSizeHigh;
+	bsUint32 dataSizeLow;
+	bsUint32 dataSizeHigh;
+	bsUint32 sampleCountLow;
+	bsUint32 sampleCountHigh;
+	bsUint32 tableLength;
+};
+
 #pragma pack(pop)
 
 /// Interface for sample output.
@@ -346,6 +362,73 @@ public:
 	}
 };
 
+class WaveWriterThread;
+
+/// Sample data writer for wave files. WaveWriter writes the header
+/// and sample buffers for WaveFile and WaveFileIEEE. In background mode,
+/// each buffer is handed to an I/O thread and the caller continues with
+/// a second buffer while the first is written. Memory use is fixed
+/// at two buffers regardless of the length of the file.
+/// When large file support is on, room for an RF64 ds64 chunk is
+/// reserved in the header. If the data grows beyond 4GB, the file is
+/// changed to RF64 format on close, otherwise it remains a normal
+/// WAVE file with a JUNK chunk.
+/// The header must start with the RIFF chunk and WAVE type and
+/// end with the data chunk.
+class WaveWriter
+{
+private:
+	friend class WaveWriterThread;
+	FileWriteUnBuf wfp;
+	WaveWriterThread *thrd;
+	bsInt64 byteTotal;
+	int large;
+	int err;
+
+public:
+	WaveWriter();
+	~WaveWriter();
+
+	/// Open the file.
+	/// @param fname path to the output file
+	/// @param bg write in the background
+	/// @param lg reserve space for RF64 sizes
+	/// @return 0 on success, negative on error
+	int Open(const char *fname, int bg, int lg);
+
+	/// Write the header at the start of the file. This is called
+	/// once after Open and again after the last sample is written.
+	/// The RIFF and data chunk sizes are set from the
+	/// amount of sample data written so far.
+	/// @param hdr wave file header
+	/// @param len size of the header in bytes
+	/// @param frames number of sample frames written
+	/// @return 0 on success, negative on error
+	int WriteHeader(void *hdr, int len, bsInt64 frames);
+
+	/// Write a buffer of samples. In background mode, this waits
+	/// for the previous buffer to be written and then queues
+	/// this buffer. The previous buffer can be reused on return, but
+	/// this buffer must not be changed until the next call.
+	/// @param buf sample data
+	/// @param len length of the data in bytes
+	/// @return 0 on success, negative if a write has failed
+	int Write(void *buf, size_t len);
+
+	/// Wait for the background write to complete.
+	/// @return 0 on success, negative if a write has failed
+	int Flush();
+
+	/// Stop the I/O thread and close the file.
+	int Close();
+
+	/// Get the number of bytes of sample data written.
+	bsInt64 GetByteTotal() { return byteTotal; }
+
+	/// Test for background mode.
+	int IsBackground() { return thrd != 0; }
+};
+
 /// Wave file writer (PCM). WaveFile manages output to a WAV file.
 /// The wave file header is automatically updated as needed.
 /// A simplified model of a wave file is used. Only two chunks
@@ -355,9 +438,12 @@ public:
 class WaveFile : public WaveOutBuf
 {
 private:
-	FileWriteUnBuf wfp;
+	WaveWriter wfp;
 	WavHDR wh;
 	int   bufSecs;
+	int   bgWrite;
+	int   largeFile;
+	SampleValue *spare;
 
 	void SetupWH(int ch);
 
@@ -365,11 +451,15 @@ public:
 	WaveFile()
 	{
 		bufSecs = 5;
+		bgWrite = 1;
+		largeFile = 0;
+		spare = 0;
 	}
 
 	virtual ~WaveFile()
 	{
-		wfp.FileClose();
+		wfp.Close();
+		delete[] spare;
 	}
 
 	/// Set buffer size. The size of the buffer in specified in seconds, not samples.
@@ -381,6 +471,24 @@ public:
 		bufSecs = secs;
 	}
 
+	/// Set background writing. When on (the default), full buffers are
+	/// written by an I/O thread while the next buffer is filled.
+	/// This must be set before the wave file is opened.
+	/// @param on write in the background
+	void SetBackground(int on)
+	{
+		bgWrite = on;
+	}
+
+	/// Set large file support. When on, the file is written in RF64
+	/// format if the sample data exceeds 4GB. This must be set before
+	/// the wave file is opened.
+	/// @param on allow files over 4GB
+	void SetLargeFile(int on)
+	{
+		largeFile = on;
+	}
+
 	/// Open wave output file. The file is created if it does not exist.
 	/// Existing files are truncated.
 	/// @param fname path to the output file
@@ -407,9 +515,12 @@ public:
 class WaveFileIEEE : public WaveOutBufIEEE
 {
 private:
-	FileWriteUnBuf wfp;
+	WaveWriter wfp;
 	WavHDR32 wh;
 	int   bufSecs;
+	int   bgWrite;
+	int   largeFile;
+	float *spare;
 
 	void SetupWH(short ch);
 
@@ -417,11 +528,15 @@ public:
 	WaveFileIEEE()
 	{
 		bufSecs = 5;
+		bgWrite = 1;
+		largeFile = 0;
+		spare = 0;
 	}
 
 	virtual ~WaveFileIEEE()
 	{
-		wfp.FileClose();
+		wfp.Close();
+		delete[] spare;
 	}
 
 	/// Set buffer size. The size of the buffer in specified in seconds, not samples.
@@ -433,6 +548,24 @@ public:
 		bufSecs = secs;
 	}
 
+	/// Set background writing. When on (the default), full buffers are
+	/// written by an I/O thread while the next buffer is filled.
+	/// This must be set before the wave file is opened.
+	/// @param on write in the background
+	void SetBackground(int on)
+	{
+		bgWrite = on;
+	}
+
+	/// Set large file support. When on, the file is written in RF64
+	/// format if the sample data exceeds 4GB. This must be set before
+	/// the wave file is opened.
+	/// @param on allow files over 4GB
+	void SetLargeFile(int on)
+	{
+		largeFile = on;
+	}
+
 	/// Open wave output file. The file is created if it does not exist.
 	/// Existing files are truncated.
 	/// @param fname path to the output file
@@ -70,7 +70,7 @@ public:
 		}
 		else if (nb < 1)
 			nb = 1;
-		if (AllocBuf((long)(leadtm * synthParams.sampleRate) * 2, 2))
+		if (AllocBuf((long)(leadtm * SynthContext::Current()->sampleRate) * 2, 2))
 			return -1;
 		
 		int err = snd_pcm_open(&handle, device, SND_PCM_STREAM_PLAYBACK, 0);
@@ -80,7 +80,7 @@ public:
 					SND_PCM_FORMAT_S16, 
 					SND_PCM_ACCESS_RW_INTERLEAVED,
 					2, // channels
-					synthParams.isampleRate,
+					SynthContext::Current()->isampleRate,
 					1, // allow resample
 					(unsigned int) (leadtm * 1000000.0) * nb);
 			if (err == 0)
@@ -41,10 +41,13 @@
 
 /// Structure to hold information about a wavetable.
 /// The wavID member is used to lookup the table.
+/// When a mip-map is built, wavMip holds one table per octave
+/// of phase increment (see WaveTableSet::MipMap()).
 struct WaveTable
 {
 	AmpValue *wavTbl;
 	bsInt32   wavID;
+	AmpValue **wavMip;
 };
 
 /// Global, pre-calculated waveform tables.
@@ -57,7 +60,7 @@ struct WaveTable
 /// the wavetable directly. Memory should be allocated using 
 /// @code
 /// int n = wavSet.GetFreeWavetable(id);
-/// wavSet[n].wavTbl = new AmpValue[synthParams.itableLength+1];
+/// wavSet[n].wavTbl = new AmpValue[wavSet.itableLength+1];
 /// @endcode
 /// Although possible to replace the default waveforms,
 /// this is not a good idea, especially for WT_SIN.
@@ -88,6 +91,14 @@ public:
 	WaveTable *wavSet;
 	/// number of wavetables
 	bsInt32 wavTblMax;
+	/// wavetable length, set by Init()
+	bsInt32 itableLength;
+	/// wavetable length as a floating point value
+	PhsAccum ftableLength;
+	/// number of mip-map levels, set by Init() (0 if the length is not a power of two)
+	bsInt32 mipLevels;
+	/// build mip-maps for band-limited tables
+	int mipOn;
 
 	WaveTableSet()
 	{
@@ -103,6 +114,10 @@ public:
 		posTri = NULL;
 		wavSet = NULL;
 		wavTblMax = 0;
+		itableLength = 0;
+		ftableLength = 0;
+		mipLevels = 0;
+		mipOn = 0;
 	}
 
 	~WaveTableSet()
@@ -116,7 +131,10 @@ public:
 		if (wavSet)
 		{
 			for (bsInt32 i = 0; i < wavTblMax; i++)
-				delete wavSet[i].wavTbl;
+			{
+				FreeMipMap(i);
+				delete[] wavSet[i].wavTbl;
+			}
 			delete[] wavSet;
 		}
 		wavSet = NULL;
@@ -144,6 +162,7 @@ public:
 			{
 				wavSet[n].wavTbl = sav[n].wavTbl;
 				wavSet[n].wavID  = sav[n].wavID;
+				wavSet[n].wavMip = sav[n].wavMip;
 			}
 			delete[] sav;
 		}
@@ -151,6 +170,7 @@ public:
 		{
 			wavSet[wavTblMax].wavTbl = 0;
 			wavSet[wavTblMax].wavID = -1;
+			wavSet[wavTblMax].wavMip = 0;
 			wavTblMax++;
 		}
 		return 0;
@@ -201,8 +221,44 @@ public:
 		return wavSin;
 	}
 
+	/// Get the mip-map for a wavetable by index.
+	/// Level n of the mip-map is free of aliasing for phase increments
+	/// up to 2^n table entries per sample.
+	/// @param ndx wave table index
+	/// @return array of mipLevels tables, or NULL if there is no mip-map
+	AmpValue **GetMipMap(bsInt32 ndx)
+	{
+		if (ndx >= 0 && ndx < wavTblMax)
+			return wavSet[ndx].wavMip;
+		return 0;
+	}
+
+	/// Enable mip-maps.
+	/// When on, band-limited tables created by Init(), SetWaveTable() and SegWaveTable()
+	/// include a mip-map. This must be set before Init() to apply to the pre-defined tables.
+	/// Mip-maps are only built when the table length is a power of two.
+	/// @param on 1 to build mip-maps, 0 to not build them
+	void SetMipMaps(int on)
+	{
+		mipOn = on;
+	}
+
+	/// Build the mip-map for a table.
+	/// The table is analyzed with an FFT and a band-limited copy is made for
+	/// each octave of phase increment that would otherwise alias. Level n holds
+	/// the partials up to tableLength/2^(n+1). Levels that would hold all partials
+	/// share the original table. The mip-map is discarded when the table is set again.
+	/// @param ti table index
+	/// @return 0 on success, -1 on error
+	int MipMap(bsInt32 ti);
+
+	/// Discard the mip-map for a table.
+	/// @param ti table index
+	void FreeMipMap(bsInt32 ti);
+
 	/// Initialize the default wavetables. 
-	/// The length of wavetables is set by the synthParams itableLength member.
+	/// The length of wavetables is set by the itableLength member of the
+	/// configuration, by default synthParams.
 	/// An additional guard point is added to the end of all tables.
 	/// Table values are normalized to the range[-1,+1].
 	/// The guard point is set to the value at index 0
@@ -211,8 +267,9 @@ public:
 	/// The NUM_PARTS constant is set to allow oscillator frequencies 
 	/// up to 2 octaves above middle C.
 	/// Higher pitches will produce alias frequencies.
-	/// For higher partials, or higher pitches, use GenWaveSum, or
-	/// add bandwith limited waveforms using SetWaveTable().
+	/// For higher partials, or higher pitches, use GenWaveSum, 
+	/// add bandwith limited waveforms using SetWaveTable(),
+	/// or turn on mip-maps with SetMipMaps() before calling Init.
 	///
 	/// When Init is called, existing wavetables are destroyed. 
 	/// Thus any oscillators using wavetables MUST be deleted before calling Init.
@@ -220,12 +277,23 @@ public:
 	/// interactive system, it may be necessary to call Init if
 	/// the user desires to add new wavetables.
 	/// @param wtUsr number of user-defined wavetables
-	void Init(bsInt32 wtUsr = 0)
+	/// @param cfg configuration for the table length, NULL for synthParams
+	void Init(bsInt32 wtUsr = 0, SynthConfig *cfg = 0)
 	{
+		if (cfg == 0)
+			cfg = &synthParams;
+		itableLength = cfg->itableLength;
+		ftableLength = cfg->ftableLength;
 		DestroyTables();
 		SetMax(WT_USR(wtUsr));
+		mipLevels = 0;
+		if ((itableLength & (itableLength - 1)) == 0)
+		{
+			while ((1 << mipLevels) < itableLength)
+				mipLevels++;
+		}
 
-		size_t allocSize = synthParams.itableLength+1;
+		size_t allocSize = itableLength+1;
 		wavSin = new AmpValue[allocSize];
 		wavSaw = new AmpValue[allocSize];
 		wavSqr = new AmpValue[allocSize];
@@ -243,7 +311,7 @@ public:
 		int partNum;
 		int partMax = 1;
 
-		phsInc[0] = twoPI / (double) synthParams.ftableLength;
+		phsInc[0] = twoPI / (double) ftableLength;
 		phsVal[0] = 0.0f;
 		for (partNum = 1; partNum < NUM_PARTS; partNum++)
 		{
@@ -274,7 +342,7 @@ public:
 		double partP1;
 
 		bsInt16 index;
-		for (index = 0; index < synthParams.itableLength; index++)
+		for (index = 0; index < itableLength; index++)
 		{
 			value = sin(phsVal[0]);
 			wavSin[index] = (AmpValue) value;
@@ -336,7 +404,7 @@ public:
 		}
 
 		// Normalize summed values
-		for (index = 0; index < synthParams.itableLength; index++)
+		for (index = 0; index < itableLength; index++)
 		{
 			wavSaw[index] = wavSaw[index] / (AmpValue) sawPeak;
 			wavSqr[index] = wavSqr[index] / (AmpValue) sqrPeak;
@@ -345,16 +413,16 @@ public:
 		}
 
 		// Set gaurd point for interpolation/round-up
-		wavSin[synthParams.itableLength] = wavSin[0];
-		wavSaw[synthParams.itableLength] = wavSaw[0];
-		wavSqr[synthParams.itableLength] = wavSqr[0];
-		wavTri[synthParams.itableLength] = wavTri[0];
-		wavPls[synthParams.itableLength] = wavPls[0];
-		lfoSaw[synthParams.itableLength] = lfoSaw[0];
-		lfoSqr[synthParams.itableLength] = lfoSqr[0];
-		lfoTri[synthParams.itableLength] = lfoTri[0];
-		posSaw[synthParams.itableLength] = posSaw[0];
-		posTri[synthParams.itableLength] = posTri[0];
+		wavSin[itableLength] = wavSin[0];
+		wavSaw[itableLength] = wavSaw[0];
+		wavSqr[itableLength] = wavSqr[0];
+		wavTri[itableLength] = wavTri[0];
+		wavPls[itableLength] = wavPls[0];
+		lfoSaw[itableLength] = lfoSaw[0];
+		lfoSqr[itableLength] = lfoSqr[0];
+		lfoTri[itableLength] = lfoTri[0];
+		posSaw[itableLength] = posSaw[0];
+		posTri[itableLength] = posTri[0];
 
 		wavSet[WT_SIN].wavTbl = wavSin;
 		wavSet[WT_SIN].wavID = WT_SIN;
@@ -376,6 +444,14 @@ public:
 		wavSet[WT_SAWP].wavID = WT_SAWP;
 		wavSet[WT_TRIP].wavTbl = posTri;
 		wavSet[WT_TRIP].wavID = WT_TRIP;
+
+		if (mipOn)
+		{
+			MipMap(WT_SAW);
+			MipMap(WT_SQR);
+			MipMap(WT_TRI);
+			MipMap(WT_PLS);
+		}
 	}
 
 	/// Set an indexed wave table. This is the method to fill in a user wavetable
@@ -383,6 +459,9 @@ public:
 	/// to the range [-1,+1]. Thus the actual amplitudes only need to be relative.
 	/// E.G., you can set amplitudes as 10,5,1 etc. and still produce a wavetable
 	/// with amplitudes in the range [-1,+1]. Phase values, if given, are in radians.
+	/// When the table length is a power of two, the table is calculated with an
+	/// inverse FFT of the partials rather than by summing sinusoids. When mip-maps
+	/// are on, the mip-map for the table is built at the same time.
 	///
 	/// @param ti table index
 	/// @param nparts number of partials
@@ -390,93 +469,8 @@ public:
 	/// @param amp array of partial relative amplitudes (required)
 	/// @param phs array of phase offsets, NULL for all 0 phase
 	/// @param gibbs turn gibbs correction on/off
-	int SetWaveTable(bsInt32 ti, bsInt32 nparts, bsInt32 *mul, double *amp, double *phs, int gibbs)
-	{
-		if (ti < 0 || ti >= wavTblMax || amp == NULL)
-			return -1;
-
-		AmpValue *wavTable = wavSet[ti].wavTbl;
-		if (wavTable == 0)
-		{
-			wavTable = new AmpValue[synthParams.itableLength+1];
-			if (wavTable == NULL)
-				return -1;
-			wavSet[ti].wavTbl = wavTable;
-		}
-
-		double *phsVal = new double[nparts];
-		double *phsInc = new double[nparts];
-		double *sigma = new double[nparts];
-
-		double incr = twoPI / (double) synthParams.ftableLength;
-		int index = 0;
-		int mulMax = 0;
-		int partNum;
-		int partMax = 0;
-		for (partNum = 0; partNum < nparts; partNum++)
-		{
-			if (mul != NULL)
-			{
-				if (mul[partNum] > mulMax)
-					mulMax = mul[partNum];
-				phsInc[partNum] = incr * mul[partNum];
-			}
-			else
-				phsInc[partNum] = incr * (partNum + 1);
-			if (phsInc[partNum] < PI)
-				partMax++;
-			if (phs)
-				phsVal[partNum] = phs[partNum];
-			else
-				phsVal[partNum] = 0.0;
-		}
-
-		if (mulMax == 0)
-			mulMax = partMax;
-		double value;
-		double maxvalue = 0.00001;
-		double sigK = PI / (double) mulMax;
-		for (partNum = 0; partNum < partMax; partNum++)
-		{
-			sigma[partNum] = 1.0;
-			if (gibbs)
-			{
-				if (mul)
-					value = mul[partNum] * sigK;
-				else
-					value = (double) partNum * sigK;
-				if (value > 0)
-					sigma[partNum] = sin(value) / value;
-			}
-		}
-
-		for (index = 0; index < synthParams.itableLength; index++)
-		{
-			value = 0;
-			for (partNum = 0; partNum < partMax; partNum++)
-			{
-				if (amp[partNum] != 0)
-				{
-					value += sin(phsVal[partNum]) * amp[partNum] * sigma[partNum];
-					phsVal[partNum] += phsInc[partNum];
-				}
-			}
-			wavTable[index] = (AmpValue) value;
-			if (fabs(value) > maxvalue)
-				maxvalue = fabs(value);
-		}
-
-		// Normalize summed values
-		for (index = 0; index < synthParams.itableLength; index++)
-			wavTable[index] = wavTable[index] / (AmpValue) maxvalue;
-
-		wavTable[synthParams.itableLength] = wavTable[0];
-		delete phsVal;
-		delete phsInc;
-		delete sigma;
-
-		return 0;
-	}
+	/// @return 0 on success, -1 on error
+	int SetWaveTable(bsInt32 ti, bsInt32 nparts, bsInt32 *mul, double *amp, double *phs, int gibbs);
 
 	/// Set an indexed wave table. This is the method to fill in a user wavetable
 	/// from a set of linear segments. Each segment is defined by a length and
@@ -498,7 +492,7 @@ public:
 		AmpValue *wavTable = wavSet[ti].wavTbl;
 		if (wavTable == 0)
 		{
-			wavTable = new AmpValue[synthParams.itableLength+1];
+			wavTable = new AmpValue[itableLength+1];
 			if (wavTable == NULL)
 				return -1;
 			wavSet[ti].wavTbl = wavTable;
@@ -508,11 +502,11 @@ public:
 		double level = 0.0;
 		for (int ns = 0; ns < nsegs; ns++)
 		{
-			bsInt32 count = (bsInt32) (synthParams.ftableLength * len[ns]);
+			bsInt32 count = (bsInt32) (ftableLength * len[ns]);
 			if (count > 0)
 			{
 				double incr = (val[ns] - level) / (double) count;
-				while (count > 0 && index < synthParams.itableLength)
+				while (count > 0 && index < itableLength)
 				{
 					wavTable[index++] = level;
 					level += incr;
@@ -521,9 +515,12 @@ public:
 			}
 			level = val[ns];
 		}
-		while (index < synthParams.itableLength)
+		while (index < itableLength)
 			wavTable[index++] = level;
-		wavTable[synthParams.itableLength] = wavTable[0];
+		wavTable[itableLength] = wavTable[0];
+		FreeMipMap(ti);
+		if (mipOn)
+			MipMap(ti);
 		return 0;
 	}
 
@@ -545,15 +542,15 @@ public:
 	inline double CosWT(PhsAccum ndx)
 	{
 		// add PI/2 radians to phase
-		ndx += synthParams.ftableLength / 4.0;
-		if (ndx >= synthParams.ftableLength)
-			ndx -= synthParams.ftableLength;
+		ndx += ftableLength / 4.0;
+		if (ndx >= ftableLength)
+			ndx -= ftableLength;
 		return SinWT(ndx);
 	}
 };
 
 /// Global wavetable object. This global must be allocated somewhere. It is shared
-/// by all wavetable oscillators. Typically, it is defined by including the
+/// by all wavetable oscillators using the default context (synthParams). Typically, it is defined by including the
 /// common library and initialized by the InitSynthesizer() method. It is also
 /// possible to define your own global variable and/or initialize it as you see fit.
 extern WaveTableSet wtSet;
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <math.h>
+#include <time.h>
 
 #include <BasicSynth.h>
 #include <NLConvert.h>
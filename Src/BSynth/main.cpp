@@ -40,6 +40,53 @@ public:
 	~ProjectFileList() { delete str; }
 };
 
+// Output file for one stem.
+class StemFile :
+	public SynthList<StemFile>
+{
+public:
+	bsInt16 stem;
+	bsUint32 pos;   // sequencer time of the next frame
+	WaveOut *wvp;
+	WaveFile *wvf;
+	WaveFileIEEE *wvf32;
+
+	StemFile()
+	{
+		stem = 0;
+		pos = 0;
+		wvp = 0;
+		wvf = 0;
+		wvf32 = 0;
+	}
+
+	~StemFile()
+	{
+		delete wvf;
+		delete wvf32;
+	}
+
+	int Open(const char *fname, long fmt)
+	{
+		if (fmt == 1)
+		{
+			wvf32 = new WaveFileIEEE;
+			wvp = wvf32;
+			return wvf32->OpenWaveFile((char *) fname, 2);
+		}
+		wvf = new WaveFile;
+		wvp = wvf;
+		return wvf->OpenWaveFile(fname, 2);
+	}
+
+	int Close()
+	{
+		if (wvf32)
+			return wvf32->CloseWaveFile();
+		return wvf->CloseWaveFile();
+	}
+};
+
 class SynthProject
 {
 public:
@@ -61,6 +108,12 @@ public:
 	AmpValue tail;
 	AmpValue lead;
 	int silent;
+	int bench;
+	long stems;
+	long thrds;
+	float tickRes;
+	StemFile *stemList;
+	double cvtTime;
 
 	long outType;
 	long lastOOR;
@@ -79,6 +132,11 @@ public:
 		((SynthProject *)arg)->Update(cnt);
 	}
 
+	static void StemOut(bsInt16 stem, bsUint32 tick, AmpValue *lft, AmpValue *rgt, int frames, Opaque arg)
+	{
+		((SynthProject *)arg)->WriteStem(stem, tick, lft, rgt, frames);
+	}
+
 	static void DestroyTemplate(Opaque tp)
 	{
 		Instrument *ip = (Instrument *)tp;
@@ -99,9 +157,87 @@ public:
 		fflush(stdout);
 	}
 
+	// Write a block to a stem file. The file is opened
+	// on the first block for the stem and silence is added
+	// up to the time the stem starts.
+	void WriteStem(bsInt16 stem, bsUint32 tick, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		StemFile *sf;
+		for (sf = stemList; sf; sf = sf->next)
+		{
+			if (sf->stem == stem)
+				break;
+		}
+		if (sf == 0)
+		{
+			sf = new StemFile;
+			sf->stem = stem;
+			bsString path(outFile);
+			bsString fname;
+			int dot = path.FindReverse(0, '.');
+			int sep = path.FindReverse(0, '/');
+			if (sep < 0)
+				sep = path.FindReverse(0, '\\');
+			if (dot > 0 && dot > sep)
+				path.SubString(fname, 0, dot);
+			else
+				fname = outFile;
+			fname += stems == SEQ_STEM_CHNL ? "-c" : "-t";
+			fname += (long) stem;
+			if (dot > 0 && dot > sep)
+				fname += &outFile[dot];
+			if (sf->Open(fname, sampleFormat) != 0)
+			{
+				fprintf(stderr, "Cannot open stem file %s\n", (const char *) fname);
+				sf->wvp = 0;
+			}
+			else if (!silent)
+				fprintf(stdout, "\rStem file %s\n", (const char *) fname);
+			sf->next = stemList;
+			stemList = sf;
+			long pad = (long) (synthParams.isampleRate * lead);
+			while (pad-- > 0 && sf->wvp)
+				sf->wvp->Output2(0.0, 0.0);
+		}
+		if (sf->wvp == 0)
+			return;
+		while (sf->pos < tick)
+		{
+			sf->wvp->Output2(0.0, 0.0);
+			sf->pos++;
+		}
+		for (int n = 0; n < frames; n++)
+			sf->wvp->Output2(lft[n], rgt[n]);
+		sf->pos += frames;
+	}
+
+	// Add the tail and close the stem files.
+	void CloseStems()
+	{
+		StemFile *sf;
+		while ((sf = stemList) != 0)
+		{
+			stemList = sf->next;
+			if (sf->wvp)
+			{
+				long pad = (long) (synthParams.isampleRate * tail);
+				while (pad-- > 0)
+					sf->wvp->Output2(0.0, 0.0);
+				sf->Close();
+			}
+			delete sf;
+		}
+	}
+
 	SynthProject()
 	{
 		silent = 0;
+		bench = 0;
+		stems = 0;
+		thrds = 0;
+		tickRes = 0;
+		stemList = 0;
+		cvtTime = 0;
 		name = 0;
 		author = 0;
 		descr = 0;
@@ -207,6 +343,9 @@ public:
 				child->GetAttribute("fmt", sampleFormat);
 				child->GetAttribute("lead", lead);
 				child->GetAttribute("tail", tail);
+				child->GetAttribute("stems", stems);
+				child->GetAttribute("thrds", thrds);
+				child->GetAttribute("res", tickRes);
 				child->GetContent(&outFile);
 			}
 			else if (child->TagMatch("wvdir"))
@@ -300,6 +439,9 @@ public:
 				child->GetAttribute("sr", sampleRate);
 				child->GetAttribute("wt", wtSize);
 				child->GetAttribute("usr", wtUser);
+				short mip = 0;
+				child->GetAttribute("mip", mip);
+				wtSet.SetMipMaps(mip);
 				InitSynthesizer((bsInt32)sampleRate, (bsInt32)wtSize, (bsInt32)wtUser);
 				int wvCount = 0;
 				XmlSynthElem *wvnode = child->FirstChild();
@@ -368,6 +510,22 @@ public:
 							rvb->InitReverb(1.0, FrqValue(rvt));
 							LoadFX(mixElem, rvb);
 						}
+						else if (mixElem->TagMatch("convolve"))
+						{
+							fxCount++;
+							char *irfile = 0;
+							float irlen = 0;
+							mixElem->GetAttribute("file", &irfile);
+							mixElem->GetAttribute("len", irlen);
+							ReverbIR *rvb = new ReverbIR;
+							if (irfile == 0 || rvb->LoadImpulse(irfile, 1.0, FrqValue(irlen)) != 0)
+							{
+								fprintf(stderr, "Cannot load impulse response '%s'\n", irfile ? irfile : "");
+								errcnt++;
+							}
+							delete irfile;
+							LoadFX(mixElem, rvb);
+						}
 						else if (mixElem->TagMatch("flanger"))
 						{
 							fxCount++;
@@ -522,8 +680,10 @@ public:
 					{
 						if (!silent)
 							fprintf(stdout, "Convert %s\n", fname);
+						clock_t t0 = clock();
 						if (cvt.Convert(fullPath, NULL))
 							errcnt++;
+						cvtTime += (double) (clock() - t0) / CLOCKS_PER_SEC;
 					}
 					else
 					{
@@ -622,7 +782,15 @@ public:
 		long pad;
 		if (!silent)
 			fprintf(stdout, "Generate sequence\n");
+		clock_t t0 = clock();
 		int errcnt = cvt.Generate();
+		if (bench)
+		{
+			// report score conversion time only, don't render
+			double genTime = (double) (clock() - t0) / CLOCKS_PER_SEC;
+			fprintf(stdout, "convert %.3f s, generate %.3f s\n", cvtTime, genTime);
+			return errcnt;
+		}
 		if (errcnt == 0 && outFile)
 		{
 			if (!silent)
@@ -647,7 +815,22 @@ public:
 			lastOOR = 0;
 			if (!silent)
 				seq.SetCB(Monitor, synthParams.isampleRate, (Opaque)this);
-			int n = seq.Sequence(mgr);
+			if (tickRes > 0)
+				seq.SetResolution(tickRes);
+			if (stems)
+			{
+				// Stems render each track or channel on its own
+				// thread. All tracks are played so that each one
+				// has its stem. The sequencer renders stems in
+				// blocks of MAX_BLKLEN frames, split only where
+				// an event starts, whatever the resolution.
+				seq.SetBlockMode(1);
+				seq.SetThreads(thrds);
+				seq.SetStems(stems, StemOut, (Opaque)this);
+				seq.SequenceMulti(mgr);
+			}
+			else
+				seq.Sequence(mgr);
 			pad = (long) (synthParams.isampleRate * tail);
 			while (pad-- > 0)
 			{
@@ -658,6 +841,7 @@ public:
 				wvf32.CloseWaveFile();
 			else
 				wvf.CloseWaveFile();
+			CloseStems();
 			if (!silent)
 			{
 				lastOOR = wvp->GetOOR() - lastOOR;
@@ -702,14 +886,19 @@ int main(int argc, char *argv[])
 
 	if (argc < 2)
 	{
-		fprintf(stderr, "use: BSynth [-s] project\n");
+		fprintf(stderr, "use: BSynth [-s] [-b] project\n");
+		fprintf(stderr, "  -s  silent\n");
+		fprintf(stderr, "  -b  time score conversion only, no wave output\n");
 	}
 	else
 	{
 		int i = 1;
-		if (strcmp(argv[1], "-s") == 0)
+		while (i < argc - 1 && argv[i][0] == '-')
 		{
-			prj.silent = 1;
+			if (strcmp(argv[i], "-s") == 0)
+				prj.silent = 1;
+			else if (strcmp(argv[i], "-b") == 0)
+				prj.bench = 1;
 			i++;
 		}
 		prj.Init();
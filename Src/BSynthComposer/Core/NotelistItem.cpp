@@ -97,10 +97,173 @@ int NotelistItem::Convert(nlConverter& cvt)
 	return ret;
 }
 
+// Converter used for separate files. Generated events are
+// kept on the item rather than added to the sequencer.
+class nlCacheConverter : public nlConverter
+{
+public:
+	NotelistItem *itm;
+
+	virtual void AddEvent(SeqEvent *evt)
+	{
+		itm->AddCache(evt);
+	}
+};
+
+static bsUint32 HashBytes(bsUint32 h, const void *p, size_t n)
+{
+	const bsUint8 *bp = (const bsUint8 *) p;
+	while (n-- > 0)
+		h = (h ^ *bp++) * 16777619U;
+	return h;
+}
+
+int NotelistItem::ConvertSeparate(bsUint32 env)
+{
+	ErrCB cb;
+	cb.itm = this;
+	bsString msg;
+
+	ClearErrors();
+	if (!useThis)
+	{
+		msg = "Skipping ";
+		msg += name;
+		msg += " ...";
+		cb.OutputMessage(msg);
+		return 0;
+	}
+
+	bsString text;
+	FileMap map;
+	const char *txtPtr = "";
+	size_t txtLen = 0;
+	if (editor)
+	{
+		((TextEditor*)editor)->GetText(text);
+		txtPtr = text;
+		txtLen = text.Length();
+	}
+	else
+	{
+		theProject->FindOnPath(fullPath, file);
+		if (map.MapOpen(fullPath) == 0)
+		{
+			txtPtr = (const char *) map.GetData();
+			txtLen = map.GetSize();
+		}
+	}
+
+	bsUint32 key = HashBytes(env, txtPtr, txtLen);
+	if (cacheHead && key == cacheKey)
+	{
+		msg = "Reusing ";
+		msg += name;
+		msg += " ...";
+		cb.OutputMessage(msg);
+		PlayCache(&theProject->mgr, &theProject->seq);
+		return 0;
+	}
+
+	msg = "Converting ";
+	msg += name;
+	msg += " ...";
+	cb.OutputMessage(msg);
+
+	ClearCache();
+	nlCacheConverter cvt;
+	cvt.itm = this;
+	cvt.SetInstrManager(&theProject->mgr);
+	cvt.SetSequencer(&theProject->seq);
+	cvt.SetSampleRate(synthParams.sampleRate);
+	cvt.SetDebugLevel(dbgLevel);
+	cvt.SetErrorCallback(&cb);
+	nlLexFileMem lex(txtPtr, txtLen);
+	int ret = cvt.Convert(name, &lex);
+	if (ret == 0)
+		ret = cvt.Generate();
+	cvt.SetErrorCallback(0);
+	if (ret != 0)
+	{
+		ClearCache();
+		return ret;
+	}
+	cacheKey = key;
+	PlayCache(&theProject->mgr, &theProject->seq);
+	return 0;
+}
+
+void NotelistItem::AddCache(SeqEvent *evt)
+{
+	evt->next = 0;
+	evt->prev = cacheTail;
+	if (cacheTail)
+		cacheTail->next = evt;
+	else
+		cacheHead = evt;
+	cacheTail = evt;
+	cacheCount++;
+}
+
+void NotelistItem::ClearCache()
+{
+	SeqEvent *evt;
+	while ((evt = cacheHead) != 0)
+	{
+		cacheHead = evt->next;
+		evt->Destroy();
+	}
+	cacheTail = 0;
+	cacheCount = 0;
+}
+
+// Add copies of the kept events to the sequencer. The sequencer
+// numbers events from 1 on each run, so event IDs are assigned
+// again. Events that shared an ID (ties, parameter changes) 
+// still share the new ID.
+void NotelistItem::PlayCache(InstrManager *mgr, Sequencer *seq)
+{
+	long mapSize = 16;
+	while (mapSize < cacheCount * 2)
+		mapSize *= 2;
+	bsInt32 *oldID = new bsInt32[mapSize];
+	bsInt32 *newID = new bsInt32[mapSize];
+	for (long n = 0; n < mapSize; n++)
+		oldID[n] = -1;
+
+	SeqEvent *src;
+	for (src = cacheHead; src; src = src->next)
+	{
+		SeqEvent *evt;
+		if (src->type == SEQEVT_CONTROL)
+			evt = new ControlEvent;
+		else if (src->type == SEQEVT_STARTTRACK || src->type == SEQEVT_STOPTRACK)
+			evt = new TrackEvent;
+		else
+			evt = mgr->ManufEvent(src->inum);
+		evt->CopyEvent(src);
+		evt->SetType(src->type);
+
+		long ndx = (long) ((bsUint32) src->evid * 2654435761U) & (mapSize - 1);
+		while (oldID[ndx] != -1 && oldID[ndx] != src->evid)
+			ndx = (ndx + 1) & (mapSize - 1);
+		if (oldID[ndx] == -1)
+		{
+			oldID[ndx] = src->evid;
+			newID[ndx] = seq->NextEventID();
+		}
+		evt->SetID(newID[ndx]);
+		seq->AddEvent(evt);
+	}
+	delete[] oldID;
+	delete[] newID;
+}
+
 int NotelistItem::Load(XmlSynthElem *node)
 {
 	FileItem::Load(node);
 	node->GetAttribute("dbg", dbgLevel);
+	node->GetAttribute("sep", separate);
 	if (name.Length() == 0)
 		name = file;
 	return 0;
@@ -110,6 +273,7 @@ int NotelistItem::Save(XmlSynthElem *node)
 {
 	FileItem::Save(node);
 	node->SetAttribute("dbg", dbgLevel);
+	node->SetAttribute("sep", separate);
 	return 0;
 }
 
@@ -156,6 +320,19 @@ ScoreError* NotelistItem::EnumErrors(ScoreError *e)
 
 int NotelistList::Convert(nlConverter& cvt)
 {
+	// Kept events from separate files are only valid for the
+	// same sample rate and instrument numbers, names and types.
+	bsUint32 env = 2166136261U;
+	env = HashBytes(env, &synthParams.sampleRate, sizeof(synthParams.sampleRate));
+	InstrConfig *ic = 0;
+	while ((ic = theProject->mgr.EnumInstr(ic)) != 0)
+	{
+		env = HashBytes(env, &ic->inum, sizeof(ic->inum));
+		env = HashBytes(env, (const char *) ic->name, ic->name.Length()+1);
+		if (ic->instrType)
+			env = HashBytes(env, (const char *) ic->instrType->itype, ic->instrType->itype.Length()+1);
+	}
+
 	int err = 0;
 	ProjectItem *pi = prjTree->FirstChild(this);
 	while (pi)
@@ -163,7 +340,10 @@ int NotelistList::Convert(nlConverter& cvt)
 		if (pi->GetType() == PRJNODE_NOTEFILE)
 		{
 			NotelistItem *nl = (NotelistItem *) pi;
-			err |= nl->Convert(cvt);
+			if (nl->GetSeparate())
+				err |= nl->ConvertSeparate(env);
+			else
+				err |= nl->Convert(cvt);
 		}
 		pi = prjTree->NextSibling(pi);
 	}
@@ -273,12 +273,25 @@ public:
 };
 
 /// A notelist score file.
+/// Normally all score files are converted together so that
+/// they share variables, sequences and voices. A file marked
+/// as separate is converted by itself instead, and the events
+/// it generates are kept. The events are reused until the
+/// text of the file, the sample rate, or the instrument
+/// numbers, names or types change.
 class NotelistItem : public FileItem
 {
 private:
 	ScoreError *errFirst;
 	ScoreError *errLast;
 	short dbgLevel;
+	short separate;
+	bsUint32 cacheKey;
+	SeqEvent *cacheHead;
+	SeqEvent *cacheTail;
+	long cacheCount;
+
+	void PlayCache(InstrManager *mgr, Sequencer *seq);
 
 public:
 	NotelistItem() : FileItem(PRJNODE_NOTEFILE)
@@ -286,6 +299,11 @@ public:
 		errFirst = 0;
 		errLast = 0;
 		dbgLevel = 0;
+		separate = 0;
+		cacheKey = 0;
+		cacheHead = 0;
+		cacheTail = 0;
+		cacheCount = 0;
 		actions  = ITM_ENABLE_EDIT
 				 | ITM_ENABLE_CLOSE
 				 | ITM_ENABLE_SAVE
@@ -297,10 +315,13 @@ public:
 	~NotelistItem()
 	{
 		ClearErrors();
+		ClearCache();
 	}
 
 	inline void SetDebug(short d) { dbgLevel = d; }
 	inline short GetDebug() { return dbgLevel; }
+	inline void SetSeparate(short s) { separate = s; }
+	inline short GetSeparate() { return separate; }
 
 	virtual int CopyItem();
 
@@ -309,6 +330,13 @@ public:
 	void ClearErrors();
 	int SyntaxCheck();
 	int Convert(nlConverter& cvt);
+	/// Convert a separate file, or reuse the kept events.
+	/// @param env hash of the instrument configuration
+	int ConvertSeparate(bsUint32 env);
+	/// Keep a generated event.
+	void AddCache(SeqEvent *evt);
+	/// Discard the kept events.
+	void ClearCache();
 	int Load(XmlSynthElem *node);
 	int Save(XmlSynthElem *node);
 };
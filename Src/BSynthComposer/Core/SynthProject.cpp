@@ -60,6 +60,7 @@ void SynthProject::Init()
 	prjMidiIn.SetSequenceInfo(&seq, &mgr);
 	prjMidiIn.SetDevice(prjOptions.midiDevice, prjOptions.midiDeviceName);
 	seq.SetResolution(prjOptions.tickRes);
+	seq.SetChase(SEQ_CHASE_CTL|SEQ_CHASE_NOTES);
 
 	InstrMapEntry *ime;
 	if (prjOptions.inclInstr & 0x001)
@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////
+/// @file Convolve.cpp Partitioned FFT convolution.
+//
+// BasicSynth
+//
+// ConvolveFFT - the first partition of the impulse response is
+// applied sample by sample, later partitions once per block in
+// the frequency domain (overlap-save).
+//
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SynthDefs.h>
+#include <Convolve.h>
+
+void ConvolveFFT::Clear()
+{
+	delete[] head;
+	delete[] inBuf;
+	delete[] outBuf;
+	delete[] spcH;
+	delete[] spcX;
+	delete[] work;
+	head = 0;
+	inBuf = 0;
+	outBuf = 0;
+	spcH = 0;
+	spcX = 0;
+	work = 0;
+	fft.Clear();
+	impLen = 0;
+	blkLen = 0;
+	fftLen = 0;
+	headLen = 0;
+	tailCnt = 0;
+	inPos = 0;
+	fdlPos = 0;
+}
+
+int ConvolveFFT::InitConvolve(int len, int blk)
+{
+	Clear();
+	if (len <= 0)
+		return -1;
+
+	// The direct partition costs B operations per sample and
+	// the FFT partitions about 2L/B, so B near sqrt(2L) is
+	// the least total work.
+	if (blk <= 0)
+	{
+		blk = 64;
+		while (blk < 1024 && (blk * blk) < (len * 2))
+			blk *= 2;
+	}
+	if (blk < 2 || (blk & (blk - 1)) != 0)
+		return -1;
+
+	impLen = len;
+	blkLen = blk;
+	fftLen = blk * 2;
+	headLen = len < blk ? len : blk;
+	tailCnt = (len - headLen + blk - 1) / blk;
+	if (fft.Init(fftLen) != 0)
+	{
+		Clear();
+		return -1;
+	}
+
+	head = new AmpValue[blkLen];
+	inBuf = new AmpValue[fftLen];
+	outBuf = new AmpValue[blkLen];
+	work = new AmpValue[fftLen];
+	memset(head, 0, blkLen*sizeof(AmpValue));
+	if (tailCnt > 0)
+	{
+		spcH = new AmpValue[tailCnt*fftLen];
+		spcX = new AmpValue[tailCnt*fftLen];
+		memset(spcH, 0, tailCnt*fftLen*sizeof(AmpValue));
+	}
+	Reset();
+	return 0;
+}
+
+void ConvolveFFT::SetImpulse(const AmpValue *imp)
+{
+	if (impLen <= 0)
+		return;
+
+	memcpy(head, imp, headLen*sizeof(AmpValue));
+	for (int k = 0; k < tailCnt; k++)
+	{
+		AmpValue *hp = &spcH[k*fftLen];
+		int off = (k + 1) * blkLen;
+		int cnt = impLen - off;
+		if (cnt > blkLen)
+			cnt = blkLen;
+		memcpy(hp, &imp[off], cnt*sizeof(AmpValue));
+		memset(&hp[cnt], 0, (fftLen-cnt)*sizeof(AmpValue));
+		fft.Forward(hp);
+	}
+}
+
+void ConvolveFFT::Reset()
+{
+	if (impLen <= 0)
+		return;
+	memset(inBuf, 0, fftLen*sizeof(AmpValue));
+	memset(outBuf, 0, blkLen*sizeof(AmpValue));
+	if (tailCnt > 0)
+		memset(spcX, 0, tailCnt*fftLen*sizeof(AmpValue));
+	inPos = 0;
+	fdlPos = 0;
+}
+
+// Called when an input block is complete. The spectrum of the
+// last two blocks goes into the delay line, and partition k+1
+// is applied to the spectrum from k blocks ago. The last half of
+// the inverse transform is the FFT partition output for the next block.
+void ConvolveFFT::Block()
+{
+	if (tailCnt > 0)
+	{
+		if (++fdlPos >= tailCnt)
+			fdlPos = 0;
+		AmpValue *xp = &spcX[fdlPos*fftLen];
+		memcpy(xp, inBuf, fftLen*sizeof(AmpValue));
+		fft.Forward(xp);
+
+		memset(work, 0, fftLen*sizeof(AmpValue));
+		int n = fdlPos;
+		for (int k = 0; k < tailCnt; k++)
+		{
+			fft.MulAdd(work, &spcH[k*fftLen], &spcX[n*fftLen]);
+			if (--n < 0)
+				n = tailCnt - 1;
+		}
+		fft.Inverse(work);
+		memcpy(outBuf, &work[blkLen], blkLen*sizeof(AmpValue));
+	}
+	memcpy(inBuf, &inBuf[blkLen], blkLen*sizeof(AmpValue));
+	inPos = 0;
+}
@@ -52,6 +52,7 @@ static int ReadChunk(FileReadBuf& file, dlsChunk& chk)
 DLSFile::DLSFile()
 {
 	preload = 1;
+	mapped = 0;
 }
 
 DLSFile::~DLSFile()
@@ -80,9 +81,10 @@ int DLSFile::IsDLSFile(const char *fname)
 	return isDLS;
 }
 
-SoundBank *DLSFile::LoadSoundBank(const char *fname, int pre)
+SoundBank *DLSFile::LoadSoundBank(const char *fname, int pre, int map)
 {
 	preload = pre;
+	mapped = map;
 
 	file.SetBufSize(0x10000);
 	if (file.FileOpen(fname))
@@ -564,6 +566,7 @@ SoundBank *DLSFile::BuildSoundBank(const char *fname)
 	SoundBank *sbnk = new SoundBank;
 
 	sbnk->file = fname;
+	sbnk->mapSamples = mapped;
 	sbnk->info.wMajorFile = info.vers.dwVersionMS >> 16;
 	sbnk->info.wMinorFile = info.vers.dwVersionMS & 0xffff;
 	sbnk->info.wMajorVer = info.vers.dwVersionLS >> 16;
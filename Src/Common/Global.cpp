@@ -9,23 +9,70 @@
 // (http://www.gnu.org/licenses/gpl.html)
 /////////////////////////////////////////////////////////////////
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <SynthDefs.h>
 #include <WaveTable.h>
 #include <SynthFile.h>
+#include <Mixer.h>
 
-SynthConfig synthParams;
 WaveTableSet wtSet;
+SynthContext synthParams(&wtSet);
+
+static thread_local SynthContext *curContext = 0;
+static thread_local MixBus *curBus = 0;
 
 int InitSynthesizer(bsInt32 sr, bsInt32 wtlen, bsInt32 wtusr)
 {
-	synthParams.Init(sr, wtlen);
-	wtSet.Init(wtusr);
+	return synthParams.InitContext(sr, wtlen, wtusr);
+}
+
+SynthContext::~SynthContext()
+{
+	if (ownWT)
+		delete wt;
+}
+
+int SynthContext::InitContext(bsInt32 sr, bsInt32 wtlen, bsInt32 wtusr)
+{
+	Init(sr, wtlen);
+	if (wt == 0)
+	{
+		wt = new WaveTableSet;
+		ownWT = 1;
+	}
+	wt->Init(wtusr, this);
 	for (int wtNdx = WT_USR(0); wtNdx < WT_USR(wtusr); wtNdx++)
-		wtSet.wavSet[wtNdx].wavID = wtNdx;
+		wt->wavSet[wtNdx].wavID = wtNdx;
 	return 0;
 }
 
+SynthContext *SynthContext::Current()
+{
+	if (curContext)
+		return curContext;
+	return &synthParams;
+}
+
+SynthContext *SynthContext::MakeCurrent(SynthContext *ctx)
+{
+	SynthContext *prev = Current();
+	curContext = ctx;
+	return prev;
+}
+
+MixBus *MixBus::Current()
+{
+	return curBus;
+}
+
+MixBus *MixBus::MakeCurrent(MixBus *bus)
+{
+	MixBus *prev = curBus;
+	curBus = bus;
+	return prev;
+}
+
 int SynthConfig::FindOnPath(bsString& fullPath, const char *fname)
 {
 	if (fname == 0 || *fname == '\0')
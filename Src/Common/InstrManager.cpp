@@ -13,9 +13,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <new>
 #include <SynthDefs.h>
 #include <SynthString.h>
 #include <SynthMutex.h>
+#include <SynthThread.h>
 #include <WaveTable.h>
 #include <WaveFile.h>
 #include <Mixer.h>
@@ -90,6 +92,7 @@ InstrConfig *InstrManager::LoadInstr(XmlSynthElem *instr)
 		instTyp = FindType(type);
 		if (instTyp)
 		{
+			SynthContext *prev = SynthContext::MakeCurrent(ctx);
 			if (instTyp->manufTmplt)
 				tp = instTyp->manufTmplt(instr);
 			else if (instTyp->manufInstr)
@@ -101,6 +104,7 @@ InstrConfig *InstrManager::LoadInstr(XmlSynthElem *instr)
 			}
 			else
 				tp = 0;
+			SynthContext::MakeCurrent(prev);
 			instr->GetAttribute("id", inum);
 			instEnt = AddInstrument(inum, instTyp, tp);
 			if (instEnt)
@@ -138,12 +142,12 @@ int InstrManager::LoadWavetable(XmlSynthElem *wvnode)
 
 	if (wvnode->GetAttribute("id", wvID) == 0)
 	{
-		wvNdx = wtSet.FindWavetable(wvID);
+		wvNdx = ctx->wt->FindWavetable(wvID);
 		if (wvNdx == -1)
 		{
-			wvNdx = wtSet.GetFreeWavetable(wvID);
+			wvNdx = ctx->wt->GetFreeWavetable(wvID);
 			if (wvNdx == -1)
-				wvNdx = wtSet.wavTblMax;
+				wvNdx = ctx->wt->wavTblMax;
 		}
 	}
 	else
@@ -153,9 +157,9 @@ int InstrManager::LoadWavetable(XmlSynthElem *wvnode)
 		wvID = wvNdx;
 	}
 
-	if (wvNdx >= wtSet.wavTblMax)
-		wtSet.SetMax(wvNdx+4);
-	wtSet.wavSet[wvNdx].wavID = wvID;
+	if (wvNdx >= ctx->wt->wavTblMax)
+		ctx->wt->SetMax(wvNdx+4);
+	ctx->wt->wavSet[wvNdx].wavID = wvID;
 
 	wvnode->GetAttribute("gibbs", gibbs);
 	mult = new bsInt32[wvParts];
@@ -194,9 +198,9 @@ int InstrManager::LoadWavetable(XmlSynthElem *wvnode)
 	}
 
 	if (sumParts == 1)
-		wtSet.SetWaveTable(wvNdx, ptndx, mult, amps, phs, gibbs);
+		ctx->wt->SetWaveTable(wvNdx, ptndx, mult, amps, phs, gibbs);
 	else if (sumParts == 2)
-		wtSet.SegWaveTable(wvNdx, ptndx, phs, amps);
+		ctx->wt->SegWaveTable(wvNdx, ptndx, phs, amps);
 
 	delete[] mult;
 	delete[] amps;
@@ -288,3 +292,124 @@ void InstrManager::ExclNoteOff(int index, Instrument *ip)
 		exclNotes[index] = 0;
 }
 
+
+// Voice arena used by Instrument::operator new/delete.
+// Each size class is a free list of slots carved from chunks.
+// Slots are rounded to the cache line so that a voice never
+// shares a line with its neighbor. Sizes are matched exactly,
+// which in practice gives one class per instrument type.
+// When the class table is full, or an object is very large,
+// the global heap is used. That choice depends only on the
+// size and the (grow-only) table, so delete finds the same
+// answer as new did.
+#define ARENA_LINE 64
+#define ARENA_CLASSES 32
+#define ARENA_CHUNK 16384
+#define ARENA_MAXOBJ 65536
+
+struct ArenaClass
+{
+	size_t size;
+	void *free;
+};
+
+static ArenaClass arenaClass[ARENA_CLASSES];
+static int arenaCount = 0;
+static volatile int arenaLock = 0;
+
+// The lock is only held to unlink or link a slot, or to carve
+// a new chunk. A thread that finds it taken retries a few times,
+// then yields so that it does not keep the owner from running.
+#define ARENA_SPIN 64
+
+static void ArenaEnter()
+{
+	int spin = 0;
+	while (!SynthAtomic::CompareExchange(&arenaLock, 0, 1))
+	{
+		if (++spin >= ARENA_SPIN)
+			SynthThread::YieldThread();
+	}
+}
+
+static void ArenaLeave()
+{
+	SynthAtomic::Store(&arenaLock, 0);
+}
+
+static ArenaClass *ArenaFind(size_t size, int add)
+{
+	if (size > ARENA_MAXOBJ)
+		return 0;
+	size = (size + ARENA_LINE - 1) & ~(size_t)(ARENA_LINE - 1);
+	for (int n = 0; n < arenaCount; n++)
+	{
+		if (arenaClass[n].size == size)
+			return &arenaClass[n];
+	}
+	if (!add || arenaCount >= ARENA_CLASSES)
+		return 0;
+	ArenaClass *ac = &arenaClass[arenaCount++];
+	ac->size = size;
+	ac->free = 0;
+	return ac;
+}
+
+// Carve a new chunk into slots and put them on the free list.
+static int ArenaGrow(ArenaClass *ac)
+{
+	size_t slots = ARENA_CHUNK / ac->size;
+	if (slots < 4)
+		slots = 4;
+	char *mem = (char *) malloc(slots * ac->size + ARENA_LINE);
+	if (mem == 0)
+		return 0;
+	char *slot = (char *) (((size_t) mem + ARENA_LINE - 1) & ~(size_t)(ARENA_LINE - 1));
+	// link in reverse so the first allocation takes the lowest address
+	slot += (slots - 1) * ac->size;
+	while (slots-- > 0)
+	{
+		*(void **) slot = ac->free;
+		ac->free = slot;
+		slot -= ac->size;
+	}
+	return 1;
+}
+
+void *Instrument::operator new(size_t size)
+{
+	void *ptr = 0;
+	ArenaEnter();
+	ArenaClass *ac = ArenaFind(size, 1);
+	if (ac && (ac->free || ArenaGrow(ac)))
+	{
+		ptr = ac->free;
+		ac->free = *(void **) ptr;
+	}
+	ArenaLeave();
+	if (ac == 0)
+		ptr = ::operator new(size);
+	else if (ptr == 0)
+	{
+		// A heap block cannot be used here since delete will put
+		// it on the free list of the size class.
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void Instrument::operator delete(void *ptr, size_t size)
+{
+	if (ptr == 0)
+		return;
+	ArenaEnter();
+	ArenaClass *ac = ArenaFind(size, 0);
+	if (ac)
+	{
+		*(void **) ptr = ac->free;
+		ac->free = ptr;
+	}
+	ArenaLeave();
+	if (ac == 0)
+		::operator delete(ptr);
+}
@@ -138,8 +138,9 @@ void MIDIInput::SysExBuffer(bsUint32 len)
 
 // The event IDS are calculated to allow overlapping note-on/note-off events.
 // The first note off will always match the first note on for a key+channel
-// value. The MSB is set on the id to distinguish it from a normal sequencer
-// event ID.
+// value. The MSB (SEQ_EVID_MIDI) is set on the id to distinguish it from a
+// normal sequencer event ID. The sequencer indexes these IDs by channel
+// and key so that the note-off finds its note directly.
 void MIDIInput::ReceiveMessage(bsUint16 mmsg, bsUint16 val1, bsUint16 val2, bsUint32 ts)
 {
 	if (!seq || !(seq->GetState() & seqPlay) || !inmgr)
@@ -157,15 +158,15 @@ void MIDIInput::ReceiveMessage(bsUint16 mmsg, bsUint16 val1, bsUint16 val2, bsUi
 		if (val2 != 0)
 		{
 			type = SEQEVT_START;
-			id = ++noteOn[val1];
+			id = ++noteOn[chnl][val1];
 		}
 		else
 		{
 	case MIDI_NOTEOFF:
 			type = SEQEVT_STOP;
-			id = ++noteOff[val1];
+			id = ++noteOff[chnl][val1];
 		}
-		id = (id & 0xff) | 0x80000000 | (chnl << 16) | (val1 << 8);
+		id = (id & 0xff) | SEQ_EVID_MIDI | (chnl << 16) | (val1 << 8);
 		nevt = (NoteEvent *)inmgr->ManufEvent(inum);
 		nevt->SetType(type);
 		nevt->SetID(id);
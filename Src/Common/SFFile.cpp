@@ -21,6 +21,7 @@
 SFFile::SFFile()
 {
 	preload = 1;
+	mapped = 0;
 
 	file.SetBufSize(0x10000);
 	npresets = 0;
@@ -83,9 +84,10 @@ int SFFile::IsSF2File(const char *fname)
 	return isSF2;
 }
 
-SoundBank *SFFile::LoadSoundBank(const char *fname, int pre)
+SoundBank *SFFile::LoadSoundBank(const char *fname, int pre, int map)
 {
 	preload = pre;
+	mapped = map;
 
 	if (file.FileOpen(fname))
 		return 0;
@@ -109,6 +111,7 @@ SoundBank *SFFile::LoadSoundBank(const char *fname, int pre)
 
 	sfbnk = new SoundBank;
 	sfbnk->file = fname;
+	sfbnk->mapSamples = mapped;
 	sampleFileOffs1 = 0;
 	sampleFileOffs2 = 0;
 
@@ -399,8 +402,9 @@ SBSample *SFFile::CreateSample(sfSample *shdr, short id)
 	samp->filepos = sampleFileOffs1 + (shdr->dwStart * 2);
 	if (sampleFileOffs2 != 0)
 	{
+		// sm24 chunk holds the low byte of each 24-bit sample
 		samp->format = 3;
-		samp->filepos = sampleFileOffs2 + shdr->dwStart;
+		samp->filepos2 = sampleFileOffs2 + shdr->dwStart;
 	}
 	else
 		samp->format = 1;
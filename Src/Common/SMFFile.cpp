@@ -27,17 +27,13 @@
 
 void SMFFile::Reset()
 {
-	trackList.Clear();
+	CloseFile();
 	hdr.format = 1;  // SMF type 1 (multiple tracks)
 	hdr.numTrk = 0;
 	hdr.tmDiv = 24;
-	lastMsg = 0;
-	inpBuf = 0;
-	inpPos = 0;
-	inpEnd = 0;
 	ppqn = 24.0e6;
 	// tempo: quarter = 60, 24ppqn
-	srTicks = (0.5 * synthParams.sampleRate) / 24.0;
+	srTicks = (0.5 * SynthContext::Current()->sampleRate) / 24.0;
 	trackObj = 0;
 	instrMap = 0;
 	seq = 0;
@@ -61,138 +57,116 @@ int SMFFile::LoadFile(const char *file)
 {
 	CloseFile();
 
-	if (fp.FileOpen(file))
+	if (fmap.MapOpen(file))
 		return -1;
 
-	bsUint32 trkSize;
-	if (fp.FileRead(&hdr.chnkID, 4) != 4
-	 || hdr.chnkID != SMF_MTHD_CHUNK)
+	const bsUint8 *inp = fmap.GetData();
+	const bsUint8 *end = inp + fmap.GetSize();
+
+	if (end - inp < 14)
+	{
+		CloseFile();
+		return -1;
+	}
+	memcpy(&hdr.chnkID, inp, 4);
+	if (hdr.chnkID != SMF_MTHD_CHUNK)
 	{
 		CloseFile();
 		return -1;
 	}
 
-	hdr.size = ReadLong();
+	hdr.size = ReadLong(inp+4);
 	if (hdr.size != 6)
 	{
 		CloseFile();
 		return -1;
 	}
 
-	hdr.format = ReadShort();
-	hdr.numTrk = ReadShort();
-	hdr.tmDiv = ReadShort();
+	hdr.format = ReadShort(inp+8);
+	hdr.numTrk = ReadShort(inp+10);
+	hdr.tmDiv = ReadShort(inp+12);
 	if (hdr.tmDiv & 0x8000)
 	{
 		// SMTPE - punt for now
 		CloseFile();
 		return -2;
 	}
+	inp += 14;
 
 	ppqn = ((double) hdr.tmDiv * 1.0e6);
 
 	bsUint32 chnkID;
+	bsUint32 trkSize;
 	int err = 0;
 	bsUint16 trkNum = 0;
 	while (trkNum < hdr.numTrk)
 	{
-		if (fp.FileRead(&chnkID, 4) != 4)
+		if (end - inp < 8)
 			break;
-
-		trkSize = ReadLong();
-		if (chnkID != SMF_MTRK_CHUNK)
-		{
-			// Ignore anythnig but MTrk chunks
-			fp.FileSkip(trkSize);
-			continue;
-		}
-
-		// Read in the track data
-		inpBuf = new bsUint8[trkSize];
-		if (inpBuf == NULL)
+		memcpy(&chnkID, inp, 4);
+		trkSize = ReadLong(inp+4);
+		inp += 8;
+		if (trkSize > (bsUint32) (end - inp))
 		{
 			err = -1;
 			break;
 		}
-
-		if ((bsUint32)fp.FileRead(inpBuf, trkSize) != trkSize)
+		if (chnkID != SMF_MTRK_CHUNK)
 		{
-			err = -1;
-			break;
+			// Ignore anythnig but MTrk chunks
+			inp += trkSize;
+			continue;
 		}
 
-		inpPos = inpBuf;
-		inpEnd = inpBuf + trkSize;
-		lastMsg = 0;
+		// The events are decoded from the mapping when the
+		// sequence is generated. Here we only pick up the
+		// information that is available before generating.
 		trackObj = AddTrack(trkNum);
-
-		while (inpPos < inpEnd)
+		trackObj->SetData(inp, trkSize);
+		MIDIEvent *evt;
+		while ((evt = trackObj->ReadEvent()) != 0)
 		{
-			deltaT = GetVarLen();
-			bsUint16 msg = *inpPos;
-			if ((msg & MIDI_EVTMSK) == MIDI_SYSEX)
-			{
-				inpPos++;
-				if (msg == MIDI_META)
-					MetaEvent();
-				else
-					SysCommon(msg);
-			}
-			else
+			if (evt->mevent == MIDI_META)
 			{
-				if (msg & MIDI_MSGBIT)
-				{
-					inpPos++;
-					lastMsg = msg;
-				}
-				else
-					msg = lastMsg;
-				ChnlMessage(msg);
+				if (evt->chan == MIDI_META_EOT)
+					break;
+				MetaEvent(evt->chan, trackObj->evtData, trackObj->evtLen);
 			}
+			else if (evt->mevent == MIDI_SYSEX)
+				SysCommon(evt->mevent, trackObj->evtData, trackObj->evtLen);
 		}
-
-		delete inpBuf;
-		inpBuf = NULL;
-		inpPos = NULL;
-		inpEnd = NULL;
+		inp += trkSize;
 		trkNum++;
 	}
 
-	CloseFile();
 	return err;
 }
 
-void SMFFile::MetaEvent()
+void SMFFile::MetaEvent(bsUint16 meta, const bsUint8 *data, bsUint32 len)
 {
 	static const char *flats[]  = {"C", "F", "Bb", "Eb", "Ab", "Db", "Gb", "Cb"};
 	static const char *sharps[] = {"C", "G", "D",  "A",  "E",  "B",  "F#", "C#"};
 
-	bsUint16 meta = *inpPos++;
-	bsUint32 metaLen = GetVarLen();
-
-	MIDIEvent *evt = new MIDIEvent;
-	evt->deltat = (bsUint32) deltaT;
-	evt->mevent = MIDI_META;
-	evt->chan = meta;
-
 	bsUint16 val, val2, val3, val4;
 
 	switch (meta)
 	{
 	case MIDI_META_TEXT:
-		ReadString(metaText, metaLen);
+		ReadString(metaText, data, len);
 		break;
 	case MIDI_META_CPYR:
-		ReadString(metaCpyr, metaLen);
+		ReadString(metaCpyr, data, len);
 		break;
 	case MIDI_META_TRK:
-		ReadString(metaSeqName, metaLen);
+		ReadString(metaSeqName, data, len);
 		break;
 	case MIDI_META_TMSG:
-		val  = *inpPos++;
-		val2 = *inpPos++;
-		val3 = *inpPos++;
-		val4 = *inpPos++;
+		if (len < 4)
+			break;
+		val  = data[0];
+		val2 = data[1];
+		val3 = data[2];
+		val4 = data[3];
 		timeSigNum = val;
 		timeSigDiv = val2;
 		timeSigBeat = val3;
@@ -205,108 +179,156 @@ void SMFFile::MetaEvent()
 		IntToStr(timeSig, val4);
 		break;
 	case MIDI_META_KYSG:
-		val  = *inpPos++;
-		val2 = *inpPos++;
+		if (len < 2)
+			break;
+		val  = data[0];
+		val2 = data[1];
 		keySigKey = val;
 		keySigMaj = val2;
 		keySig += (val & 0x80) ? flats[(256-val)&7] : sharps[val&0x7];
 		keySig += ' ';
 		keySig += val2 ? "min." : "maj.";
 		break;
-	case MIDI_META_EOT:
-		// The TAIL of the event list already has the EOT meta event.
-		trackObj->EOTOffset(deltaT);
-		return;
-	case MIDI_META_TMPO:
-		evt->val1 = 0;
-		evt->val2 = 0;
-		evt->val3.lval = *inpPos++;
-		evt->val3.lval = (evt->val3.lval << 8) + *inpPos++;
-		evt->val3.lval = (evt->val3.lval << 8) + *inpPos++;
-		break;
-	case MIDI_META_INST:
-	case MIDI_META_LYRK:
-	case MIDI_META_MRKR:
-	case MIDI_META_CUE:
-	case MIDI_META_CHNL:
-	default:
-		inpPos += metaLen;
-		break;
 	}
-	trackObj->AddEvent(evt);
 }
 
-void SMFFile::SysCommon(bsUint16 msg)
+void SMFFile::SysCommon(bsUint16 msg, const bsUint8 *data, bsUint32 len)
 {
-	bsUint32 dataLen;
-	MIDIEvent *evt;
-	evt = new MIDIEvent;
-	evt->deltat = deltaT;
-	evt->mevent = msg;
-
-	switch (msg)
+	if (msg == MIDI_SYSEX && len >= 4)
 	{
-	case MIDI_SYSEX:
-		dataLen = GetVarLen();
-		if (*inpPos == 0x7E || *inpPos == 0x7F)
-		{
-			// universal system exclusive.
-			evt->val1 = inpPos[0];
-			evt->val2 = (inpPos[2] << 8) | inpPos[3];
-			if (inpPos[0] == 0x7E && inpPos[2] == 9) // GM level
-				gmbank = inpPos[3];
-		}
-		inpPos += dataLen;
-		break;
-	case MIDI_SNGPOS:
-		inpPos += 2;
-		break;
-	case MIDI_TMCODE:
-	case MIDI_SNGSEL:
-		inpPos += 1;
-		break;
-	case MIDI_TUNREQ:
-	case MIDI_ENDEX:
-	case MIDI_TMCLK:
-	case MIDI_START:
-	case MIDI_CONT:
-	case MIDI_STOP:
-	case MIDI_ACTSNS:
-		break;
-	default:
-		break;
+		// universal system exclusive.
+		if (data[0] == 0x7E && data[2] == 9) // GM level
+			gmbank = data[3];
 	}
-	trackObj->AddEvent(evt);
 }
 
-void SMFFile::ChnlMessage(bsUint16 msg)
+// Decode one event from the mapped track data.
+// Running status applies to channel messages. SYSEX and
+// META data is left in place and located by evtData/evtLen.
+// A truncated event ends the track.
+MIDIEvent *SMFTrack::ReadEvent()
 {
-	MIDIEvent *evt = new MIDIEvent;
-	evt->deltat = deltaT;
-	evt->mevent = msg & MIDI_EVTMSK;
-	evt->chan  = msg & MIDI_CHNMSK;
+	const bsUint8 *inp = inpPos;
+	const bsUint8 *end = inpEnd;
+	bsUint32 value;
+	bsUint8 by;
 
-	switch (msg & MIDI_EVTMSK)
+	if (inp >= end)
+		return 0;
+
+	MIDIEvent *evt = &evtCur;
+	value = 0;
+	do
 	{
-	case MIDI_NOTEOFF:
-	case MIDI_NOTEON:
-	case MIDI_KEYAT:
-	case MIDI_CTLCHG:
-	case MIDI_PWCHG:
-		evt->val1 = *inpPos++;
-		evt->val2 = *inpPos++;
-		break;
-	case MIDI_PRGCHG:
-	case MIDI_CHNAT:
-		evt->val1 = *inpPos++;
-		evt->val2 = 0;
-		break;
-	default:
-		delete evt;
-		return;
+		if (inp >= end)
+			return 0;
+		by = *inp++;
+		value = (value << 7) + (bsUint32) (by & 0x7F);
+	} while (by & 0x80);
+	evt->deltat = value;
+	if (inp >= end)
+	{
+		inpPos = end;
+		return 0;
 	}
 
-	trackObj->AddEvent(evt);
+	bsUint16 msg = *inp;
+	evt->val1 = 0;
+	evt->val2 = 0;
+	evt->val3.lval = 0;
+	evtData = 0;
+	evtLen = 0;
+	bsUint32 need = 0;
+	if ((msg & MIDI_EVTMSK) == MIDI_SYSEX)
+	{
+		inp++;
+		evt->mevent = msg;
+		evt->chan = 0;
+		if (msg == MIDI_META)
+		{
+			if (inp >= end)
+			{
+				inpPos = end;
+				return 0;
+			}
+			evt->chan = *inp++;
+		}
+		if (msg == MIDI_META || msg == MIDI_SYSEX || msg == MIDI_ENDEX)
+		{
+			value = 0;
+			do
+			{
+				if (inp >= end)
+				{
+					inpPos = end;
+					return 0;
+				}
+				by = *inp++;
+				value = (value << 7) + (bsUint32) (by & 0x7F);
+			} while (by & 0x80);
+			if (value > (bsUint32) (end - inp))
+			{
+				inpPos = end;
+				return 0;
+			}
+			evtData = inp;
+			evtLen = value;
+			inp += value;
+			if (msg == MIDI_META && evt->chan == MIDI_META_TMPO && value >= 3)
+				evt->val3.lval = ((bsUint32) evtData[0] << 16) | ((bsUint32) evtData[1] << 8) | evtData[2];
+			else if (msg == MIDI_SYSEX && value >= 4 && (evtData[0] == 0x7E || evtData[0] == 0x7F))
+			{
+				// universal system exclusive.
+				evt->val1 = evtData[0];
+				evt->val2 = (evtData[2] << 8) | evtData[3];
+			}
+		}
+		else if (msg == MIDI_SNGPOS)
+			need = 2;
+		else if (msg == MIDI_TMCODE || msg == MIDI_SNGSEL)
+			need = 1;
+	}
+	else
+	{
+		if (msg & MIDI_MSGBIT)
+		{
+			inp++;
+			lastMsg = msg;
+		}
+		else
+			msg = lastMsg;
+		evt->mevent = msg & MIDI_EVTMSK;
+		evt->chan  = msg & MIDI_CHNMSK;
+		switch (evt->mevent)
+		{
+		case MIDI_NOTEOFF:
+		case MIDI_NOTEON:
+		case MIDI_KEYAT:
+		case MIDI_CTLCHG:
+		case MIDI_PWCHG:
+			need = 2;
+			break;
+		case MIDI_PRGCHG:
+		case MIDI_CHNAT:
+			need = 1;
+			break;
+		}
+	}
+	if (need > (bsUint32) (end - inp))
+	{
+		inpPos = end;
+		return 0;
+	}
+	if (msg < MIDI_SYSEX)
+	{
+		// channel message values
+		if (need > 0)
+			evt->val1 = inp[0];
+		if (need > 1)
+			evt->val2 = inp[1];
+	}
+	inpPos = inp + need;
+	return evt;
 }
 
 int SMFFile::GenerateSeq(Sequencer *s, SMFInstrMap *map, SoundBank *sb, bsUint16 mask)
@@ -332,21 +354,51 @@ int SMFFile::GenerateSeq(Sequencer *s, SMFInstrMap *map, SoundBank *sb, bsUint16
 	}
 	chnlStatus[9].bank = 128; // FUNKY MIDI SMF STUFF
 
+	int numTrk = 0;
+	while ((tp = trackList.EnumItem(tp)) != 0)
+	{
+		if (tp->Start(this))
+			numTrk++;
+	}
+	SMFTrack **trkList = new SMFTrack*[numTrk+1];
+	numTrk = 0;
 	while ((tp = trackList.EnumItem(tp)) != 0)
-		tp->Start(this);
+	{
+		if (!tp->eot)
+			trkList[numTrk++] = tp;
+	}
 
+	// Merge the tracks. Each pass generates the events at the
+	// current time in track order and finds the earliest time
+	// of the next event on any track. The sample time is advanced
+	// one MIDI tick at a time so that tempo changes apply
+	// from the following tick.
+	bsUint32 midiTick = 0;
 	theTick = 0;
-	do
+	while (numTrk > 0)
 	{
-		trkNum = 0;
-		tp = 0;
-		while ((tp = trackList.EnumItem(tp)) != 0)
+		bsUint32 nextTick = 0xFFFFFFFF;
+		int live = 0;
+		for (trkNum = 0; trkNum < numTrk; trkNum++)
 		{
-			if (tp->Generate())
-				trkNum++;
+			tp = trkList[trkNum];
+			if (tp->evtTick == midiTick && !tp->Generate())
+				continue;
+			if (tp->evtTick < nextTick)
+				nextTick = tp->evtTick;
+			trkList[live++] = tp;
 		}
-		theTick += srTicks;
-	} while (trkNum > 0);
+		numTrk = live;
+		if (numTrk == 0)
+			break;
+		while (midiTick < nextTick)
+		{
+			theTick += srTicks;
+			midiTick++;
+		}
+	}
+	delete[] trkList;
+	theTick += srTicks;
 
 	theTick++;
 	for (ch = 0; ch < 16; ch++)
@@ -448,6 +500,10 @@ void SMFFile::NoteOff(short chnl, short key, short vel, short track)
 	evt->SetBank(cs->bank);
 	evt->SetPatch(cs->patch);
 	seq->AddEvent(evt);
+	// When the sound bank was opened without preloading, only
+	// the instruments the sequence plays are loaded.
+	if (sbnk)
+		sbnk->GetInstr(cs->bank, cs->patch, 1);
 	cs->count++;
 
 	if (explNoteOff)
@@ -471,7 +527,7 @@ void SMFFile::NoteOff(short chnl, short key, short vel, short track)
 
 void SMFFile::SetTempo(long val)
 {
-	srTicks = ((FrqValue)val * synthParams.sampleRate) / ppqn;
+	srTicks = ((FrqValue)val * SynthContext::Current()->sampleRate) / ppqn;
 }
 
 void SMFFile::ProgChange(short chnl, short val, short track)
@@ -574,7 +630,8 @@ int SMFTrack::Generate()
 {
 	if (eot || !smf)
 		return 0;
-	while (!eot && deltaTime == 0)
+	bsUint32 tick = evtTick;
+	do
 	{
 		short chan = evtLast->chan;
 		short val1 = evtLast->val1;
@@ -613,12 +670,13 @@ int SMFTrack::Generate()
 			}
 			break;
 		}
-		evtLast = evtLast->next;
-		if (evtLast) // sanity check, EOT should stop us before this point
-			deltaTime = evtLast->deltat;
-		else
+		// The end of the data without an EOT event ends the track.
+		if ((evtLast = NextEvent()) == 0)
+		{
 			eot = true;
-	}
-	deltaTime--;
+			return 0;
+		}
+		evtTick += evtLast->deltat;
+	} while (evtTick == tick);
 	return 1;
 }
@@ -16,6 +16,7 @@
 #include <SynthDefs.h>
 #include <SynthString.h>
 #include <SynthMutex.h>
+#include <SynthThread.h>
 #include <WaveTable.h>
 #include <WaveFile.h>
 #include <Mixer.h>
@@ -32,49 +33,429 @@
 
 void SeqTrack::Reset()
 {
-	SeqEvent *evt;
-	while ((evt = evtHead->next) != evtTail)
-	{
-		evt->Remove();
-		evt->Destroy();
-	}
-	evtLast = evtHead;
+	for (bsInt32 n = 0; n < evtCount; n++)
+		evtList[n]->Destroy();
+	if (evtAlloc)
+		delete[] evtList;
+	evtList = &evtTail;
+	evtCount = 0;
+	evtAlloc = 0;
+	evtPlay = 0;
+	evtSorted = 1;
 	seqLength = 0;
 }
 
+void SeqTrack::Reserve(bsInt32 count)
+{
+	if (count <= evtAlloc)
+		return;
+	SeqEvent **list = new SeqEvent*[count+1];
+	if (evtCount)
+		memcpy(list, evtList, evtCount * sizeof(SeqEvent*));
+	list[evtCount] = evtTail;
+	if (evtAlloc)
+		delete[] evtList;
+	evtList = list;
+	evtAlloc = count;
+}
+
 void SeqTrack::AddEvent(SeqEvent *evt)
 {
 	//printf("Add Event %d at time %d\n", evt->evid, evt->start);
-	if (evtLast == NULL)
-		evtLast = evtHead;
-	SeqEvent *inspt;
-	if (evt->start >= evtLast->start)
+	if (evtCount >= evtAlloc)
+		Reserve(evtAlloc ? evtAlloc * 2 : 256);
+	if (evtCount > 0 && evt->start < evtList[evtCount-1]->start)
+		evtSorted = 0;
+	evtList[evtCount++] = evt;
+	evtList[evtCount] = evtTail;
+	bsInt32 e = evt->start + evt->duration;
+	if (e >= seqLength)
+		seqLength = e+1;
+}
+
+// Sort the events by start time. This is a merge sort
+// so that events with the same start time keep their order.
+// The runs already in order are found first so that a track
+// built mostly in order only needs a few merge passes.
+void SeqTrack::Sort()
+{
+	if (evtSorted)
+		return;
+	evtSorted = 1;
+
+	bsInt32 *runs = new bsInt32[evtCount+1];
+	bsInt32 numRuns = 0;
+	bsInt32 n;
+	runs[numRuns++] = 0;
+	for (n = 1; n < evtCount; n++)
 	{
-		do
-		{
-			inspt = evtLast;
-			evtLast = evtLast->next;
-		} while (evt->start >= evtLast->start);
-		inspt->Insert(evt);
-		evtLast = evt;
+		if (evtList[n]->start < evtList[n-1]->start)
+			runs[numRuns++] = n;
 	}
-	else
+	runs[numRuns] = evtCount;
+
+	SeqEvent **src = evtList;
+	SeqEvent **dst = new SeqEvent*[evtAlloc+1];
+	while (numRuns > 1)
 	{
-		do
+		bsInt32 r;
+		bsInt32 out = 0;
+		for (r = 0; r < numRuns; r += 2)
 		{
-			inspt = evtLast;
-			evtLast = evtLast->prev;
-		} while (evt->start < evtLast->start);
-		evtLast->Insert(evt);
-		evtLast = evt;
+			bsInt32 i = runs[r];
+			bsInt32 iend = runs[r+1];
+			bsInt32 j = iend;
+			bsInt32 jend = (r + 2 <= numRuns) ? runs[r+2] : iend;
+			n = i;
+			while (i < iend && j < jend)
+			{
+				if (src[j]->start < src[i]->start)
+					dst[n++] = src[j++];
+				else
+					dst[n++] = src[i++];
+			}
+			while (i < iend)
+				dst[n++] = src[i++];
+			while (j < jend)
+				dst[n++] = src[j++];
+			runs[out++] = runs[r];
+		}
+		runs[out] = evtCount;
+		numRuns = out;
+		SeqEvent **tmp = src;
+		src = dst;
+		dst = tmp;
 	}
-	bsInt32 e = evt->start + evt->duration;
-	if (e >= seqLength)
-		seqLength = e+1;
+	delete[] dst;
+	delete[] runs;
+	evtList = src;
+	evtList[evtCount] = evtTail;
+}
+
+bsInt32 SeqTrack::Find(bsInt32 st)
+{
+	Sort();
+
+	bsInt32 lo = 0;
+	bsInt32 hi = evtCount;
+	while (lo < hi)
+	{
+		bsInt32 mid = (lo + hi) >> 1;
+		if (evtList[mid]->start < st)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
 }
 
 //////////////////////////// SEQUENCER ////////////////////////////
 
+// A run of events in the voice list rendered into one bus.
+// For stems, key is the track or channel number and out
+// holds the dry output passed to the stem callback.
+struct SeqVoiceGroup
+{
+	MixBus bus;
+	bsInt16 key;
+	int first;
+	int end;
+	AmpValue *out;
+
+	SeqVoiceGroup()
+	{
+		key = 0;
+		first = 0;
+		end = 0;
+		out = 0;
+	}
+
+	~SeqVoiceGroup()
+	{
+		delete[] out;
+	}
+};
+
+// Worker thread for voice rendering. The thread waits for the
+// sequencer to post a block, renders voice groups until
+// none are left, then signals the sequencer.
+class SeqVoiceThread : public SynthThread
+{
+public:
+	Sequencer *seq;
+	int thrd;
+	int quit;
+	SynthSemaphore go;
+
+	SeqVoiceThread(Sequencer *s, int n)
+	{
+		seq = s;
+		thrd = n;
+		quit = 0;
+		go.Create();
+	}
+
+	int ThreadProc()
+	{
+		for (;;)
+		{
+			go.Wait();
+			if (quit)
+				break;
+			seq->TickGroups();
+			seq->thrdDone.Post();
+		}
+		return 0;
+	}
+};
+
+// Event chase. The events before the start time are collected
+// from track 0 and, for multi-track playback, from every track
+// started before the start time. Each start of a track is a "run".
+// The events are then replayed in time order. A run stops taking
+// part when its track is stopped or started again. Event times are
+// rounded up to the tick where playback from the top would run them.
+#define SEQ_CHASE_DEPTH 16
+
+struct SeqChaseEvt
+{
+	SeqEvent *evt;
+	bsInt32 time;   // absolute time the event runs
+	bsInt32 order;  // collection order, keeps the sort stable
+	bsInt32 run;    // run that plays the event
+	bsInt32 trun;   // run started by a STARTTRACK event, or -1
+};
+
+struct SeqChaseRun
+{
+	SeqTrack *tp;
+	bsInt32 off;    // track time at the start time
+	bsInt32 loops;  // loop count remaining at the start time
+	bsInt16 live;   // track is playing
+	bsInt16 done;   // track reached the end before the start time
+};
+
+static int SeqChaseCompare(const void *p1, const void *p2)
+{
+	const SeqChaseEvt *e1 = (const SeqChaseEvt *)p1;
+	const SeqChaseEvt *e2 = (const SeqChaseEvt *)p2;
+	if (e1->time != e2->time)
+		return e1->time < e2->time ? -1 : 1;
+	return e1->order - e2->order;
+}
+
+class SeqChaser
+{
+public:
+	Sequencer *seq;
+	bsInt32 st;
+	int multi;
+	SeqChaseEvt *evts;
+	bsInt32 numEvts;
+	bsInt32 maxEvts;
+	SeqChaseRun *runs;
+	bsInt32 numRuns;
+	bsInt32 maxRuns;
+
+	SeqChaser(Sequencer *s, bsInt32 t, int m)
+	{
+		seq = s;
+		st = t;
+		multi = m;
+		evts = 0;
+		numEvts = 0;
+		maxEvts = 0;
+		runs = 0;
+		numRuns = 0;
+		maxRuns = 0;
+	}
+
+	~SeqChaser()
+	{
+		delete[] evts;
+		delete[] runs;
+	}
+
+	bsInt32 AddRun(SeqTrack *tp, bsInt32 off, bsInt32 loops, bsInt16 done)
+	{
+		if (numRuns >= maxRuns)
+		{
+			bsInt32 n = maxRuns ? maxRuns * 2 : 8;
+			SeqChaseRun *r = new SeqChaseRun[n];
+			if (numRuns)
+				memcpy(r, runs, numRuns * sizeof(SeqChaseRun));
+			delete[] runs;
+			runs = r;
+			maxRuns = n;
+		}
+		SeqChaseRun *r = &runs[numRuns];
+		r->tp = tp;
+		r->off = off;
+		r->loops = loops;
+		r->live = 0;
+		r->done = done;
+		return numRuns++;
+	}
+
+	SeqChaseEvt *AddEvent(SeqEvent *evt, bsInt32 time, bsInt32 run)
+	{
+		if (numEvts >= maxEvts)
+		{
+			bsInt32 n = maxEvts ? maxEvts * 2 : 256;
+			SeqChaseEvt *e = new SeqChaseEvt[n];
+			if (numEvts)
+				memcpy(e, evts, numEvts * sizeof(SeqChaseEvt));
+			delete[] evts;
+			evts = e;
+			maxEvts = n;
+		}
+		SeqChaseEvt *e = &evts[numEvts];
+		e->evt = evt;
+		e->time = time;
+		e->order = numEvts++;
+		e->run = run;
+		e->trun = -1;
+		return e;
+	}
+
+	// Collect events on tp with track times from <= start < to.
+	// The track time 0 is at absolute time base.
+	void Collect(SeqTrack *tp, bsInt32 from, bsInt32 to, bsInt32 base, bsInt32 run, int depth)
+	{
+		SeqEvent *evt;
+		bsInt32 res = seq->tickRes;
+		for (bsInt32 n = tp->Find(from); (evt = tp->Event(n))->start < to; n++)
+		{
+			bsInt32 time = base + evt->start;
+			if (time >= st)
+				break;
+			time = ((time + res - 1) / res) * res;
+			if (time > st)
+				time = st;
+			SeqChaseEvt *e = AddEvent(evt, time, run);
+			if (multi && evt->type == SEQEVT_STARTTRACK && depth < SEQ_CHASE_DEPTH)
+				e->trun = Expand((TrackEvent *)evt, time, depth+1);
+		}
+	}
+
+	// Find where a track started at time t0 is at the start time
+	// and collect the events of the current pass. If the track has
+	// looped, the rest of the previous pass is collected too so that
+	// the last occurrence of every event is replayed.
+	bsInt32 Expand(TrackEvent *tevt, bsInt32 t0, int depth)
+	{
+		SeqTrack *tp;
+		for (tp = seq->track; tp; tp = tp->next)
+		{
+			if (tp->Track() == tevt->trkNo)
+				break;
+		}
+		if (tp == 0 || tp == seq->track)
+			return -1;
+
+		// A pass ends after the tick at resLen.
+		bsInt32 res = seq->tickRes;
+		bsInt32 resLen = ((tp->GetLength() / res) + 1) * res;
+		bsInt32 passes = 0;
+		if (st > t0)
+			passes = (st - t0 - 1) / resLen;
+		bsInt32 off = (st - t0) - (passes * resLen);
+		bsInt32 loops = tevt->loopCount;
+		bsInt16 done = 0;
+		if (loops > 0)
+		{
+			if (passes >= loops)
+			{
+				passes = loops - 1;
+				off = resLen;
+				done = 1;
+			}
+			loops -= passes;
+		}
+		bsInt32 base = t0 + (passes * resLen);
+		bsInt32 run = AddRun(tp, off, loops, done);
+		if (passes > 0)
+			Collect(tp, off, 0x7FFFFFFF, base - resLen, run, depth);
+		Collect(tp, 0, off, base, run, depth);
+		return run;
+	}
+
+	void Play()
+	{
+		AddRun(seq->track, st, 1, 0);
+		runs[0].live = 1;
+		Collect(seq->track, 0, st, 0, 0, 0);
+		if (numEvts > 1)
+			qsort(evts, numEvts, sizeof(SeqChaseEvt), SeqChaseCompare);
+
+		int flags = seq->chase;
+		ActiveEvent *act;
+		TrackEvent *tevt;
+		bsInt32 r;
+		for (bsInt32 n = 0; n < numEvts; n++)
+		{
+			SeqChaseEvt *e = &evts[n];
+			if (!runs[e->run].live)
+				continue;
+			SeqEvent *evt = e->evt;
+			bsInt32 elapsed = st - e->time;
+			switch (evt->type)
+			{
+			case SEQEVT_STARTTRACK:
+				if (e->trun < 0)
+					break;
+				for (r = 1; r < numRuns; r++)
+				{
+					if (runs[r].tp == runs[e->trun].tp)
+						runs[r].live = 0;
+				}
+				runs[e->trun].live = 1;
+				break;
+			case SEQEVT_STOPTRACK:
+				if (!multi)
+					break;
+				tevt = (TrackEvent *)evt;
+				for (r = 1; r < numRuns; r++)
+				{
+					if (runs[r].tp->Track() == tevt->trkNo)
+						runs[r].live = 0;
+				}
+				break;
+			case SEQEVT_CONTROL:
+				if (flags & SEQ_CHASE_CTL)
+					seq->ProcessEvent(evt, SEQ_AE_TM);
+				break;
+			case SEQEVT_RESTART:
+				if ((act = seq->FindActive(evt->evid)) != 0)
+				{
+					seq->ProcessEvent(evt, SEQ_AE_TM);
+					if ((act->count -= elapsed) < 1)
+						act->count = 1;
+					break;
+				}
+				// FALLTHROUGH on RESTART event no longer playing
+			case SEQEVT_START:
+				seq->ChaseStart(evt, elapsed);
+				break;
+			default:
+				// PARAM, STOP and CANCEL only affect active events
+				seq->ProcessEvent(evt, SEQ_AE_TM);
+				break;
+			}
+		}
+
+		for (r = 1; r < numRuns; r++)
+		{
+			SeqChaseRun *rp = &runs[r];
+			if (rp->live && !rp->done)
+			{
+				rp->tp->LoopCount(rp->loops);
+				rp->tp->Start(rp->off, seq->tickRes);
+			}
+		}
+	}
+};
+
 Sequencer::Sequencer()
 {
 	state = seqOff;
@@ -86,7 +467,8 @@ Sequencer::Sequencer()
 	tickCount = 0;
 	tickWrap = 0;
 	tickArg = 0;
-	tickRes = (bsInt32) (synthParams.sampleRate * 0.0005);
+	tickRes = (bsInt32) (SynthContext::Current()->sampleRate * 0.0005);
+	tickRun = 1;
 	wrapCount = 0;
 	//cntrlMgr = 0;
 	instMgr = 0;
@@ -94,6 +476,27 @@ Sequencer::Sequencer()
 	maxNote = 1000;
 	trkActive = 0;
 	evtActive = 0;
+	blkMode = 0;
+	blkOn = 0;
+	thrdReq = 0;
+	thrdOn = 0;
+	chase = 0;
+	thrdList = 0;
+	voiceList = 0;
+	voiceMax = 0;
+	voiceCount = 0;
+	voiceGrp = 0;
+	grpMax = 0;
+	grpAlloc = 0;
+	grpCount = 0;
+	grpNext = 0;
+	voiceFrames = 0;
+	stemMode = SEQ_STEM_OFF;
+	stemCB = 0;
+	stemArg = 0;
+	actFree = 0;
+	memset(actHash, 0, sizeof(actHash));
+	memset(actNotes, 0, sizeof(actNotes));
 
 	track = new SeqTrack(0);
 
@@ -104,6 +507,19 @@ Sequencer::Sequencer()
 	immTail->start = 0x7FFFFFFFL;
 	immHead->evid = -1;
 	immTail->evid = -2;
+	immOver = 0;
+	immSeq = 0;
+	immNext = 0;
+	immQueue.Init(SEQ_LIVE_QUEUE, 1);
+
+	liveHead = new SeqEvent;
+	liveTail = new SeqEvent;
+	liveHead->Insert(liveTail);
+	liveHead->start = 0;
+	liveTail->start = 0x7FFFFFFFL;
+	liveHead->evid = -1;
+	liveTail->evid = -2;
+	liveOn = 0;
 
 	actHead = new ActiveEvent;
 	actTail = new ActiveEvent;
@@ -126,9 +542,19 @@ Sequencer::~Sequencer()
 	Reset();
 	immHead->Destroy();
 	immTail->Destroy();
+	liveHead->Destroy();
+	liveTail->Destroy();
 	delete actHead;
 	delete actTail;
+	ActiveEvent *act;
+	while ((act = actFree) != 0)
+	{
+		actFree = act->next;
+		delete act;
+	}
 	delete track;
+	delete[] voiceList;
+	FreeGroups();
 	globEventID = 0;
 }
 
@@ -166,9 +592,124 @@ void Sequencer::AddImmediate(SeqEvent *evt)
 	if (evt == 0)
 		return;
 
-	critMutex.Enter();
-	immTail->InsertBefore(evt);
-	critMutex.Leave();
+	// The order number records the sequence of calls. Events
+	// that arrive through the queue and the overflow list are
+	// put back in that order before they play.
+	evt->order = SynthAtomic::Add(&immSeq, 1);
+	if (!immQueue.Put(evt))
+	{
+		void *top;
+		do
+		{
+			top = SynthAtomic::LoadPtr(&immOver);
+			evt->next = (SeqEvent *) top;
+		} while (!SynthAtomic::CompareExchangePtr(&immOver, top, evt));
+	}
+}
+
+// Add an arrived live event to the list sorted by order.
+void Sequencer::HoldLive(SeqEvent *evt)
+{
+	SeqEvent *pos;
+	for (pos = immTail->prev; pos != immHead; pos = pos->prev)
+	{
+		if ((bsInt32) ((bsUint32) pos->order - (bsUint32) evt->order) < 0)
+			break;
+	}
+	pos->Insert(evt);
+}
+
+// Play live events that are due and return the number
+// of frames that can be generated before the next one.
+// Called on the sequencer thread before each run of frames.
+bsInt32 Sequencer::TickLive(bsInt32 frames)
+{
+	SeqEvent *evt;
+	SeqEvent *pos;
+	while ((evt = immQueue.Get()) != 0)
+		HoldLive(evt);
+	if (SynthAtomic::LoadPtr(&immOver) != 0)
+	{
+		// the overflow list is newest first; reverse it
+		SeqEvent *list = (SeqEvent *) SynthAtomic::ExchangePtr(&immOver, 0);
+		SeqEvent *prev = 0;
+		while (list)
+		{
+			evt = list->next;
+			list->next = prev;
+			prev = list;
+			list = evt;
+		}
+		while ((evt = prev) != 0)
+		{
+			prev = evt->next;
+			HoldLive(evt);
+		}
+	}
+
+	// An event only moves on once every earlier one has arrived,
+	// so a producer that is interrupted between taking its order
+	// and adding the event delays later events rather than
+	// letting them pass. Events from before ClearLive go at once.
+	while ((evt = immHead->next) != immTail)
+	{
+		bsInt32 ahead = (bsInt32) ((bsUint32) evt->order - (bsUint32) immNext);
+		if (ahead > 0)
+			break;
+		if (ahead == 0)
+			immNext++;
+		evt->Remove();
+		// keep the pending list sorted by start time
+		for (pos = liveTail->prev; pos != liveHead; pos = pos->prev)
+		{
+			if (pos->start <= evt->start)
+				break;
+		}
+		pos->Insert(evt);
+	}
+
+	while ((evt = liveHead->next) != liveTail)
+	{
+		if (evt->start > 0 && (bsUint32) evt->start > seqTick)
+		{
+			bsUint32 wait = (bsUint32) evt->start - seqTick;
+			if (wait < (bsUint32) frames)
+				frames = (bsInt32) wait;
+			break;
+		}
+		evt->Remove();
+		ProcessEvent(evt, 0);
+		evt->Destroy();
+	}
+	return frames;
+}
+
+// Discard live events that have not been played.
+void Sequencer::ClearLive()
+{
+	SeqEvent *evt;
+	while ((evt = immQueue.Get()) != 0)
+		evt->Destroy();
+
+	evt = (SeqEvent *) SynthAtomic::ExchangePtr(&immOver, 0);
+	while (evt)
+	{
+		SeqEvent *nxt = evt->next;
+		evt->Destroy();
+		evt = nxt;
+	}
+	while ((evt = immHead->next) != immTail)
+	{
+		evt->Remove();
+		evt->Destroy();
+	}
+	immNext = SynthAtomic::Load(&immSeq);
+
+	while ((evt = liveHead->next) != liveTail)
+	{
+		evt->Remove();
+		evt->Destroy();
+	}
 }
 
 // Multi-mode sequencer can play live, sequence, loop tracks or any combination.
@@ -185,23 +726,28 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 
 	im.SetSequencer(this);
 
-	SeqEvent *imm = 0;
 	SeqEvent *evt = 0;
 	SeqTrack *tp = 0;
 	trkActive = 0;
 	evtActive = 0;
 
 	seqTick = startTime;
+	for (tp = track; tp; tp = tp->next)
+		tp->Sort();
 	track->LoopCount(1);
 	track->Start(seqTick, tickRes);
 
 	instMgr = &im;
+	BlockStart();
 	instMgr->Start();
+	if (chase && startTime > 0)
+		Chase(startTime, 1);
 
 	state = st;
 	int live = st & seqPlay;
 	int sequenced = st & seqSequence;
 	int once = st & seqOnce;
+	liveOn = live != 0;
 
 	tickCount = 0;
 	wrapCount = 0;
@@ -211,23 +757,7 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 	playing = true;
 	while (playing)
 	{
-		if (live)
-		{
-			// in-line message peek/get
-			critMutex.Enter();
-			imm = immHead->next;
-			if (imm != immTail)
-				imm->Remove();
-			else
-				imm = NULL;
-			critMutex.Leave();
-			if (imm)
-			{
-				ProcessEvent(imm, 0);
-				imm->Destroy();
-			}
-		}
-
+		// live events are played by Tick()
 		if (sequenced)
 		{
 			// find any events that are ready to activate
@@ -240,7 +770,16 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 			}
 		}
 
-		// invoke all active instruments for tickRes samples
+		// extend the block to the next event when possible
+		tickRun = TickRun(sequenced ? track : 0, 1, endTime);
+		if (tickRun > 1 && sequenced)
+		{
+			trkActive = 0;
+			for (tp = track; tp; tp = tp->next)
+				trkActive |= tp->Skip(tickRun - 1);
+		}
+
+		// invoke all active instruments for tickRun*tickRes samples
 		evtActive = Tick();
 
 		// When we have reached the end of the sequence
@@ -254,7 +793,9 @@ bsUint32 Sequencer::SequenceMulti(InstrManager& im, bsUint32 startTime, bsUint32
 				playing = false;
 		}
 	}
+	liveOn = 0;
 	instMgr->Stop();
+	BlockStop();
 
 	// Since it is possible to halt the sequence while events are still
 	// active, we do clean-up here. We don't bother with Stop or IsFinished
@@ -294,7 +835,10 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 	track->Start(seqTick, tickRes);
 
 	instMgr = &im;
+	BlockStart();
 	instMgr->Start();
+	if (chase && startTime > 0)
+		Chase(startTime, 0);
 
 	state = seqSeqOnce;
 
@@ -311,7 +855,12 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 			ProcessEvent(evt, SEQ_AE_TM);
 		trkActive = track->Tick();
 
-		// invoke all active instruments for tickRes samples
+		// extend the block to the next event when possible
+		tickRun = TickRun(track, 0, endTime);
+		if (tickRun > 1)
+			trkActive = track->Skip(tickRun - 1);
+
+		// invoke all active instruments for tickRun*tickRes samples
 		evtActive = Tick();
 
 		// When we have reached the end of the sequence
@@ -323,6 +872,7 @@ bsUint32 Sequencer::Sequence(InstrManager& im, bsUint32 startTime, bsUint32 endT
 			playing = false;
 	}
 	instMgr->Stop();
+	BlockStop();
 
 	// Since it is possible to halt the sequence while events are still
 	// active, we do clean-up here. We don't bother with Stop or IsFinished
@@ -351,42 +901,22 @@ bsUint32 Sequencer::Play(InstrManager& im)
 	instMgr = &im;
 	im.SetSequencer(this);
 
-	SeqEvent *evt;
-
 	ClearActive();
-
-	critMutex.Enter();
-	while ((evt = immHead->next) != immTail)
-	{
-		evt->Remove();
-		evt->Destroy();
-	}
-	critMutex.Leave();
+	ClearLive();
 
 	state = seqPlay;
 	seqTick = 0;
 
+	BlockStart();
 	instMgr->Start();
+	liveOn = 1;
 	playing = true;
+	tickRun = TickRun(0, 0, 0);
 	while (playing)
-	{
-		// in-line message peek/get
-		critMutex.Enter();
-		evt = immHead->next;
-		if (evt != immTail)
-			evt->Remove();
-		else
-			evt = NULL;
-		critMutex.Leave();
-		if (evt)
-		{
-			ProcessEvent(evt, 0);
-			evt->Destroy();
-		}
-
 		Tick();
-	}
+	liveOn = 0;
 	instMgr->Stop();
+	BlockStop();
 
 	ClearActive();
 
@@ -401,16 +931,8 @@ bsUint32 Sequencer::Play(InstrManager& im)
 // Reset should be called to clean up any memory before filling in a new sequence.
 void Sequencer::Reset()
 {
-	SeqEvent *evt;
 	ClearActive();
-
-	critMutex.Enter();
-	while ((evt = immHead->next) != immTail)
-	{
-		evt->Remove();
-		evt->Destroy();
-	}
-	critMutex.Leave();
+	ClearLive();
 
 	track->Reset();
 	SeqTrack *tp;
@@ -424,6 +946,90 @@ void Sequencer::Reset()
 	globEventID = 0;
 }
 
+// Get an active event entry from the free list,
+// or allocate one if the list is empty.
+ActiveEvent *Sequencer::NewActive()
+{
+	ActiveEvent *act = actFree;
+	if (act)
+	{
+		actFree = act->next;
+		act->next = 0;
+		act->prev = 0;
+		return act;
+	}
+	return new ActiveEvent;
+}
+
+// Put an active event entry on the free list.
+// The entry is also removed from the ID index.
+void Sequencer::FreeActive(ActiveEvent *act)
+{
+	if (act->hslot)
+	{
+		if (act->hprev)
+			act->hprev->hnext = act->hnext;
+		else
+			*act->hslot = act->hnext;
+		if (act->hnext)
+			act->hnext->hprev = act->hprev;
+		act->hnext = 0;
+		act->hprev = 0;
+		act->hslot = 0;
+	}
+	act->ip = 0;
+	act->next = actFree;
+	actFree = act;
+}
+
+// Locate the index slot for an event ID. Live MIDI note IDs
+// go directly to a channel/key slot, other IDs are hashed.
+ActiveEvent **Sequencer::ActiveSlot(bsInt32 evid)
+{
+	bsUint32 id = (bsUint32) evid;
+	if (id & SEQ_EVID_MIDI)
+		return &actNotes[((id >> 9) & 0x780) | ((id >> 8) & 0x7f)];
+	id ^= (id >> 8) ^ (id >> 16);
+	return &actHash[id & (SEQ_EVID_HASH-1)];
+}
+
+// Add an active event to the ID index.
+// Entries are added at the front of the slot.
+void Sequencer::IndexActive(ActiveEvent *act)
+{
+	ActiveEvent **slot = ActiveSlot(act->evid);
+	act->hslot = slot;
+	act->hprev = 0;
+	act->hnext = *slot;
+	if (*slot)
+		(*slot)->hprev = act;
+	*slot = act;
+}
+
+// Find the active event for an ID. When several active
+// events share the ID the oldest is returned, the same
+// as searching the active list from the front.
+ActiveEvent *Sequencer::FindActive(bsInt32 evid)
+{
+	ActiveEvent *found = 0;
+	ActiveEvent *act;
+	for (act = *ActiveSlot(evid); act; act = act->hnext)
+	{
+		if (act->evid == evid)
+			found = act;
+	}
+	return found;
+}
+
+void Sequencer::Preallocate(bsInt32 count)
+{
+	ActiveEvent *act;
+	for (act = actFree; act && count > 0; act = act->next)
+		count--;
+	while (count-- > 0)
+		FreeActive(new ActiveEvent);
+}
+
 // Discard any active events. No "Stop" or "IsFinished"
 void Sequencer::ClearActive()
 {
@@ -433,14 +1039,99 @@ void Sequencer::ClearActive()
 	{
 		instMgr->Deallocate(act->ip);
 		act->Remove();
-		delete act;
+		FreeActive(act);
+	}
+}
+
+// Enable block rendering on the instrument manager if requested.
+void Sequencer::BlockStart()
+{
+	blkOn = 0;
+	tickRun = 1;
+	if (blkMode)
+	{
+		// with threads, blocks can span several ticks (see TickRun)
+		bsInt32 len = tickRes;
+		if (len > MAX_BLKLEN || thrdReq > 0 || stemMode != SEQ_STEM_OFF)
+			len = MAX_BLKLEN;
+		blkOn = (bsInt16) instMgr->SetBlockLength(len);
+		if (!blkOn)
+			instMgr->SetBlockLength(0);
+		else
+			ThreadStart();
+	}
+}
+
+void Sequencer::BlockStop()
+{
+	tickRun = 1;
+	if (blkOn)
+	{
+		ThreadStop();
+		instMgr->SetBlockLength(0);
+		blkOn = 0;
+	}
+}
+
+// Start the worker threads for voice rendering if requested.
+// The calling thread counts as the first thread.
+void Sequencer::ThreadStart()
+{
+	thrdOn = 0;
+	if (thrdReq < 1 && stemMode == SEQ_STEM_OFF)
+		return;
+	if (!instMgr->EnableBus(1))
+	{
+		instMgr->EnableBus(0);
+		return;
+	}
+	thrdDone.Create();
+	int n = 1;
+	if (thrdReq > 1)
+	{
+		thrdList = new SeqVoiceThread*[thrdReq-1];
+		while (n < thrdReq)
+		{
+			SeqVoiceThread *tp = new SeqVoiceThread(this, n);
+			if (tp->StartThread() != 0)
+			{
+				delete tp;
+				break;
+			}
+			thrdList[n-1] = tp;
+			n++;
+		}
 	}
+	thrdOn = (bsInt16) n;
+}
+
+void Sequencer::ThreadStop()
+{
+	if (thrdOn == 0)
+		return;
+	for (int n = 1; n < thrdOn; n++)
+	{
+		SeqVoiceThread *tp = thrdList[n-1];
+		tp->quit = 1;
+		tp->go.Post();
+		tp->WaitThread();
+		delete tp;
+	}
+	delete[] thrdList;
+	thrdList = 0;
+	FreeGroups();
+	instMgr->EnableBus(0);
+	thrdDone.Destroy();
+	thrdOn = 0;
 }
 
 // Cycle all active events (Tick)
 // This is "IT" - where we actually generate samples...
 int Sequencer::Tick()
 {
+	if (blkOn)
+		return TickBlock();
+
 	if (pausing)
 	{
 		Wait();
@@ -452,6 +1143,8 @@ int Sequencer::Tick()
 	bsInt32 tickBlk = tickRes;
 	do
 	{
+		if (liveOn)
+			TickLive(1);
 		actCount = 0;
 		Instrument *ins;
 		ActiveEvent *act = actHead->next;
@@ -480,7 +1173,7 @@ int Sequencer::Tick()
 					//printf("Remove Note for event %d\n", act->evid);
 					instMgr->Deallocate(ins);
 					ActiveEvent *p = act->Remove();
-					delete act;
+					FreeActive(act);
 					act = p;
 					actCount--;
 				}
@@ -509,6 +1202,361 @@ int Sequencer::Tick()
 	return actCount;
 }
 
+// Get the number of ticks to render with the next Tick().
+// With threads, a block holds as many ticks as fit in
+// MAX_BLKLEN frames, up to the tick where a track has an
+// event ready or the end time is reached. The cost of waking
+// the threads then does not grow as the tick resolution gets
+// finer. Otherwise each tick is rendered by itself.
+// Called after the tracks are ticked; tp is the first track
+// to check, and all selects the tracks that follow it.
+bsInt32 Sequencer::TickRun(SeqTrack *tp, int all, bsUint32 endTime)
+{
+	if (!thrdOn)
+		return 1;
+	bsInt32 more = (MAX_BLKLEN / tickRes) - 1;
+	if (endTime > 0)
+	{
+		if (seqTick >= endTime)
+			return 1;
+		bsInt32 left = (bsInt32) ((endTime - seqTick + tickRes - 1) / tickRes) - 1;
+		if (left < more)
+			more = left;
+	}
+	while (tp && more > 0)
+	{
+		more = tp->TicksFree(more);
+		if (!all)
+			break;
+		tp = tp->next;
+	}
+	return more > 0 ? more + 1 : 1;
+}
+
+// Cycle all active events by blocks.
+// Each instrument is invoked for a run of frames, then the
+// instrument manager outputs the block. The per-instrument
+// state changes happen at the same frames as in Tick().
+// Instruments that cannot produce a block are called
+// once per frame. For those instruments, IsFinished is checked
+// on every frame, otherwise only at the start of the run.
+int Sequencer::TickBlock()
+{
+	if (pausing)
+	{
+		Wait();
+		if (!playing)
+			return 0;
+	}
+
+	int actCount = 0;
+	int frames;
+	int pos;
+	bsInt32 tickBlk = tickRes * tickRun;
+	do
+	{
+		frames = tickBlk > MAX_BLKLEN ? MAX_BLKLEN : (int) tickBlk;
+		if (liveOn)
+			frames = (int) TickLive(frames);
+		if (thrdOn)
+			actCount = TickVoices(frames);
+		else
+		{
+			actCount = 0;
+			ActiveEvent *act = actHead->next;
+			while (act != actTail)
+			{
+				if (TickVoice(act, frames, 0))
+				{
+					actCount++;
+					act = act->next;
+				}
+				else
+				{
+					instMgr->Deallocate(act->ip);
+					ActiveEvent *p = act->Remove();
+					FreeActive(act);
+					act = p;
+				}
+			}
+		}
+		instMgr->TickBlock(frames);
+
+		seqTick += frames;
+		if (tickCB)
+		{
+			for (pos = 0; pos < frames; pos++)
+			{
+				if (++tickCount >= tickWrap)
+				{
+					tickCB(++wrapCount, tickArg);
+					tickCount = 0;
+				}
+			}
+		}
+	} while ((tickBlk -= frames) > 0);
+
+	return actCount;
+}
+
+// Set the output position for a voice.
+static inline void VoicePos(InstrManager *im, MixBus *bus, int n)
+{
+	if (bus)
+		bus->SetBlockPos(n);
+	else
+		im->SetBlockPos(n);
+}
+
+// Invoke one instrument for a block.
+// When bus is set, output positions are set on the bus,
+// otherwise on the instrument manager.
+// Returns 0 when the instrument is finished and can
+// be removed.
+int Sequencer::TickVoice(ActiveEvent *act, int frames, MixBus *bus)
+{
+	Instrument *ins = act->ip;
+	int pos = 0;
+	int run;
+	if (act->ison == SEQ_AE_ON)
+	{
+		run = frames;
+		if ((act->flags & SEQ_AE_TM) && act->count > 0 && act->count < run)
+			run = act->count;
+		VoicePos(instMgr, bus, 0);
+		if (!ins->TickBlock(run))
+		{
+			for (pos = 0; pos < run; pos++)
+			{
+				VoicePos(instMgr, bus, pos);
+				ins->Tick();
+			}
+		}
+		pos = run;
+		if ((act->flags & SEQ_AE_TM) && (act->count -= run) == 0)
+		{
+			// duration finished
+			ins->Stop();
+			act->ison = SEQ_AE_REL;
+		}
+	}
+	if (act->ison == SEQ_AE_REL && pos < frames)
+	{
+		// in release
+		if (ins->IsFinished())
+			return 0;
+		VoicePos(instMgr, bus, pos);
+		if (!ins->TickBlock(frames - pos))
+		{
+			for (;;)
+			{
+				VoicePos(instMgr, bus, pos);
+				ins->Tick();
+				if (++pos >= frames)
+					break;
+				if (ins->IsFinished())
+					return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+// Invoke all active instruments for a block using the
+// worker threads. The active list is copied to an array
+// and split into groups, either SEQ_VOICE_GROUP events each
+// or one group for each stem. Each group is rendered into its
+// own bus, then the buses are output in group order. Since the
+// groups do not depend on the number of threads, neither does
+// the result. Finished events are marked OFF by the rendering
+// thread and removed here.
+int Sequencer::TickVoices(int frames)
+{
+	ActiveEvent *act;
+	voiceCount = 0;
+	for (act = actHead->next; act != actTail; act = act->next)
+	{
+		if (voiceCount >= voiceMax)
+		{
+			bsInt32 newMax = voiceMax + 64;
+			ActiveEvent **newList = new ActiveEvent*[newMax];
+			if (voiceCount > 0)
+				memcpy(newList, voiceList, voiceCount*sizeof(ActiveEvent*));
+			delete[] voiceList;
+			voiceList = newList;
+			voiceMax = newMax;
+		}
+		voiceList[voiceCount++] = act;
+	}
+
+	if (stemMode != SEQ_STEM_OFF)
+		grpCount = StemVoices();
+	else
+		grpCount = GroupVoices();
+
+	voiceFrames = frames;
+	SynthAtomic::Store(&grpNext, 0);
+	int wake = thrdOn < grpCount ? thrdOn : grpCount;
+	int t;
+	for (t = 1; t < wake; t++)
+		thrdList[t-1]->go.Post();
+	TickGroups();
+	for (t = 1; t < wake; t++)
+		thrdDone.Wait();
+
+	int g;
+	SeqVoiceGroup *grp;
+	if (stemCB)
+	{
+		for (g = 0; g < grpCount; g++)
+		{
+			grp = voiceGrp[g];
+			if (grp->out)
+				stemCB(grp->key, seqTick, grp->out, grp->out + grp->bus.GetBlockLength(), frames, stemArg);
+		}
+	}
+	for (g = 0; g < grpCount; g++)
+		instMgr->OutputBus(&voiceGrp[g]->bus, frames);
+
+	int actCount = 0;
+	for (int n = 0; n < voiceCount; n++)
+	{
+		act = voiceList[n];
+		if (act->ison == SEQ_AE_OFF)
+		{
+			instMgr->Deallocate(act->ip);
+			act->Remove();
+			FreeActive(act);
+		}
+		else
+			actCount++;
+	}
+	return actCount;
+}
+
+// Split the voice list into groups of SEQ_VOICE_GROUP
+// events in list order. Returns the number of groups.
+int Sequencer::GroupVoices()
+{
+	int groups = (voiceCount + SEQ_VOICE_GROUP - 1) / SEQ_VOICE_GROUP;
+	for (int g = 0; g < groups; g++)
+	{
+		SeqVoiceGroup *grp = g < grpAlloc ? voiceGrp[g] : NewGroup(0, g);
+		grp->first = g * SEQ_VOICE_GROUP;
+		grp->end = grp->first + SEQ_VOICE_GROUP;
+		if (grp->end > voiceCount)
+			grp->end = voiceCount;
+	}
+	return groups;
+}
+
+// Get the stem number for an event.
+static inline bsInt16 StemKey(ActiveEvent *act, int mode)
+{
+	return mode == SEQ_STEM_CHNL ? act->chnl : act->trk;
+}
+
+// Sort the voice list into stems. A stem is added the first
+// time an event for its track or channel is active and is kept
+// until playback stops, so that stem output is continuous.
+// Events keep their list order within each stem.
+// Returns the number of stems.
+int Sequencer::StemVoices()
+{
+	int n, g;
+	bsInt16 key;
+	SeqVoiceGroup *grp;
+	for (n = 0; n < voiceCount; n++)
+	{
+		key = StemKey(voiceList[n], stemMode);
+		for (g = 0; g < grpAlloc; g++)
+		{
+			if (voiceGrp[g]->key >= key)
+				break;
+		}
+		if (g >= grpAlloc || voiceGrp[g]->key != key)
+			NewGroup(key, g);
+	}
+
+	n = 0;
+	for (g = 0; g < grpAlloc; g++)
+	{
+		grp = voiceGrp[g];
+		grp->first = n;
+		for (ActiveEvent *act = actHead->next; act != actTail; act = act->next)
+		{
+			if (StemKey(act, stemMode) == grp->key)
+				voiceList[n++] = act;
+		}
+		grp->end = n;
+	}
+	return grpAlloc;
+}
+
+// Create a voice group and insert it at position at.
+SeqVoiceGroup *Sequencer::NewGroup(bsInt16 key, int at)
+{
+	if (grpAlloc >= grpMax)
+	{
+		bsInt32 newMax = grpMax + 16;
+		SeqVoiceGroup **newGrp = new SeqVoiceGroup*[newMax];
+		if (grpAlloc > 0)
+			memcpy(newGrp, voiceGrp, grpAlloc*sizeof(SeqVoiceGroup*));
+		delete[] voiceGrp;
+		voiceGrp = newGrp;
+		grpMax = newMax;
+	}
+	SeqVoiceGroup *grp = new SeqVoiceGroup;
+	int len = instMgr->GetBlockLength();
+	grp->key = key;
+	grp->bus.SetBlockLength(len);
+	if (stemMode != SEQ_STEM_OFF && stemCB)
+		grp->out = new AmpValue[len*2];
+	for (int g = grpAlloc; g > at; g--)
+		voiceGrp[g] = voiceGrp[g-1];
+	voiceGrp[at] = grp;
+	grpAlloc++;
+	return grp;
+}
+
+void Sequencer::FreeGroups()
+{
+	for (int g = 0; g < grpAlloc; g++)
+		delete voiceGrp[g];
+	delete[] voiceGrp;
+	voiceGrp = 0;
+	grpMax = 0;
+	grpAlloc = 0;
+	grpCount = 0;
+}
+
+// Render voice groups until none are left. Each thread takes
+// the next group not yet started, so the threads stay busy
+// when the groups differ in size. Each group goes to its own
+// bus, so the result does not depend on which thread renders it.
+void Sequencer::TickGroups()
+{
+	for (;;)
+	{
+		int g = SynthAtomic::Load(&grpNext);
+		if (g >= grpCount)
+			break;
+		if (!SynthAtomic::CompareExchange(&grpNext, g, g + 1))
+			continue;
+		SeqVoiceGroup *grp = voiceGrp[g];
+		MixBus *prev = MixBus::MakeCurrent(&grp->bus);
+		for (int n = grp->first; n < grp->end; n++)
+		{
+			ActiveEvent *act = voiceList[n];
+			if (!TickVoice(act, voiceFrames, &grp->bus))
+				act->ison = SEQ_AE_OFF;
+		}
+		MixBus::MakeCurrent(prev);
+		if (grp->out)
+			instMgr->StemBlock(&grp->bus, grp->out, grp->out + grp->bus.GetBlockLength(), voiceFrames);
+	}
+}
+
 void Sequencer::Broadcast(SeqEvent *evt)
 {
 	ActiveEvent *act;
@@ -532,25 +1580,22 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 	case SEQEVT_PARAM:
 	case SEQEVT_STOP:
 		// try to match this event to a prior event
-		for (act = actHead->next; act != actTail; act = act->next)
+		if ((act = FindActive(evt->evid)) != 0)
 		{
-			if (act->evid == evt->evid)
+			if (typ == SEQEVT_PARAM)
+				act->ip->Param(evt);
+			else if (typ == SEQEVT_STOP)
 			{
-				if (typ == SEQEVT_PARAM)
-					act->ip->Param(evt);
-				else if (typ == SEQEVT_STOP)
-				{
-					act->ip->Stop();
-					act->ison = SEQ_AE_REL;
-				}
-				else if (typ == SEQEVT_RESTART)
-				{
-					act->ip->Start(evt);
-					act->count = evt->duration;
-					act->ison = SEQ_AE_ON;
-				}
-				return;
+				act->ip->Stop();
+				act->ison = SEQ_AE_REL;
+			}
+			else if (typ == SEQEVT_RESTART)
+			{
+				act->ip->Start(evt);
+				act->count = evt->duration;
+				act->ison = SEQ_AE_ON;
 			}
+			return;
 		}
 		if (typ != SEQEVT_RESTART)
 			break;
@@ -572,7 +1617,7 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 			{
 				instMgr->Deallocate(act->ip);
 				act->Remove();
-				delete act;
+				FreeActive(act);
 				evtActive--;
 			}
 		}
@@ -580,16 +1625,18 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 		// locate the instrument by id (inum) and return
 		// a valid instance. We then initialize the instrument
 		// by passing the event structure.
-		if ((act = new ActiveEvent) == NULL)
+		if ((act = NewActive()) == NULL)
 		{
 			playing = false;
 			return;
 		}
 		actTail->InsertBefore(act);
 		act->evid = evt->evid;
+		IndexActive(act);
 		act->ison = SEQ_AE_ON;
 		act->count = evt->duration;
 		act->chnl = evt->chnl;
+		act->trk = evt->track;
 		if ((flags & SEQ_AE_TM) && act->count == 0)
 			act->count = 1;
 		act->flags = flags;
@@ -637,6 +1684,53 @@ void Sequencer::ProcessEvent(SeqEvent *evt, bsInt16 flags)
 	}
 }
 
+// Replay the events before the start time. Called after the
+// instrument manager is started and before any samples are generated.
+void Sequencer::Chase(bsInt32 st, int multi)
+{
+	SeqChaser chaser(this, st, multi);
+	chaser.Play();
+}
+
+// Start an instrument for an event that began elapsed samples
+// before the playback start. The instrument is kept if it asks
+// to continue, or if the note is still sounding and notes are chased.
+void Sequencer::ChaseStart(SeqEvent *evt, bsInt32 elapsed)
+{
+	bsInt32 count = evt->duration - elapsed;
+	if (!(chase & SEQ_CHASE_CTL) && count <= 0)
+		return;
+
+	Instrument *ip = instMgr->Allocate(evt);
+	if (ip == 0)
+		return;
+	int keep = 0;
+	if (chase & SEQ_CHASE_CTL)
+		keep = ip->Chase(evt, elapsed);
+	if (!keep && (chase & SEQ_CHASE_NOTES) && count > 0)
+	{
+		ip->Start(evt);
+		keep = 1;
+	}
+	if (!keep)
+	{
+		instMgr->Deallocate(ip);
+		return;
+	}
+
+	ActiveEvent *act = NewActive();
+	actTail->InsertBefore(act);
+	act->evid = evt->evid;
+	IndexActive(act);
+	act->ison = SEQ_AE_ON;
+	act->count = count > 0 ? count : 1;
+	act->chnl = evt->chnl;
+	act->trk = evt->track;
+	act->flags = SEQ_AE_TM;
+	act->ip = ip;
+	evtActive++;
+}
+
 void Sequencer::Wait()
 {
 	SeqState was = state;
@@ -281,6 +281,55 @@ int SoundBank::OpenSampleFile()
 	return 0;
 }
 
+int SoundBank::OpenSampleMap()
+{
+	if (sampleMapOpen == 0)
+		sampleMapOpen = sampleMap.MapOpen(file) == 0 ? 1 : -1;
+	return sampleMapOpen > 0 ? 0 : -1;
+}
+
+// Point the sample at the data in the mapped file.
+// The file must supply the two zero guard points the
+// oscillator expects after the last sample. SF2 requires
+// zeros following each sample; DLS waves usually have
+// the next chunk instead and are read into memory.
+int SoundBank::MapSample(SBSample *samp)
+{
+#if SYNTH_BIG_ENDIAN
+	return -1;
+#else
+	if (!mapSamples || samp->channels != 1 || samp->filepos == 0
+	 || (samp->format != 1 && samp->format != 3))
+		return -1;
+	if (OpenSampleMap())
+		return -1;
+
+	const bsUint8 *base = sampleMap.GetData();
+	bsUint32 mapSize = sampleMap.GetSize();
+	bsUint32 samplen = (bsUint32) samp->sampleLen + 2;
+	if ((samp->filepos & 1) || samp->filepos > mapSize
+	 || samplen > (mapSize - samp->filepos) / 2)
+		return -1;
+	const bsInt16 *sp = (const bsInt16 *) (base + samp->filepos);
+	if (sp[samplen-2] != 0 || sp[samplen-1] != 0)
+		return -1;
+
+	const bsUint8 *lp = 0;
+	if (samp->format == 3 && samp->filepos2 != 0)
+	{
+		if (samp->filepos2 > mapSize || samplen > mapSize - samp->filepos2)
+			return -1;
+		lp = base + samp->filepos2;
+		if (lp[samplen-2] != 0 || lp[samplen-1] != 0)
+			return -1;
+	}
+	samp->sample16 = (bsInt16 *) sp;
+	samp->sample8 = (bsUint8 *) lp;
+	samp->mapped = 1;
+	return 0;
+#endif
+}
+
 /// Load samples. These will always create a valid
 /// pointer to sample values, but the values will
 /// be zero on failure.
@@ -321,7 +370,7 @@ int SoundBank::LoadInstr(SBInstr *in, FileReadBuf& f)
 		}
 		if (samp)
 		{
-			if (samp->sample == 0)
+			if (!samp->IsLoaded())
 			{
 				err |= LoadSample(samp, f);
 			}
@@ -350,7 +399,10 @@ static void ZeroSample(AmpValue *sp, bsInt32 len)
 
 int SoundBank::LoadSample(SBSample *samp)
 {
-	if (samp->sample)
+	if (samp->IsLoaded())
+		return 0;
+
+	if (MapSample(samp) == 0)
 		return 0;
 
 	if (OpenSampleFile())
@@ -366,11 +418,20 @@ int SoundBank::LoadSample(SBSample *samp)
 // We can have one block of either 1 or 2 channel,
 // or one block for each channel.
 // Two zeros are added at the end as guard points.
+// Mono 16 and 24-bit samples are kept as integers
+// when compact storage is on, halving the memory used.
 int SoundBank::LoadSample(SBSample *samp, FileReadBuf& f)
 {
-	if (samp->sample)
+	if (samp->IsLoaded())
+		return 0;
+
+	if (MapSample(samp) == 0)
 		return 0;
 
+	if (compact && samp->channels == 1 && samp->filepos != 0
+	 && (samp->format == 1 || samp->format == 3))
+		return ReadSamples16(samp, f);
+
 	samp->sample = new AmpValue[samp->sampleLen + 2];
 
 	int err = 0;
@@ -446,6 +507,34 @@ int SoundBank::ReadSamples1(SBSample *samp, FileReadBuf& f)
 	return 0;
 }
 
+// Mono 16-bit samples, with the low byte of SF2 24-bit
+// samples in a separate array.
+int SoundBank::ReadSamples16(SBSample *samp, FileReadBuf& f)
+{
+	bsInt32 cnt;
+	bsInt32 samplen = samp->sampleLen;
+	bsInt16 *sp = new bsInt16[samplen + 2];
+	samp->sample16 = sp;
+
+	f.FileRewind(samp->filepos);
+	for (cnt = 0; cnt < samplen; cnt++)
+		*sp++ = (bsInt16) (f.ReadCh() | (f.ReadCh() << 8));
+	*sp++ = 0;
+	*sp = 0;
+
+	if (samp->format == 3 && samp->filepos2 != 0)
+	{
+		bsUint8 *lp = new bsUint8[samplen + 2];
+		samp->sample8 = lp;
+		f.FileRewind(samp->filepos2);
+		for (cnt = 0; cnt < samplen; cnt++)
+			*lp++ = (bsUint8) f.ReadCh();
+		*lp++ = 0;
+		*lp = 0;
+	}
+	return 0;
+}
+
 // Two-channel samples. Allowed by DLS2, but not
 // really useful since we need a mono sample for the
 // oscillator phase to work correctly. We load these
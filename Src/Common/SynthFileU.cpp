@@ -12,6 +12,7 @@
 #include <sys/types.h>
 //#include <sys/uio.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -31,7 +32,11 @@ FileWriteUnBuf::~FileWriteUnBuf()
 
 int FileWriteUnBuf::FileOpen(const char *fname)
 {
-	fd = open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	int flags = O_WRONLY|O_CREAT|O_TRUNC;
+#ifdef O_LARGEFILE
+	flags |= O_LARGEFILE; // wave files can exceed 2GB
+#endif
+	fd = open(fname, flags, 0644);
 	if (fd < 0)
 		return -1;
 	return 0;
@@ -184,6 +189,50 @@ int FileReadBuf::FileClose()
 	return 0;
 }
 
+FileMap::FileMap()
+{
+	data = 0;
+	size = 0;
+}
+
+FileMap::~FileMap()
+{
+	MapClose();
+}
+
+int FileMap::MapOpen(const char *fname)
+{
+	MapClose();
+	int fd = open(fname, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	struct stat info;
+	if (fstat(fd, &info) < 0 || info.st_size <= 0)
+	{
+		close(fd);
+		return -1;
+	}
+	void *mp = mmap(0, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping holds its own reference to the file
+	close(fd);
+	if (mp == MAP_FAILED)
+		return -1;
+	data = (bsUint8 *) mp;
+	size = (bsUint32) info.st_size;
+	return 0;
+}
+
+int FileMap::MapClose()
+{
+	if (data)
+	{
+		munmap((void *) data, (size_t) size);
+		data = 0;
+		size = 0;
+	}
+	return 0;
+}
+
 int SynthFileExists(const char *fname)
 {
 	struct stat info;
@@ -209,6 +209,66 @@ int FileReadBuf::FileClose()
 	return 0;
 }
 
+FileMap::FileMap()
+{
+	data = 0;
+	size = 0;
+	fh = INVALID_HANDLE_VALUE;
+	mh = NULL;
+}
+
+FileMap::~FileMap()
+{
+	MapClose();
+}
+
+int FileMap::MapOpen(const char *fname)
+{
+	MapClose();
+	size_t wlen = bsString::utf16Len(fname) + 1;
+	wchar_t *wbuf = new wchar_t[wlen];
+	bsString::utf16(fname, wbuf, wlen);
+	fh = CreateFileW(wbuf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	delete wbuf;
+	if (fh == INVALID_HANDLE_VALUE)
+		return -1;
+	DWORD fsize = GetFileSize(fh, NULL);
+	if (fsize == INVALID_FILE_SIZE || fsize == 0)
+	{
+		MapClose();
+		return -1;
+	}
+	mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mh == NULL)
+	{
+		MapClose();
+		return -1;
+	}
+	data = (bsUint8 *) MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+	if (data == 0)
+	{
+		MapClose();
+		return -1;
+	}
+	size = (bsUint32) fsize;
+	return 0;
+}
+
+int FileMap::MapClose()
+{
+	if (data)
+		UnmapViewOfFile((LPCVOID) data);
+	if (mh != NULL)
+		CloseHandle(mh);
+	if (fh != INVALID_HANDLE_VALUE)
+		CloseHandle(fh);
+	data = 0;
+	size = 0;
+	mh = NULL;
+	fh = INVALID_HANDLE_VALUE;
+	return 0;
+}
+
 int SynthFileExists(const char *fname)
 {
 	DWORD attr = 0;
@@ -77,8 +77,77 @@ void SynthSignal::Wakeup()
 	if (sig != 0)
 		::SetEvent((HANDLE)sig);
 }
+
+void SynthSemaphore::Create()
+{
+	if (sem == 0)
+		sem = (void*)CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+}
+
+void SynthSemaphore::Destroy()
+{
+	if (sem != 0)
+	{
+		CloseHandle((HANDLE)sem);
+		sem = 0;
+	}
+}
+
+void SynthSemaphore::Wait()
+{
+	if (sem != 0)
+		::WaitForSingleObject((HANDLE)sem, (DWORD)-1);
+}
+
+void SynthSemaphore::Post()
+{
+	if (sem != 0)
+		::ReleaseSemaphore((HANDLE)sem, 1, NULL);
+}
+
+int SynthAtomic::Load(volatile int *p)
+{
+	int v = *p;
+	MemoryBarrier();
+	return v;
+}
+
+void SynthAtomic::Store(volatile int *p, int v)
+{
+	MemoryBarrier();
+	*p = v;
+}
+
+int SynthAtomic::CompareExchange(volatile int *p, int cmp, int v)
+{
+	return ::InterlockedCompareExchange((volatile LONG*)p, (LONG)v, (LONG)cmp) == (LONG)cmp;
+}
+
+int SynthAtomic::Add(volatile int *p, int v)
+{
+	return (int) ::InterlockedExchangeAdd((volatile LONG*)p, (LONG)v);
+}
+
+void *SynthAtomic::LoadPtr(void * volatile *p)
+{
+	void *v = *p;
+	MemoryBarrier();
+	return v;
+}
+
+void *SynthAtomic::ExchangePtr(void * volatile *p, void *v)
+{
+	return ::InterlockedExchangePointer(p, v);
+}
+
+int SynthAtomic::CompareExchangePtr(void * volatile *p, void *cmp, void *v)
+{
+	return ::InterlockedCompareExchangePointer(p, v, cmp) == cmp;
+}
+
 #endif
 
+
 #if UNIX
 #include <sys/types.h>
 #include <pthread.h>
@@ -165,4 +234,95 @@ void SynthSignal::Wakeup()
 	}
 }
 
+struct pthread_sema
+{
+	pthread_mutex_t m;
+	pthread_cond_t  c;
+	int count;
+};
+
+void SynthSemaphore::Create()
+{
+	if (sem == 0)
+	{
+		pthread_sema *e = new pthread_sema;
+		pthread_mutex_init(&e->m, NULL);
+		pthread_cond_init(&e->c, NULL);
+		e->count = 0;
+		sem = (void*)e;
+	}
+}
+
+void SynthSemaphore::Destroy()
+{
+	pthread_sema *e = (pthread_sema*)sem;
+	if (e)
+	{
+		pthread_cond_destroy(&e->c);
+		pthread_mutex_destroy(&e->m);
+		delete e;
+		sem = 0;
+	}
+}
+
+void SynthSemaphore::Wait()
+{
+	if (sem)
+	{
+		pthread_sema *e = (pthread_sema*)sem;
+		pthread_mutex_lock(&e->m);
+		while (e->count == 0)
+			pthread_cond_wait(&e->c, &e->m);
+		e->count--;
+		pthread_mutex_unlock(&e->m);
+	}
+}
+
+void SynthSemaphore::Post()
+{
+	if (sem)
+	{
+		pthread_sema *e = (pthread_sema*)sem;
+		pthread_mutex_lock(&e->m);
+		e->count++;
+		pthread_cond_signal(&e->c);
+		pthread_mutex_unlock(&e->m);
+	}
+}
+
+int SynthAtomic::Load(volatile int *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void SynthAtomic::Store(volatile int *p, int v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+int SynthAtomic::CompareExchange(volatile int *p, int cmp, int v)
+{
+	return __atomic_compare_exchange_n(p, &cmp, v, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+int SynthAtomic::Add(volatile int *p, int v)
+{
+	return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+
+void *SynthAtomic::LoadPtr(void * volatile *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void *SynthAtomic::ExchangePtr(void * volatile *p, void *v)
+{
+	return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+
+int SynthAtomic::CompareExchangePtr(void * volatile *p, void *cmp, void *v)
+{
+	return __atomic_compare_exchange_n(p, &cmp, v, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
 #endif
@@ -77,12 +77,18 @@ void SynthThread::ShortWait()
 	Sleep(1);
 }
 
+void SynthThread::YieldThread()
+{
+	SwitchToThread();
+}
+
 #endif
 
 #ifdef UNIX
 #include <unistd.h>
 #include <sys/types.h>
 #include <pthread.h>
+#include <sched.h>
 
 class ThreadInfo
 {
@@ -148,6 +154,11 @@ void SynthThread::ShortWait()
 	usleep(1000);
 }
 
+void SynthThread::YieldThread()
+{
+	sched_yield();
+}
+
 #endif
 
 SynthThread::SynthThread()
@@ -10,11 +10,190 @@
 #include <string.h>
 #include <math.h>
 #include <SynthDefs.h>
+#include <SynthMutex.h>
+#include <SynthThread.h>
 #include <WaveFile.h>
 #if _DEBUG
 #include <stdio.h>
 #endif
 
+// I/O thread for background writing. The writer posts
+// one buffer at a time. The idle semaphore is posted when
+// the buffer has been written and may be reused.
+class WaveWriterThread : public SynthThread
+{
+public:
+	WaveWriter *wr;
+	void *buf;
+	size_t len;
+	int quit;
+	SynthSemaphore work;
+	SynthSemaphore idle;
+
+	WaveWriterThread(WaveWriter *w)
+	{
+		wr = w;
+		buf = 0;
+		len = 0;
+		quit = 0;
+		work.Create();
+		idle.Create();
+		idle.Post();
+	}
+
+	int ThreadProc()
+	{
+		for (;;)
+		{
+			work.Wait();
+			if (quit)
+				break;
+			if (wr->wfp.FileWrite(buf, len) != (int) len)
+				wr->err = -1;
+			idle.Post();
+		}
+		return 0;
+	}
+};
+
+WaveWriter::WaveWriter()
+{
+	thrd = 0;
+	byteTotal = 0;
+	large = 0;
+	err = 0;
+}
+
+WaveWriter::~WaveWriter()
+{
+	Close();
+}
+
+int WaveWriter::Open(const char *fname, int bg, int lg)
+{
+	Close();
+	byteTotal = 0;
+	large = lg;
+	err = 0;
+	if (wfp.FileOpen(fname))
+		return -1;
+	if (bg)
+	{
+		thrd = new WaveWriterThread(this);
+		if (thrd->StartThread())
+		{
+			delete thrd;
+			thrd = 0;
+		}
+	}
+	return 0;
+}
+
+static void SetChunkId(RiffChunk& ck, const char *id)
+{
+	memcpy(ck.chunkId, id, CHUNK_ID);
+}
+
+int WaveWriter::WriteHeader(void *hdr, int len, bsInt64 frames)
+{
+	if (Flush())
+		return -1;
+
+	bsUint8 buf[256];
+	if (len < 20 || len + (int) sizeof(Ds64Chunk) > (int) sizeof(buf))
+		return -1;
+
+	// RIFF + WAVE, optional ds64, then the rest of the header
+	memcpy(buf, hdr, 12);
+	int pos = 12;
+	if (large)
+		pos += sizeof(Ds64Chunk);
+	memcpy(&buf[pos], (bsUint8 *) hdr + 12, len - 12);
+	int hdrSize = pos + len - 12;
+
+	RiffChunk *riff = (RiffChunk *) buf;
+	RiffChunk *data = (RiffChunk *) &buf[hdrSize - CHUNK_SIZE];
+	bsInt64 riffSize = byteTotal + hdrSize - CHUNK_SIZE;
+	if (riffSize > (bsInt64) 0xFFFFFFFF)
+	{
+		// Over the RIFF limit. Without a ds64 chunk the best
+		// we can do is to leave the sizes at their maximum.
+		riff->chunkSize = (bsInt32) 0xFFFFFFFF;
+		data->chunkSize = (bsInt32) 0xFFFFFFFF;
+	}
+	else
+	{
+		riff->chunkSize = (bsInt32) riffSize;
+		data->chunkSize = (bsInt32) byteTotal;
+	}
+
+	if (large)
+	{
+		Ds64Chunk *ds = (Ds64Chunk *) &buf[12];
+		memset(ds, 0, sizeof(Ds64Chunk));
+		ds->ds64.chunkSize = sizeof(Ds64Chunk) - CHUNK_SIZE;
+		if (riffSize > (bsInt64) 0xFFFFFFFF)
+		{
+			SetChunkId(*riff, "RF64");
+			SetChunkId(ds->ds64, "ds64");
+			ds->riffSizeLow = (bsUint32) riffSize;
+			ds->riffSizeHigh = (bsUint32) (riffSize >> 32);
+			ds->dataSizeLow = (bsUint32) byteTotal;
+			ds->dataSizeHigh = (bsUint32) (byteTotal >> 32);
+			ds->sampleCountLow = (bsUint32) frames;
+			ds->sampleCountHigh = (bsUint32) (frames >> 32);
+		}
+		else
+			SetChunkId(ds->ds64, "JUNK");
+	}
+
+	// TODO: swap bytes in the header
+	wfp.FileRewind(0);
+	if (wfp.FileWrite(buf, hdrSize) != hdrSize)
+		return -1;
+	return 0;
+}
+
+int WaveWriter::Write(void *buf, size_t len)
+{
+	if (thrd)
+	{
+		thrd->idle.Wait();
+		thrd->buf = buf;
+		thrd->len = len;
+		thrd->work.Post();
+	}
+	else if (wfp.FileWrite(buf, len) != (int) len)
+		err = -1;
+	byteTotal += (bsInt64) len;
+	return err;
+}
+
+int WaveWriter::Flush()
+{
+	if (thrd)
+	{
+		thrd->idle.Wait();
+		thrd->idle.Post();
+	}
+	return err;
+}
+
+int WaveWriter::Close()
+{
+	if (thrd)
+	{
+		Flush();
+		thrd->quit = 1;
+		thrd->work.Post();
+		thrd->WaitThread();
+		delete thrd;
+		thrd = 0;
+	}
+	wfp.FileClose();
+	return err;
+}
+
 void WaveFile::SetupWH(int ch)
 {
 	wh.riff.chunkId[0] = 'R';
@@ -33,7 +212,7 @@ void WaveFile::SetupWH(int ch)
 	wh.fmt.chunkSize = 16;
 	wh.fmtdata.fmtCode = 1;    // 1 = PCM
 	wh.fmtdata.channels = ch;    // 1 = mono, 2 = stereo
-	wh.fmtdata.sampleRate = synthParams.isampleRate;
+	wh.fmtdata.sampleRate = SynthContext::Current()->isampleRate;
 	wh.fmtdata.bits = sizeof(short) * 8;
 	wh.fmtdata.align = (wh.fmtdata.channels * wh.fmtdata.bits) / 8;
 	wh.fmtdata.avgbps = (wh.fmtdata.sampleRate * wh.fmtdata.align);
@@ -50,19 +229,24 @@ void WaveFile::SetupWH(int ch)
 // This is only designed for chnls = 1 or 2
 int WaveFile::OpenWaveFile(const char *fname, int chnls)
 {
-	wfp.FileClose();
-	if (AllocBuf(synthParams.isampleRate * bufSecs * chnls, chnls))
+	wfp.Close();
+	long buflen = SynthContext::Current()->isampleRate * bufSecs * chnls;
+	if (AllocBuf(buflen, chnls))
 		return -3;
+	delete[] spare;
+	spare = 0;
+	if (bgWrite)
+		spare = new SampleValue[buflen];
 
 	SetupWH(chnls);
 	sampleTotal = 0;
 
-	if (wfp.FileOpen(fname))
+	if (wfp.Open(fname, bgWrite, largeFile))
 		return -1;
 
-	if (wfp.FileWrite(&wh, sizeof(wh)) != sizeof(wh))
+	if (wfp.WriteHeader(&wh, sizeof(wh), 0))
 	{
-		wfp.FileClose();
+		wfp.Close();
 		return -2;
 	}
 
@@ -75,18 +259,13 @@ int WaveFile::CloseWaveFile()
 {
 	FlushOutput();
 
-	bsUint32 byteTotal = sampleTotal * sizeof(SampleValue);
-
-	wh.riff.chunkSize = byteTotal + sizeof(wh) - 8; // filesize - RIFF chunk
-	wh.data.chunkSize = byteTotal;
-
-	int err = 0;
-	wfp.FileRewind();
-	// TODO: swap bytes in the header
-	if (wfp.FileWrite(&wh, sizeof(wh)) != sizeof(wh))
+	// RIFF and data sizes are set by the writer
+	int err = wfp.WriteHeader(&wh, sizeof(wh), wfp.GetByteTotal() / wh.fmtdata.align);
+	if (wfp.Close())
 		err = -1;
-	wfp.FileClose();
 	DeallocBuf();
+	delete[] spare;
+	spare = 0;
 	return err;
 }
 
@@ -95,7 +274,15 @@ int WaveFile::FlushOutput()
 {
 	if (nxtSamp > samples)
 	{
-		wfp.FileWrite(samples, sizeof(SampleValue)*(nxtSamp - samples));
+		wfp.Write(samples, sizeof(SampleValue)*(nxtSamp - samples));
+		if (spare && wfp.IsBackground())
+		{
+			// the I/O thread now owns this buffer
+			SampleValue *full = samples;
+			samples = spare;
+			spare = full;
+			endSamp = samples + sampleMax;
+		}
 		nxtSamp = samples;
 	}
 	return 0;
@@ -119,7 +306,7 @@ void WaveFileIEEE::SetupWH(short chn)
 	wh.fmt.chunkSize = 18;
 	wh.fmtdata.fmtCode = 3; // WAVE_FORMAT_IEEE_FLOAT;
 	wh.fmtdata.channels = chn;    // 1 = mono, 2 = stereo
-	wh.fmtdata.sampleRate = synthParams.isampleRate;
+	wh.fmtdata.sampleRate = SynthContext::Current()->isampleRate;
 	wh.fmtdata.bits = sizeof(float) * 8;
 	wh.fmtdata.align = (wh.fmtdata.channels * wh.fmtdata.bits) / 8;
 	wh.fmtdata.avgbps = (wh.fmtdata.sampleRate * wh.fmtdata.align);
@@ -139,19 +326,24 @@ void WaveFileIEEE::SetupWH(short chn)
 
 int WaveFileIEEE::OpenWaveFile(char *fname, int chnls)
 {
-	wfp.FileClose();
-	if (AllocBuf(synthParams.isampleRate * bufSecs * chnls, chnls))
+	wfp.Close();
+	long buflen = SynthContext::Current()->isampleRate * bufSecs * chnls;
+	if (AllocBuf(buflen, chnls))
 		return -3;
+	delete[] spare;
+	spare = 0;
+	if (bgWrite)
+		spare = new float[buflen];
 
 	SetupWH(chnls);
 	sampleTotal = 0;
 
-	if (wfp.FileOpen(fname))
+	if (wfp.Open(fname, bgWrite, largeFile))
 		return -1;
 
-	if (wfp.FileWrite(&wh, sizeof(wh)) != sizeof(wh))
+	if (wfp.WriteHeader(&wh, sizeof(wh), 0))
 	{
-		wfp.FileClose();
+		wfp.Close();
 		return -2;
 	}
 
@@ -163,18 +355,18 @@ int WaveFileIEEE::CloseWaveFile()
 {
 	FlushOutput();
 
-	bsUint32 byteTotal = sampleTotal * sizeof(float);
-
-	wh.riff.chunkSize = byteTotal + sizeof(wh) - 8; // filesize - RIFF chunk
-	wh.data.chunkSize = byteTotal;
-	wh.sampleLength = sampleTotal / wh.fmtdata.channels;
+	bsInt64 frames = wfp.GetByteTotal() / wh.fmtdata.align;
+	if (frames > (bsInt64) 0xFFFFFFFF)
+		wh.sampleLength = (bsInt32) 0xFFFFFFFF; // ds64 has the count
+	else
+		wh.sampleLength = (bsInt32) frames;
 
-	int err = 0;
-	wfp.FileRewind();
-	if (wfp.FileWrite(&wh, sizeof(wh)) != sizeof(wh))
+	int err = wfp.WriteHeader(&wh, sizeof(wh), frames);
+	if (wfp.Close())
 		err = -1;
-	wfp.FileClose();
 	DeallocBuf();
+	delete[] spare;
+	spare = 0;
 	return err;
 }
 
@@ -182,7 +374,15 @@ int WaveFileIEEE::FlushOutput()
 {
 	if (nxtSamp > samples)
 	{
-		wfp.FileWrite(samples, sizeof(float)*(nxtSamp - samples));
+		wfp.Write(samples, sizeof(float)*(nxtSamp - samples));
+		if (spare && wfp.IsBackground())
+		{
+			// the I/O thread now owns this buffer
+			float *full = samples;
+			samples = spare;
+			spare = full;
+			endSamp = samples + sampleMax;
+		}
 		nxtSamp = samples;
 	}
 	return 0;
@@ -251,7 +451,7 @@ int WaveFileIn::LoadWaveFile(const char *fname, bsInt16 id)
 	sampleTotal = 0;
 
 	bsString path;
-	if (!synthParams.FindOnPath(path, fname))
+	if (!SynthContext::Current()->FindOnPath(path, fname))
 		return -1;
 
 	FileReadBuf wfp;
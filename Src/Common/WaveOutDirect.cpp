@@ -179,13 +179,13 @@ int WaveOutDirect::CreateSoundBuffer(HWND w, GUID *dev)
 	WAVEFORMATEX wf;
 	wf.wFormatTag = WAVE_FORMAT_PCM;
 	wf.nChannels = 2;
-    wf.nSamplesPerSec = synthParams.isampleRate;
+    wf.nSamplesPerSec = SynthContext::Current()->isampleRate;
 	wf.nBlockAlign = wf.nChannels * 2;
     wf.wBitsPerSample = 16;
     wf.nAvgBytesPerSec = wf.nSamplesPerSec * wf.nBlockAlign;
 	wf.cbSize = 0;
 
-	sampleMax = (bsInt32) ((synthParams.sampleRate * latency) * (FrqValue)wf.nChannels);
+	sampleMax = (bsInt32) ((SynthContext::Current()->sampleRate * latency) * (FrqValue)wf.nChannels);
 	if (sampleMax & 1)
 		sampleMax++;
 	blkLen = sampleMax * 2; // two bytes per sample
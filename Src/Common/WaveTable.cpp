@@ -0,0 +1,257 @@
+//////////////////////////////////////////////////////////////////
+/// @file WaveTable.cpp Wavetable calculation.
+//
+// BasicSynth
+//
+// Copyright 2008, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+/////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SynthDefs.h>
+#include <WaveTable.h>
+#include <Convolve.h>
+
+// Build the mip-map levels for table ti from its packed spectrum.
+// Each level zeroes the bins above its highest partial, is inverse
+// transformed and scaled by scl. Levels that would hold every
+// partial in the spectrum share the original table.
+static AmpValue **BuildMipMap(AmpValue *wavTable, bsInt32 len, bsInt32 levels,
+                              FFTRealT<double>& fft, const double *spc, double scl)
+{
+	bsInt32 half = len / 2;
+	bsInt32 k;
+
+	// Find the highest partial. Bins far below the strongest
+	// are rounding noise from analysis of a stored table.
+	double peak = 0;
+	for (k = 1; k < half; k++)
+	{
+		double mag = fabs(spc[2*k]) + fabs(spc[2*k+1]);
+		if (mag > peak)
+			peak = mag;
+	}
+	double floor = peak * 1e-6;
+	bsInt32 top = 0;
+	for (k = half - 1; k > 0; k--)
+	{
+		if ((fabs(spc[2*k]) + fabs(spc[2*k+1])) > floor)
+		{
+			top = k;
+			break;
+		}
+	}
+
+	AmpValue **mip = new AmpValue*[levels];
+	double *buf = new double[len];
+	for (bsInt32 lvl = 0; lvl < levels; lvl++)
+	{
+		bsInt32 hi = len >> (lvl + 1);
+		if (hi >= top)
+		{
+			mip[lvl] = wavTable;
+			continue;
+		}
+		memcpy(buf, spc, len*sizeof(double));
+		buf[1] = 0;
+		for (k = hi + 1; k < half; k++)
+		{
+			buf[2*k] = 0;
+			buf[2*k+1] = 0;
+		}
+		fft.Inverse(buf);
+		AmpValue *tbl = new AmpValue[len+1];
+		for (k = 0; k < len; k++)
+			tbl[k] = (AmpValue) (buf[k] * scl);
+		tbl[len] = tbl[0];
+		mip[lvl] = tbl;
+	}
+	delete[] buf;
+	return mip;
+}
+
+void WaveTableSet::FreeMipMap(bsInt32 ti)
+{
+	if (ti < 0 || ti >= wavTblMax)
+		return;
+	AmpValue **mip = wavSet[ti].wavMip;
+	if (mip)
+	{
+		for (bsInt32 lvl = 0; lvl < mipLevels; lvl++)
+		{
+			if (mip[lvl] != wavSet[ti].wavTbl)
+				delete[] mip[lvl];
+		}
+		delete[] mip;
+		wavSet[ti].wavMip = 0;
+	}
+}
+
+int WaveTableSet::MipMap(bsInt32 ti)
+{
+	if (ti < 0 || ti >= wavTblMax || wavSet[ti].wavTbl == 0 || mipLevels == 0)
+		return -1;
+
+	FFTRealT<double> fft;
+	if (fft.Init(itableLength) != 0)
+		return -1;
+
+	FreeMipMap(ti);
+	AmpValue *wavTable = wavSet[ti].wavTbl;
+	double *spc = new double[itableLength];
+	for (bsInt32 index = 0; index < itableLength; index++)
+		spc[index] = (double) wavTable[index];
+	fft.Forward(spc);
+	wavSet[ti].wavMip = BuildMipMap(wavTable, itableLength, mipLevels, fft, spc, 1.0);
+	delete[] spc;
+	return 0;
+}
+
+int WaveTableSet::SetWaveTable(bsInt32 ti, bsInt32 nparts, bsInt32 *mul, double *amp, double *phs, int gibbs)
+{
+	if (ti < 0 || ti >= wavTblMax || amp == NULL)
+		return -1;
+
+	AmpValue *wavTable = wavSet[ti].wavTbl;
+	if (wavTable == 0)
+	{
+		wavTable = new AmpValue[itableLength+1];
+		if (wavTable == NULL)
+			return -1;
+		wavSet[ti].wavTbl = wavTable;
+	}
+	FreeMipMap(ti);
+
+	double *sigma = new double[nparts];
+
+	double incr = twoPI / (double) ftableLength;
+	int index = 0;
+	int mulMax = 0;
+	int partNum;
+	int partMax = 0;
+	for (partNum = 0; partNum < nparts; partNum++)
+	{
+		double phsInc;
+		if (mul != NULL)
+		{
+			if (mul[partNum] > mulMax)
+				mulMax = mul[partNum];
+			phsInc = incr * mul[partNum];
+		}
+		else
+			phsInc = incr * (partNum + 1);
+		if (phsInc < PI)
+			partMax++;
+	}
+
+	if (mulMax == 0)
+		mulMax = partMax;
+	double value;
+	double maxvalue = 0.00001;
+	double sigK = PI / (double) mulMax;
+	for (partNum = 0; partNum < partMax; partNum++)
+	{
+		sigma[partNum] = 1.0;
+		if (gibbs)
+		{
+			if (mul)
+				value = mul[partNum] * sigK;
+			else
+				value = (double) partNum * sigK;
+			if (value > 0)
+				sigma[partNum] = sin(value) / value;
+		}
+	}
+
+	FFTRealT<double> fft;
+	if (fft.Init(itableLength) == 0)
+	{
+		// Each partial is one bin of the spectrum:
+		// a*sin(2*PI*m*n/N + p) = Re(X[m] * e^(2*PI*i*m*n/N)) * 2/N
+		// with X[m] = (N/2) * a * (sin(p) - i*cos(p)).
+		bsInt32 half = itableLength / 2;
+		double *spc = new double[itableLength];
+		double *buf = new double[itableLength];
+		memset(spc, 0, itableLength*sizeof(double));
+		for (partNum = 0; partNum < partMax; partNum++)
+		{
+			if (amp[partNum] == 0)
+				continue;
+			bsInt32 m = mul ? mul[partNum] : (partNum + 1);
+			double a = amp[partNum] * sigma[partNum];
+			double p = phs ? phs[partNum] : 0.0;
+			if (m < 0)
+			{
+				m = -m;
+				a = -a;
+				p = -p;
+			}
+			if (m == 0)
+				spc[0] += a * sin(p) * (double) itableLength;
+			else if (m < half)
+			{
+				spc[2*m] += a * sin(p) * (double) half;
+				spc[2*m+1] -= a * cos(p) * (double) half;
+			}
+		}
+		memcpy(buf, spc, itableLength*sizeof(double));
+		fft.Inverse(buf);
+		for (index = 0; index < itableLength; index++)
+		{
+			value = buf[index];
+			wavTable[index] = (AmpValue) value;
+			if (fabs(value) > maxvalue)
+				maxvalue = fabs(value);
+		}
+		if (mipOn && mipLevels > 0)
+			wavSet[ti].wavMip = BuildMipMap(wavTable, itableLength, mipLevels, fft, spc, 1.0 / maxvalue);
+		delete[] spc;
+		delete[] buf;
+	}
+	else
+	{
+		// Not a power of two, sum the partials directly.
+		double *phsVal = new double[nparts];
+		double *phsInc = new double[nparts];
+		for (partNum = 0; partNum < nparts; partNum++)
+		{
+			if (mul != NULL)
+				phsInc[partNum] = incr * mul[partNum];
+			else
+				phsInc[partNum] = incr * (partNum + 1);
+			if (phs)
+				phsVal[partNum] = phs[partNum];
+			else
+				phsVal[partNum] = 0.0;
+		}
+		for (index = 0; index < itableLength; index++)
+		{
+			value = 0;
+			for (partNum = 0; partNum < partMax; partNum++)
+			{
+				if (amp[partNum] != 0)
+				{
+					value += sin(phsVal[partNum]) * amp[partNum] * sigma[partNum];
+					phsVal[partNum] += phsInc[partNum];
+				}
+			}
+			wavTable[index] = (AmpValue) value;
+			if (fabs(value) > maxvalue)
+				maxvalue = fabs(value);
+		}
+		delete[] phsVal;
+		delete[] phsInc;
+	}
+
+	// Normalize summed values
+	for (index = 0; index < itableLength; index++)
+		wavTable[index] = wavTable[index] / (AmpValue) maxvalue;
+
+	wavTable[itableLength] = wavTable[0];
+	delete[] sigma;
+
+	return 0;
+}
@@ -26,6 +26,7 @@
 #include "GenNoise.h"
 #include "BiQuad.h"
 #include "AllPass.h"
+#include "Convolve.h"
 #include "Filter.h"
 #include "DynFilter.h"
 
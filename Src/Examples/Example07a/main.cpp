@@ -21,6 +21,7 @@
 #include "GenWaveWT.h"
 #include "EnvGen.h"
 #include "DelayLine.h"
+#include "Convolve.h"
 #include "Reverb.h"
 
 int main(int argc, char *argv[])
@@ -20,6 +20,7 @@
 #include "WaveTable.h"
 #include "EnvGen.h"
 #include "DelayLine.h"
+#include "Convolve.h"
 #include "Filter.h"
 #include "AllPass.h"
 #include "GenNoise.h"
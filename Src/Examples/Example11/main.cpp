@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////
+// BasicSynth - Example 11
+//
+// Unit generator benchmark.
+// Runs each unit generator one sample at a time through
+// Sample() and a block at a time through Samples(), checks
+// the two produce the same output, and prints the throughput
+// of each in samples per second.
+//
+// use: Example11 [seconds [blocksize]]
+//
+// Copyright 2008, Daniel R. Mitchell
+// License: Creative Commons/GNU-GPL
+// (http://creativecommons.org/licenses/GPL/2.0/)
+// (http://www.gnu.org/licenses/gpl.html)
+///////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "SynthDefs.h"
+#include "WaveTable.h"
+#include "GenWave.h"
+#include "GenWaveWT.h"
+#include "EnvGenSeg.h"
+#include "BiQuad.h"
+#include "Convolve.h"
+#include "Filter.h"
+#include "DelayLine.h"
+
+#define MAXBLK 1024
+
+enum UnitType
+{
+	ugWT = 0,
+	ugWTI,
+	ugWT32,
+	ugLP,
+	ugBP,
+	ugIIR2p,
+	ugADSR,
+	ugDLR,
+	ugAP,
+	ugCount
+};
+
+static const char *unitName[ugCount] =
+{
+	"GenWaveWT",
+	"GenWaveI",
+	"GenWave32",
+	"FilterLP",
+	"FilterBP",
+	"FilterIIR2p",
+	"EnvGenADSR",
+	"DelayLineR",
+	"AllPassDelay"
+};
+
+GenUnit *MakeUnit(int which)
+{
+	switch (which)
+	{
+	case ugWT:
+	{
+		GenWaveWT *wt = new GenWaveWT;
+		wt->InitWT(440.0, WT_SAW);
+		return wt;
+	}
+	case ugWTI:
+	{
+		GenWaveI *wi = new GenWaveI;
+		wi->InitWT(440.0, WT_SAW);
+		return wi;
+	}
+	case ugWT32:
+	{
+		GenWave32 *w32 = new GenWave32;
+		w32->InitWT(440.0, WT_SAW);
+		return w32;
+	}
+	case ugLP:
+	{
+		FilterLP *lp = new FilterLP;
+		lp->Init(1000.0, 2.0, 1.0);
+		return lp;
+	}
+	case ugBP:
+	{
+		FilterBP *bp = new FilterBP;
+		bp->Init(1000.0, 2.0, 1.0);
+		return bp;
+	}
+	case ugIIR2p:
+	{
+		FilterIIR2p *iir = new FilterIIR2p;
+		iir->CalcCoef(1000.0, 2.0);
+		return iir;
+	}
+	case ugADSR:
+	{
+		EnvGenADSR *eg = new EnvGenADSR;
+		eg->InitADSR(0.0, 0.1, 1.0, 0.2, 0.7, 0.5, 0.0, expSeg);
+		return eg;
+	}
+	case ugDLR:
+	{
+		DelayLineR *dl = new DelayLineR;
+		dl->InitDLR(0.013, 1.0, 0.001);
+		return dl;
+	}
+	case ugAP:
+	{
+		AllPassDelay *ap = new AllPassDelay;
+		ap->InitDLR(0.007, 0.5, 0.001);
+		return ap;
+	}
+	}
+	return new GenUnit;
+}
+
+// Release the envelope half way through so that
+// all of its states are exercised.
+void Release(int which, GenUnit *gen)
+{
+	if (which == ugADSR)
+		((EnvGenADSR*)gen)->Release();
+}
+
+int main(int argc, char *argv[])
+{
+	FrqValue duration = 60;
+	int blkSize = 256;
+
+	if (argc > 1)
+		duration = atof(argv[1]);
+	if (argc > 2)
+		blkSize = atoi(argv[2]);
+	if (blkSize < 1)
+		blkSize = 1;
+	else if (blkSize > MAXBLK)
+		blkSize = MAXBLK;
+
+	InitSynthesizer();
+
+	long totalSamples = (long) (synthParams.sampleRate * duration);
+	long numBlocks = (totalSamples + blkSize - 1) / blkSize;
+	totalSamples = numBlocks * blkSize;
+
+	// input signal: a sawtooth with a little noise
+	AmpValue inBuf[MAXBLK];
+	AmpValue outSmp[MAXBLK];
+	AmpValue outBlk[MAXBLK];
+	int n;
+	for (n = 0; n < blkSize; n++)
+		inBuf[n] = ((AmpValue) (n % 100) / 50.0) - 1.0
+		         + (((AmpValue) rand() / (AmpValue) RAND_MAX) - 0.5) * 0.01;
+
+	printf("%ld samples, block size %d\n", totalSamples, blkSize);
+	printf("%-14s %14s %14s %8s\n", "Unit", "Sample/sec", "Samples/sec", "Ratio");
+
+	int errors = 0;
+	for (int which = 0; which < ugCount; which++)
+	{
+		GenUnit *genSmp = MakeUnit(which);
+		GenUnit *genBlk = MakeUnit(which);
+
+		SampleBlock blk;
+		blk.size = blkSize;
+		blk.in = inBuf;
+		blk.out = outBlk;
+
+		// verify the block kernel against the per-sample path
+		int match = 1;
+		long b;
+		for (b = 0; b < numBlocks && match; b++)
+		{
+			if (b == numBlocks / 2)
+			{
+				Release(which, genSmp);
+				Release(which, genBlk);
+			}
+			for (n = 0; n < blkSize; n++)
+				outSmp[n] = genSmp->Sample(inBuf[n]);
+			genBlk->Samples(&blk);
+			match = memcmp(outSmp, outBlk, blkSize * sizeof(AmpValue)) == 0;
+		}
+		delete genSmp;
+		delete genBlk;
+
+		// time each path on a fresh object
+		AmpValue sum = 0;
+		genSmp = MakeUnit(which);
+		clock_t st = clock();
+		for (b = 0; b < numBlocks; b++)
+		{
+			if (b == numBlocks / 2)
+				Release(which, genSmp);
+			for (n = 0; n < blkSize; n++)
+				outSmp[n] = genSmp->Sample(inBuf[n]);
+			sum += outSmp[0];
+		}
+		double tmSmp = (double) (clock() - st) / (double) CLOCKS_PER_SEC;
+		delete genSmp;
+
+		genBlk = MakeUnit(which);
+		st = clock();
+		for (b = 0; b < numBlocks; b++)
+		{
+			if (b == numBlocks / 2)
+				Release(which, genBlk);
+			genBlk->Samples(&blk);
+			sum += outBlk[0];
+		}
+		double tmBlk = (double) (clock() - st) / (double) CLOCKS_PER_SEC;
+		delete genBlk;
+
+		if (tmSmp <= 0)
+			tmSmp = 1e-6;
+		if (tmBlk <= 0)
+			tmBlk = 1e-6;
+		printf("%-14s %14.0f %14.0f %7.2fx%s\n", unitName[which],
+			(double) totalSamples / tmSmp, (double) totalSamples / tmBlk,
+			tmSmp / tmBlk, match ? "" : "  MISMATCH");
+		if (!match)
+			errors++;
+		if (sum == 12345.678) // keep the optimizer honest
+			printf(" ");
+	}
+
+	return errors ? 1 : 0;
+}
@@ -22,6 +22,7 @@
 #include "WaveFile.h"
 #include "EnvGenSeg.h"
 #include "GenWaveWT.h"
+#include "Convolve.h"
 #include "Filter.h"
 #include "Mixer.h"
 #include "SFFile.h"
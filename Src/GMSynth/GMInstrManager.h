@@ -25,16 +25,24 @@
 /// note. A possible improvement is to maintain a cache
 /// of instruments, much the same way a keyboard synth
 /// has a fixed number of voices.
+///
+/// Output values are accumulated for each frame in the
+/// block so that the sequencer can render by blocks.
+/// When not rendering by blocks, only the first frame is used.
+/// When voices are rendered on worker threads, output from
+/// those threads goes to the thread's MixBus and is passed
+/// back through these methods on the sequencer thread.
 class GMInstrManager : public InstrManager
 {
 protected:
-	AmpValue outLft;
-	AmpValue outRgt;
-	AmpValue outRvrb;
+	AmpValue outLft[MAX_BLKLEN];
+	AmpValue outRgt[MAX_BLKLEN];
+	AmpValue outRvrb[MAX_BLKLEN];
 	AmpValue masterVol;
 	AmpValue reverbMix;
 	Reverb2 reverb;
 	GMPlayer *gm;
+	InstrConfig *gmCfg;
 
 public:
 	GMInstrManager()
@@ -43,7 +51,7 @@ public:
 		reverbMix = 0.1;
 		InstrMapEntry *ime = AddType("GMPlayer", GMPlayer::InstrFactory, GMPlayer::EventFactory);
 		gm = new GMPlayer;
-		AddInstrument(1, ime, gm);
+		gmCfg = AddInstrument(1, ime, gm);
 		gm->SetParam(16, GMPLAYER_LOCAL_PAN|GMPLAYER_LOCAL_FX|GMPLAYER_LOCAL_VOL);
 	}
 
@@ -68,19 +76,21 @@ public:
 		// don't discard the GMManager object.
 	}
 
+	// All notes play through the one GMPlayer template so that
+	// instances come from, and return to, its pool.
 	virtual Instrument *Allocate(bsInt16 inum)
 	{
-		return GMPlayer::InstrFactory(this, gm);
+		return InstrManager::Allocate(gmCfg);
 	}
 
 	virtual Instrument *Allocate(InstrConfig *in)
 	{
-		return GMPlayer::InstrFactory(this, gm);
+		return InstrManager::Allocate(gmCfg);
 	}
 
 	virtual void Deallocate(Instrument *ip)
 	{
-		ip->Destroy();
+		InstrManager::Deallocate(ip);
 	}
 
 	virtual SeqEvent *ManufEvent(bsInt16 inum)
@@ -103,43 +113,122 @@ public:
 	virtual void Start()
 	{
 		InstrManager::Start();
-		outLft = 0;
-		outRgt = 0;
-		outRvrb = 0;
+		memset(outLft, 0, sizeof(outLft));
+		memset(outRgt, 0, sizeof(outRgt));
+		memset(outRvrb, 0, sizeof(outRvrb));
 		reverb.InitReverb(0.25, 1.0);
 	}
 
 	/// Tick outputs the current sample.
 	virtual void Tick()
 	{
-		AmpValue rv = reverb.Sample(outRvrb) * reverbMix;
-		wvf->Output2(masterVol * (outLft + rv), masterVol * (outRgt + rv));
-		outLft = 0;
-		outRgt = 0;
-		outRvrb = 0;
+		AmpValue rv = reverb.Sample(outRvrb[blkPos]) * reverbMix;
+		wvf->Output2(masterVol * (outLft[blkPos] + rv), masterVol * (outRgt[blkPos] + rv));
+		outLft[blkPos] = 0;
+		outRgt[blkPos] = 0;
+		outRvrb[blkPos] = 0;
+	}
+
+	/// TickBlock outputs the samples for a block.
+	/// This does not use the mixer.
+	virtual void TickBlock(int frames)
+	{
+		for (int n = 0; n < frames; n++)
+		{
+			SetBlockPos(n);
+			Tick();
+		}
+		SetBlockPos(0);
 	}
 
 	/// FxSend sends values to an effects unit
 	/// This only implements reverb (unit 0)
 	virtual void FxSend(int unit, AmpValue val)
 	{
-		if (unit == 0)
-			outRvrb += val;
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->FxIn(unit, val);
+		else if (unit == 0)
+			outRvrb[blkPos] += val;
+	}
+
+	/// FxSendBlock sends a block of values to an effects unit
+	virtual void FxSendBlock(int unit, AmpValue *val, int frames)
+	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+			bus->FxInBlock(unit, val, frames);
+		else if (unit == 0)
+		{
+			AmpValue *rp = &outRvrb[blkPos];
+			for (int n = 0; n < frames; n++)
+				rp[n] += val[n];
+		}
 	}
 
 	/// Output a mono sample
 	virtual void Output(int ch, AmpValue val)
 	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+		{
+			bus->In(ch, val);
+			return;
+		}
 		val *= GetVolumeN(ch) * 0.5;
-		outLft += val;
-		outRgt += val;
+		outLft[blkPos] += val;
+		outRgt[blkPos] += val;
+	}
+
+	/// Output a block of mono samples
+	virtual void OutputBlock(int ch, AmpValue *val, int frames)
+	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+		{
+			bus->InBlock(ch, val, frames);
+			return;
+		}
+		AmpValue vol = GetVolumeN(ch) * 0.5;
+		AmpValue *lp = &outLft[blkPos];
+		AmpValue *rp = &outRgt[blkPos];
+		for (int n = 0; n < frames; n++)
+		{
+			AmpValue v = val[n] * vol;
+			lp[n] += v;
+			rp[n] += v;
+		}
 	}
 
 	/// Output a stereo sample
 	virtual void Output2(int ch, AmpValue lft, AmpValue rgt)
 	{
-		outLft += lft;
-		outRgt += rgt;
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+		{
+			bus->In2(ch, lft, rgt);
+			return;
+		}
+		outLft[blkPos] += lft;
+		outRgt[blkPos] += rgt;
+	}
+
+	/// Output a block of stereo samples
+	virtual void Output2Block(int ch, AmpValue *lft, AmpValue *rgt, int frames)
+	{
+		MixBus *bus;
+		if ((bus = ThreadBus()) != 0)
+		{
+			bus->In2Block(ch, lft, rgt, frames);
+			return;
+		}
+		AmpValue *lp = &outLft[blkPos];
+		AmpValue *rp = &outRgt[blkPos];
+		for (int n = 0; n < frames; n++)
+		{
+			lp[n] += lft[n];
+			rp[n] += rgt[n];
+		}
 	}
 };
 #endif
@@ -67,6 +67,7 @@ public:
 		sbnk = 0;
 		seqMode = seqOff;
 		seq.SetMaxNotes(32);
+		seq.SetChase(SEQ_CHASE_CTL|SEQ_CHASE_NOTES);
 		kbd.SetSequenceInfo(&seq, &inmgr);
 		wvf.SetBufSize(30);
 		ldTm = 0.5;
@@ -504,12 +505,12 @@ int GMSynthDLL::LoadSoundBank(const char *alias, const char *fileName, int prelo
 	if (SFFile::IsSF2File(fileName))
 	{
 		SFFile file;
-		sb = file.LoadSoundBank(fileName, preload);
+		sb = file.LoadSoundBank(fileName, preload & GMSYNTH_LOAD_PRELOAD, preload & GMSYNTH_LOAD_MAPPED);
 	}
 	else if (DLSFile::IsDLSFile(fileName))
 	{
 		DLSFile file;
-		sb = file.LoadSoundBank(fileName, preload);
+		sb = file.LoadSoundBank(fileName, preload & GMSYNTH_LOAD_PRELOAD, preload & GMSYNTH_LOAD_MAPPED);
 	}
 	else
 		return GMSYNTH_ERR_FILETYPE;
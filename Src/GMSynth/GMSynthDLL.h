@@ -53,6 +53,10 @@
 #define GMSYNTH_MODE_SEQUENCE 1 ///< Play the sequence once
 #define GMSYNTH_MODE_SEQPLAY  2 ///< Play both
 
+// Flags for the LoadSoundBank preload argument
+#define GMSYNTH_LOAD_PRELOAD  1 ///< Load all samples
+#define GMSYNTH_LOAD_MAPPED   2 ///< Map sample data from the file (shared)
+
 #define GMSYNTH_NOERROR       0
 #define GMSYNTH_ERR_BADHANDLE 1
 #define GMSYNTH_ERR_FILETYPE  2
@@ -141,6 +141,8 @@ int AddSynth::SetNumParts(int n)
 {
 	if (n < 1)
 		return -1;
+	if (n == numParts)
+		return 0;
 	AddSynthPart *newParts = new AddSynthPart[n];
 	if (newParts == NULL)
 		return -1;
@@ -193,7 +195,7 @@ void AddSynth::UpdateParams(SeqEvent *evt, float initPhs)
 {
 	SetParams((VarParamEvent *)evt);
 
-	FrqValue nyquist = synthParams.sampleRate / 2;
+	FrqValue nyquist = im->GetContext()->sampleRate / 2;
 	AddSynthPart *pEnd = &parts[numParts];
 	AddSynthPart *pSig = parts;
 	for (pSig = parts; pSig < pEnd; pSig++)
@@ -225,7 +227,7 @@ void AddSynth::Tick()
 	PhsAccum phs = 0;
 	int lfoOn = lfoGen.On();
 	if (lfoOn)
-		phs = lfoGen.Gen() * synthParams.frqTI;
+		phs = lfoGen.Gen() * im->GetContext()->frqTI;
 
 	AmpValue sigVal = 0;
 	AddSynthPart *pSig = parts;
@@ -260,6 +262,14 @@ void AddSynth::Destroy()
 	delete this;
 }
 
+int AddSynth::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((AddSynth *)tmplt);
+	return 1;
+}
+
 /*************
 <instr parts="n">
  <part pn="n"  mul="n" frq="n" wt="n" />
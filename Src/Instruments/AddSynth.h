@@ -118,6 +118,8 @@ public:
 	virtual int  IsFinished();
 	/// @copydoc Instrument::Destroy
 	virtual void Destroy();
+	/// @copydoc Instrument::Recycle
+	virtual int Recycle(Opaque tmplt);
 
 	/// @copydoc Instrument::Load
 	int Load(XmlSynthElem *parent);
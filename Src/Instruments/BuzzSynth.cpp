@@ -187,7 +187,7 @@ void BuzzSynth::Start(SeqEvent *evt)
 		pbWT.SetDurationS(evt->duration);
 		pbWT.Reset(0);
 	}
-	pwFrq = (frq * synthParams.GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+	pwFrq = (frq * im->GetContext()->GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
 }
 
 void BuzzSynth::Param(SeqEvent *evt)
@@ -196,7 +196,7 @@ void BuzzSynth::Param(SeqEvent *evt)
 	{
 		ControlEvent *cevt = (ControlEvent *)evt;
 		if ((cevt->mmsg & MIDI_EVTMSK) == MIDI_PWCHG)
-			pwFrq = (frq * synthParams.GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+			pwFrq = (frq * im->GetContext()->GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
 		return; // TODO: process controller changes
 	}
 	SetParams((VarParamEvent *)evt);
@@ -241,6 +241,14 @@ void BuzzSynth::Destroy()
 	delete this;
 }
 
+int BuzzSynth::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((BuzzSynth *)tmplt);
+	return 1;
+}
+
 int BuzzSynth::SetParams(VarParamEvent *evt)
 {
 	int err = 0;
@@ -119,13 +119,13 @@ protected:
 
 	void Start()
 	{
-		frqMult = synthParams.GetCentsMult((int)frqScl);
+		frqMult = osc.GetContext()->GetCentsMult((int)frqScl);
 		osc.InitDSB(frqBase * frqMult, frqRatio, harmMax, ampBase);
 		if (modOn & BUZZ_RELFRQ)
 			fltFreq = osc.GetFrequency();
 		else
-			fltFreq = synthParams.GetFrequency(0);
-		fltLast = fltFreq * synthParams.GetCentsMult((int)fltBase);
+			fltFreq = osc.GetContext()->GetFrequency(0);
+		fltLast = fltFreq * osc.GetContext()->GetCentsMult((int)fltBase);
 		flt.CalcCoef(fltLast, fltQ);
 		flt.Reset();
 		envSig.Reset();
@@ -145,7 +145,7 @@ protected:
 
 	inline void Reset()
 	{
-		frqMult = synthParams.GetCentsMult((int)frqScl);
+		frqMult = osc.GetContext()->GetCentsMult((int)frqScl);
 		osc.SetFrequency(frqBase * frqMult);
 		if (!(modOn & BUZZ_MHARM))
 			osc.SetRatio(ampBase);
@@ -162,7 +162,7 @@ protected:
 		AmpValue modVal = envMod.Gen();
 		if (modOn & BUZZ_MFILT)
 		{
-			FrqValue fc = fltFreq * synthParams.GetCentsMult((int)(fltBase + (modVal * fltScl)));
+			FrqValue fc = fltFreq * osc.GetContext()->GetCentsMult((int)(fltBase + (modVal * fltScl)));
 			if (fc != fltLast)
 				flt.CalcCoef(fltLast = fc, fltQ);
 		}
@@ -236,6 +236,7 @@ public:
 	virtual void Tick();
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
@@ -206,6 +206,14 @@ void Chuffer::Destroy()
 	delete this;
 }
 
+int Chuffer::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((Chuffer *)tmplt);
+	return 1;
+}
+
 void Chuffer::Start(SeqEvent *evt)
 {
 	SetParams((VarParamEvent*)evt);
@@ -226,7 +234,8 @@ void Chuffer::Start(SeqEvent *evt)
 	AmpValue rend = resTrackMul ? rst * resMul : resEnd;
 	envRes.InitSeg(rrt, rst, rend);
 
-	nz.InitH(nzSampl * synthParams.sampleRate);
+	nz.Seed((bsUint32) evt->evid);
+	nz.InitH(nzSampl * im->GetContext()->sampleRate);
 	chpOsc.InitWT(chpFrq, chpWT);
 	modOsc.InitWT(modFrq, WT_SIN);
 	swpOsc.InitWT(swpFrq, swpWT);
@@ -259,7 +268,8 @@ void Chuffer::Stop()
 	envSig.Release();
 }
 
-void Chuffer::Tick()
+// Filter and modulators applied to one noise value.
+inline AmpValue Chuffer::Process(AmpValue out)
 {
 	AmpValue fc = envFlt.Gen();
 	AmpValue q = envRes.Gen();
@@ -280,15 +290,34 @@ void Chuffer::Tick()
 	// 1) filter the noise then apply amplitude
 	// 2) apply amplitude then filter
 	// The difference (if any) is subtle; we do #1 here...
-	AmpValue out = nz.Gen();
 	if (modOn)
 		out *= modOsc.Gen();
 	out = filt.Sample(out);
 	if (chpOn)
 		out *= chpAmp * ((chpOsc.Gen() + 1.0) * 0.5);
+	return out;
+}
+
+void Chuffer::Tick()
+{
+	AmpValue out = Process(nz.Gen());
 	im->Output(chnl, out * envSig.Gen());
 }
 
+// The noise and envelope for the whole block are generated
+// first, then the noise is shaped in place one sample at a time.
+int Chuffer::TickBlock(int frames)
+{
+	AmpValue out[MAX_BLKLEN];
+	AmpValue eg[MAX_BLKLEN];
+	nz.GenBlock(out, frames);
+	envSig.GenBlock(eg, frames);
+	for (int n = 0; n < frames; n++)
+		out[n] = Process(out[n]) * eg[n];
+	im->OutputBlock(chnl, out, frames);
+	return 1;
+}
+
 int  Chuffer::IsFinished()
 {
 	return envSig.IsFinished();
@@ -303,7 +332,7 @@ int Chuffer::SetParams(VarParamEvent *params)
 	if (params->noteonvel > 0)
 		vol *= ((float)params->noteonvel / 127.0);
 	frq = params->frq;
-	dur = params->duration / synthParams.sampleRate;
+	dur = params->duration / SynthContext::Current()->sampleRate;
 	bsInt16 *id = params->idParam;
 	float *valp = params->valParam;
 	int n = params->numParam;
@@ -74,6 +74,7 @@ private:
 	InstrManager *im;
 
 	void SetDefaults();
+	AmpValue Process(AmpValue out);
 
 public:
 	Chuffer();
@@ -90,8 +91,10 @@ public:
 	virtual void Param(SeqEvent *evt);
 	virtual void Stop();
 	virtual void Tick();
+	virtual int  TickBlock(int frames);
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
@@ -100,7 +100,7 @@ FMSynth::FMSynth()
 		gen3EnvDef.Set(i, 0, 0, linSeg);
 		nzEnvDef.Set(i, 0, 0, linSeg);
 	}
-	maxPhs = synthParams.ftableLength / 2;
+	maxPhs = SynthContext::Current()->ftableLength / 2;
 	gen1Mult = 1.0;
 	gen2Mult = 1.0;
 	gen3Mult = 2.0;
@@ -121,12 +121,13 @@ FMSynth::FMSynth()
 	dlySamps = 0;
 	panOn  = 0;
 	pbOn = 0;
+	relOn = 0;
 }
 
 FMSynth::FMSynth(FMSynth *tp)
 {
 	im = 0;
-	maxPhs = synthParams.ftableLength / 2;
+	maxPhs = SynthContext::Current()->ftableLength / 2;
 	Copy(tp);
 }
 
@@ -182,7 +183,7 @@ void FMSynth::Copy(FMSynth *ip)
 
 AmpValue FMSynth::CalcPhaseMod(AmpValue amp, FrqValue mult)
 {
-	amp = (amp * mult) * synthParams.frqTI;
+	amp = (amp * mult) * im->GetContext()->frqTI;
 	if (amp > maxPhs)
 		amp = maxPhs;
 	return amp;
@@ -193,6 +194,7 @@ void FMSynth::Start(SeqEvent *evt)
 	SetParams((VarParamEvent*)evt);
 	FrqValue mul1 = gen2Mult * frq;
 	FrqValue mul2 = gen3Mult * frq;
+	relOn = 0;
 	gen1Osc.InitWT(frq*gen1Mult, gen1Wt);
 	gen2Osc.InitWT(mul1, gen2Wt);
 	gen3Osc.InitWT(mul2, gen3Wt);
@@ -224,7 +226,8 @@ void FMSynth::Start(SeqEvent *evt)
 	nzOn = nzMix > 0;
 	if (nzOn)
 	{
-		nzi.InitH(nzFrqh * synthParams.sampleRate);
+		nzi.Seed((bsUint32) evt->evid);
+		nzi.InitH(nzFrqh * im->GetContext()->sampleRate);
 		nzo.InitWT(nzFrqo, WT_SIN);
 		nzEG.SetEnvDef(&nzEnvDef);
 		nzEG.Reset(0);
@@ -808,6 +811,7 @@ int FMSynth::GetParam(bsInt16 id, float *val)
 
 void FMSynth::Stop()
 {
+	relOn = 1;
 	gen1EG.Release();
 	gen2EG.Release();
 	gen3EG.Release();
@@ -826,7 +830,9 @@ int FMSynth::IsFinished()
 	return 0;
 }
 
-void FMSynth::Tick()
+// Generate one frame from the envelope values.
+// The returned value includes the volume.
+inline AmpValue FMSynth::Frame(AmpValue eg1, AmpValue eg2, AmpValue eg3, AmpValue egnz)
 {
 	AmpValue sigOut;
 	AmpValue gen1Out;
@@ -840,18 +846,18 @@ void FMSynth::Tick()
 	AmpValue gen3Mod;
 
 	if (lfoGen.On())
-		lfoOut = lfoGen.Gen() * synthParams.frqTI;
+		lfoOut = lfoGen.Gen() * im->GetContext()->frqTI;
 	if (pbOn)
-		lfoOut += pbGen.Gen() * synthParams.frqTI;
+		lfoOut += pbGen.Gen() * im->GetContext()->frqTI;
 	if (pbWT.On())
-		lfoOut += pbWT.Gen() * synthParams.frqTI;
+		lfoOut += pbWT.Gen() * im->GetContext()->frqTI;
 	gen3Mod = lfoOut * gen3Mult;
 	gen2Mod = lfoOut * gen2Mult;
 	gen1Mod = lfoOut * gen1Mult;
 
-	gen1Out = gen1Osc.Gen() * gen1EG.Gen();
-	gen2Out = gen2Osc.Gen() * gen2EG.Gen();
-	gen3Out = gen3Osc.Gen() * gen3EG.Gen();
+	gen1Out = gen1Osc.Gen() * eg1;
+	gen2Out = gen2Osc.Gen() * eg2;
+	gen3Out = gen3Osc.Gen() * eg3;
 	switch (algorithm)
 	{
 	case ALG_STACK2:
@@ -877,7 +883,7 @@ void FMSynth::Tick()
 
 	if (nzOn)
 	{
-		nzOut = nzi.Gen() * nzEG.Gen();
+		nzOut = nzi.Gen() * egnz;
 		if (nzFrqo)
 			nzOut *= nzo.Gen();
 		sigOut += nzOut * nzMix;
@@ -891,18 +897,79 @@ void FMSynth::Tick()
 		sigOut += dlyOut * dlyMix;
 	}
 
-	sigOut *= vol;
+	return sigOut * vol;
+}
+
+void FMSynth::Tick()
+{
+	AmpValue eg1 = gen1EG.Gen();
+	AmpValue eg2 = gen2EG.Gen();
+	AmpValue eg3 = gen3EG.Gen();
+	AmpValue egnz = nzOn ? nzEG.Gen() : 0;
+	AmpValue sigOut = Frame(eg1, eg2, eg3, egnz);
 	if (panOn)
 		im->Output2(chnl, sigOut * panSet.panlft, sigOut * panSet.panrgt);
 	else
 		im->Output(chnl, sigOut);
 }
 
+// The envelopes generate the whole block first, then the
+// oscillators run one frame at a time as in Tick().
+// During the release of a note with delay, the end of the delay
+// is counted by IsFinished(), which must then be called on every
+// frame; Tick() is used instead.
+int FMSynth::TickBlock(int frames)
+{
+	if (dlyOn && relOn)
+		return 0;
+
+	AmpValue eg1[MAX_BLKLEN];
+	AmpValue eg2[MAX_BLKLEN];
+	AmpValue eg3[MAX_BLKLEN];
+	AmpValue egnz[MAX_BLKLEN];
+	AmpValue lft[MAX_BLKLEN];
+	AmpValue rgt[MAX_BLKLEN];
+	int n;
+
+	gen1EG.GenBlock(eg1, frames);
+	gen2EG.GenBlock(eg2, frames);
+	gen3EG.GenBlock(eg3, frames);
+	if (nzOn)
+		nzEG.GenBlock(egnz, frames);
+	else
+		memset(egnz, 0, frames*sizeof(AmpValue));
+
+	for (n = 0; n < frames; n++)
+	{
+		AmpValue sigOut = Frame(eg1[n], eg2[n], eg3[n], egnz[n]);
+		if (panOn)
+		{
+			lft[n] = sigOut * panSet.panlft;
+			rgt[n] = sigOut * panSet.panrgt;
+		}
+		else
+			lft[n] = sigOut;
+	}
+	if (panOn)
+		im->Output2Block(chnl, lft, rgt, frames);
+	else
+		im->OutputBlock(chnl, lft, frames);
+	return 1;
+}
+
 void FMSynth::Destroy()
 {
 	delete this;
 }
 
+int FMSynth::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((FMSynth *)tmplt);
+	return 1;
+}
+
 void FMSynth::LoadEG(XmlSynthElem *elem, EnvDef& eg)
 {
 	float rt = 0;
@@ -977,7 +1044,7 @@ int FMSynth::Load(XmlSynthElem *parent)
 			if (elem->GetAttribute("dly", dval) == 0)
 				nzDly = dval;
 			if (elem->GetAttribute("fr", dval) == 0)
-				nzFrqh = dval / synthParams.sampleRate;
+				nzFrqh = dval / SynthContext::Current()->sampleRate;
 			if (elem->GetAttribute("fh", dval) == 0)
 				nzFrqh = dval;
 			if (elem->GetAttribute("fo", dval) == 0)
@@ -992,7 +1059,7 @@ int FMSynth::Load(XmlSynthElem *parent)
 				dlyTim = dval;
 			if (elem->GetAttribute("dec", dval) == 0)
 				dlyDec = dval;
-			dlySamps = (long) (dlyDec * synthParams.sampleRate);
+			dlySamps = (long) (dlyDec * SynthContext::Current()->sampleRate);
 		}
 		else if (elem->TagMatch("lfo"))
 		{
@@ -80,6 +80,7 @@ private:
 	int nzOn;
 	int dlyOn;
 	int pbOn;
+	int relOn;
 
 	int chnl;
 	FrqValue frq;
@@ -89,6 +90,7 @@ private:
 	InstrManager *im;
 
 	AmpValue CalcPhaseMod(AmpValue amp, FrqValue mult);
+	AmpValue Frame(AmpValue eg1, AmpValue eg2, AmpValue eg3, AmpValue egnz);
 	void LoadEG(XmlSynthElem *elem, EnvDef& eg);
 	XmlSynthElem *SaveEG(XmlSynthElem *parent, const char *tag, EnvDef& eg);
 
@@ -106,8 +108,10 @@ public:
 	void Param(SeqEvent *evt);
 	void Stop();
 	void Tick();
+	int  TickBlock(int frames);
 	int  IsFinished();
 	void Destroy();
+	int  Recycle(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
@@ -87,6 +87,8 @@ int GMPlayer::Load(XmlSynthElem *parent)
 			elem.GetAttribute("prog", progValue);
 			if (elem.GetAttribute("attn", attnScale) == 0)
 				attnScale = 1.0;
+			if (elem.GetAttribute("krate", ctlRate) == 0 || ctlRate < 1)
+				ctlRate = 1;
 			elem.GetContent(&cval);
 			if (cval)
 				sndFile.Attach(cval);
@@ -114,6 +116,7 @@ int GMPlayer::Save(XmlSynthElem *parent)
 	elem.SetAttribute("bank", bankValue);
 	elem.SetAttribute("prog", progValue);
 	elem.SetAttribute("attn", attnScale);
+	elem.SetAttribute("krate", ctlRate);
 	elem.SetContent(sndFile);
 
 	return 0;
@@ -146,6 +149,11 @@ int GMPlayer::SetParam(bsInt16 idval, float val)
 	case GMPLAYER_ATTN:
 		attnScale = val;
 		break;
+	case GMPLAYER_KRATE:
+		ctlRate = (bsInt16) val;
+		if (ctlRate < 1)
+			ctlRate = 1;
+		break;
 	default:
 		return 1;
 	}
@@ -158,6 +166,7 @@ int GMPlayer::GetParams(VarParamEvent *params)
 	params->SetParam(GMPLAYER_BANK, (float) bankValue);
 	params->SetParam(GMPLAYER_PROG, (float) progValue);
 	params->SetParam(GMPLAYER_ATTN, (float) attnScale);
+	params->SetParam(GMPLAYER_KRATE, (float) ctlRate);
 	return 0;
 }
 
@@ -177,6 +186,9 @@ int GMPlayer::GetParam(bsInt16 idval, float *val)
 	case GMPLAYER_ATTN:
 		*val = (float) attnScale;
 		break;
+	case GMPLAYER_KRATE:
+		*val = (float) ctlRate;
+		break;
 	default:
 		return 1;
 	}
@@ -187,6 +199,7 @@ static InstrParamMap gmPlayerParams[] =
 {
 	{"attn",  GMPLAYER_ATTN },
 	{"bank",  GMPLAYER_BANK },
+	{"krate", GMPLAYER_KRATE },
 	{"local", GMPLAYER_FLAGS },
 	{"prog",  GMPLAYER_PROG },
 };
@@ -210,14 +223,17 @@ GMPlayer::GMPlayer()
 	chnl = 0;
 	mkey = 69;
 	novel = 0;
+	exclNote = 0;
 	sostenuto = 0;
 	zoneList = 0;
+	zoneFree = 0;
 	pendingStop = 0;
 	sndbnk = 0;
 	pitchBend = 0;
 	ctrlAtten = 0;
 	rvrbAmnt = 0;
 	attnScale = 1.0;
+	ctlRate = 1;
 	localVals = 0;
 	bankValue = 0;
 	progValue = 0;
@@ -230,12 +246,22 @@ GMPlayer::GMPlayer(GMPlayer *tmplt, InstrManager *m)
 	chnl = 0;
 	mkey = 69;
 	novel = 0;
+	exclNote = 0;
 	sostenuto = 0;
 	zoneList = 0;
+	zoneFree = 0;
 	pendingStop = 0;
 	pitchBend = 0;
 	ctrlAtten = 0;
 	rvrbAmnt = 0;
+	// Zone players are created with the instance so that
+	// Start and Recycle do not allocate for most notes.
+	for (int n = 0; n < GMPLAYER_ZONES; n++)
+	{
+		GMPlayerZone *pz = new GMPlayerZone(0, im, this);
+		pz->next = zoneFree;
+		zoneFree = pz;
+	}
 	if (tmplt)
 	{
 		sndbnk = tmplt->sndbnk;
@@ -245,6 +271,7 @@ GMPlayer::GMPlayer(GMPlayer *tmplt, InstrManager *m)
 		bankValue = tmplt->bankValue;
 		progValue = tmplt->progValue;
 		attnScale = tmplt->attnScale;
+		ctlRate = tmplt->ctlRate;
 	}
 	else
 	{
@@ -253,6 +280,7 @@ GMPlayer::GMPlayer(GMPlayer *tmplt, InstrManager *m)
 		bankValue = 0;
 		progValue = 0;
 		attnScale = 1.0;
+		ctlRate = 1;
 	}
 }
 
@@ -272,6 +300,11 @@ void GMPlayer::ClearZones()
 		delete pz;
 	}
 	zoneList = 0;
+	while ((pz = zoneFree) != 0)
+	{
+		zoneFree = pz->next;
+		delete pz;
+	}
 }
 
 /// Start playing a note.
@@ -281,6 +314,7 @@ void GMPlayer::Start(SeqEvent *se)
 {
 	VarParamEvent *evt = (VarParamEvent *)se;
 	chnl = evt->chnl;
+	pitchBend = im->GetPitchbendC(chnl);
 	mkey = evt->pitch + 12;
 	novel = evt->noteonvel;
 	if (novel == 0)
@@ -318,9 +352,15 @@ void GMPlayer::Start(SeqEvent *se)
 					zone = ref->zone;
 					if (zone->Match(mkey, novel))
 					{
-						GMPlayerZone *pz = new GMPlayerZone(zone, im, this);
-						if (zoneList)
-							pz->next = zoneList;
+						GMPlayerZone *pz = zoneFree;
+						if (pz)
+						{
+							zoneFree = pz->next;
+							pz->zone = zone;
+						}
+						else
+							pz = new GMPlayerZone(zone, im, this);
+						pz->next = zoneList;
 						zoneList = pz;
 						pz->Initialize(chnl, mkey, novel);
 						exclNote |= zone->exclNote;
@@ -463,6 +503,18 @@ void GMPlayer::Tick()
 	} while ((pz = pz->next) != 0);
 }
 
+/// Produce a block of samples.
+int GMPlayer::TickBlock(int frames)
+{
+	GMPlayerZone *pz = zoneList;
+	while (pz)
+	{
+		pz->GenBlock(frames);
+		pz = pz->next;
+	}
+	return 1;
+}
+
 void GMPlayer::Destroy()
 {
 	if (exclNote)
@@ -470,6 +522,43 @@ void GMPlayer::Destroy()
 	delete this;
 }
 
+/// Prepare a finished player for another note.
+/// Zone players move to the free list so that the next
+/// Start does not allocate; settings return to the template.
+int GMPlayer::Recycle(Opaque tmplt)
+{
+	if (exclNote)
+		im->ExclNoteOff((chnl << 4) | (exclNote & 0xf), this);
+	exclNote = 0;
+	GMPlayerZone *pz;
+	while ((pz = zoneList) != 0)
+	{
+		zoneList = pz->next;
+		pz->next = zoneFree;
+		zoneFree = pz;
+	}
+	pendingStop = 0;
+	instr = 0;
+	GMPlayer *tp = (GMPlayer *) tmplt;
+	if (tp)
+	{
+		if (sndbnk != tp->sndbnk)
+		{
+			if (sndbnk)
+				sndbnk->Unlock();
+			sndbnk = tp->sndbnk;
+			if (sndbnk)
+				sndbnk->Lock();
+		}
+		localVals = tp->localVals;
+		bankValue = tp->bankValue;
+		progValue = tp->progValue;
+		attnScale = tp->attnScale;
+		ctlRate = tp->ctlRate;
+	}
+	return 1;
+}
+
 void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 {
 	chnl = ch;
@@ -492,6 +581,14 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 
 	genFlags = zone->genFlags;
 
+	// At control rate, modulators advance once per update,
+	// so LFO frequency is scaled up and times are scaled down.
+	kRate = player->ctlRate;
+	kCount = 0;
+	kFirst = 1;
+	kFiltRamp = 0;
+	FrqValue krate = (FrqValue) kRate;
+
 	// Initialize parameter values
 	float veln = SoundBank::posLinear[noVel];
 	float keyn = SoundBank::posLinear[noKey];
@@ -501,10 +598,10 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 	// Initialize oscillator.
 	// Calculate cents ratio for phase increment updates.
 	FrqValue smpl;
-	if (zone->rate != synthParams.isampleRate)
+	if (zone->rate != osc.GetContext()->isampleRate)
 	{
 		double wsrCents = 1200.0 * SoundBank::log2((double)zone->rate/440.0);
-		double srCents = 1200.0 * SoundBank::log2((double)synthParams.sampleRate/440.0);
+		double srCents = 1200.0 * SoundBank::log2((double)osc.GetContext()->sampleRate/440.0);
 		smpl = FrqValue(wsrCents - srCents);
 	}
 	else
@@ -515,11 +612,11 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 	osc.InitSB(zone, SoundBank::GetPow2n1200(initPitch));
 
 	// Initialize LFO
-	vibLfo.InitWT(SoundBank::Frequency(zone->vibLfo.rate), WT_SIN);
-	vibDelay = (bsInt32) (SoundBank::EnvRate(zone->vibLfo.delay) * synthParams.sampleRate);
+	vibLfo.InitWT(SoundBank::Frequency(zone->vibLfo.rate) * krate, WT_SIN);
+	vibDelay = (bsInt32) (SoundBank::EnvRate(zone->vibLfo.delay) * osc.GetContext()->sampleRate / krate);
 
-	modLfo.InitWT(SoundBank::Frequency(zone->modLfo.rate), WT_SIN);
-	modDelay = (bsInt32) (SoundBank::EnvRate(zone->modLfo.delay) * synthParams.sampleRate);
+	modLfo.InitWT(SoundBank::Frequency(zone->modLfo.rate) * krate, WT_SIN);
+	modDelay = (bsInt32) (SoundBank::EnvRate(zone->modLfo.delay) * osc.GetContext()->sampleRate / krate);
 
 	// Initialize volume envelope
 	FrqValue km;
@@ -551,10 +648,10 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 	// Initialize modulation envelope
 	if (genFlags & SBGEN_EG2X)
 	{
-		modEnv.SetDelay(SoundBank::EnvRate(zone->modEg.delay));
-		modEnv.SetAttack(SoundBank::EnvRate(zone->modEg.attack + (veln * zone->modEg.velAttack)));
-		modEnv.SetHold(SoundBank::EnvRate(zone->modEg.hold + (km * zone->modEg.keyHold)));
-		modEnv.SetDecay(SoundBank::EnvRate(zone->modEg.decay + (km * zone->modEg.keyDecay)));
+		modEnv.SetDelay(SoundBank::EnvRate(zone->modEg.delay) / krate);
+		modEnv.SetAttack(SoundBank::EnvRate(zone->modEg.attack + (veln * zone->modEg.velAttack)) / krate);
+		modEnv.SetHold(SoundBank::EnvRate(zone->modEg.hold + (km * zone->modEg.keyHold)) / krate);
+		modEnv.SetDecay(SoundBank::EnvRate(zone->modEg.decay + (km * zone->modEg.keyDecay)) / krate);
 		if (genFlags & SBGEN_SF2)
 		{
 			if (zone->modEg.sustain <= 0)
@@ -566,7 +663,7 @@ void GMPlayer::GMPlayerZone::Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel)
 		}
 		else
 			modEnv.SetSustain(zone->modEg.sustain * 0.001);
-		modEnv.SetRelease(SoundBank::EnvRate(zone->modEg.release));
+		modEnv.SetRelease(SoundBank::EnvRate(zone->modEg.release) / krate);
 		modEnv.Reset(0);
 	}
 
@@ -616,8 +713,8 @@ void GMPlayer::GMPlayerZone::SetPanning()
 		pan = -0.5;
 	else if (pan > 0.5)
 		pan = 0.5;
-	panLft = synthParams.sinquad[(int)((0.5 - pan) * synthParams.sqNdx)];
-	panRgt = synthParams.sinquad[(int)((0.5 + pan) * synthParams.sqNdx)];
+	panLft = osc.GetContext()->sinquad[(int)((0.5 - pan) * osc.GetContext()->sqNdx)];
+	panRgt = osc.GetContext()->sinquad[(int)((0.5 + pan) * osc.GetContext()->sqNdx)];
 }
 
 void GMPlayer::GMPlayerZone::SetLFO()
@@ -629,7 +726,7 @@ void GMPlayer::GMPlayerZone::SetLFO()
 	modLfoVol = zone->modLfoVol + (zone->modLfoMwVol * mwval);
 }
 
-void GMPlayer::GMPlayerZone::Gen()
+AmpValue GMPlayer::GMPlayerZone::Calc()
 {
 	FrqValue pitchVal = initPitch + player->pitchBend;
 	AmpValue attenVal = initAtten + player->ctrlAtten;
@@ -690,6 +787,178 @@ void GMPlayer::GMPlayerZone::Gen()
 		eg = SoundBank::Attenuation((1.0 - eg) * 960);
 
 	out *= SoundBank::Attenuation(attenVal) * eg;
+	return out;
+}
+
+// Update modulation at control rate. This is the same
+// calculation as Calc(), but sets the values the
+// phase increment, gain and filter move to over
+// the next kRate samples.
+void GMPlayer::GMPlayerZone::Control()
+{
+	kCount = kRate - 1;
+
+	FrqValue pitchVal = initPitch + player->pitchBend;
+	AmpValue attenVal = initAtten + player->ctrlAtten;
+	FrqValue filtVal = zone->filtFreq;
+
+	if (genFlags & SBGEN_EG2X)
+	{
+		float eg2 = modEnv.Gen();
+		pitchVal += eg2 * zone->modEnvFrq;
+		filtVal += eg2 * zone->modEnvFlt;
+	}
+
+	if (vibDelay == 0 || --vibDelay == 0)
+	{
+		pitchVal += vibLfo.Gen() * vibLfoFrq;
+	}
+
+	if (genFlags & SBGEN_LFO2X && (modDelay == 0 || --modDelay == 0))
+	{
+		float lfo = modLfo.Gen();
+		pitchVal += lfo * modLfoFrq;
+		filtVal += lfo * modLfoFlt;
+		attenVal += (1.0 + lfo) * 0.5 * modLfoVol;
+	}
+
+	PhsAccum incr = SoundBank::GetPow2n1200(pitchVal);
+	AmpValue gain = SoundBank::Attenuation(attenVal);
+	AmpValue step = 1.0 / (AmpValue) kRate;
+	if (kFirst)
+	{
+		kIncr = incr;
+		kGain = gain;
+		kIncrStep = 0;
+		kGainStep = 0;
+	}
+	else
+	{
+		kIncrStep = (incr - kIncr) * step;
+		kGainStep = (gain - kGain) * step;
+	}
+
+	if ((genFlags & (SBGEN_FILTERX|SBGEN_FILTERD)) == (SBGEN_FILTERX|SBGEN_FILTERD))
+	{
+		int n;
+		if (kFiltRamp)
+		{
+			// finish the last ramp exactly
+			filt.InitFilter(kCoefEnd[0], kCoefEnd[1], kCoefEnd[2]);
+			kFiltRamp = 0;
+		}
+		if (filtVal > SoundBank::maxFilter)
+			filtVal = SoundBank::maxFilter;
+		bsInt32 fcCents = (bsInt32)filtVal;
+		if (fcCents != fcFlt)
+		{
+			fcFlt = fcCents;
+			filt.GetCoef(kCoef[0], kCoef[1], kCoef[2]);
+			filt.CalcCoef(SoundBank::Frequency(filtVal), gainQ);
+			if (!kFirst)
+			{
+				filt.GetCoef(kCoefEnd[0], kCoefEnd[1], kCoefEnd[2]);
+				for (n = 0; n < 3; n++)
+					kCoefStep[n] = (kCoefEnd[n] - kCoef[n]) * step;
+				kFiltRamp = 1;
+			}
+		}
+	}
+	kFirst = 0;
+}
+
+// Produce one sample at control rate.
+AmpValue GMPlayer::GMPlayerZone::CalcK()
+{
+	if (--kCount < 0)
+		Control();
+
+	// run the oscillator
+	osc.UpdatePhaseIncr(kIncr);
+	kIncr += kIncrStep;
+	AmpValue out = osc.Gen();
+
+	// filter
+	if (genFlags & SBGEN_FILTERX)
+	{
+		if (kFiltRamp)
+		{
+			filt.InitFilter(kCoef[0], kCoef[1], kCoef[2]);
+			kCoef[0] += kCoefStep[0];
+			kCoef[1] += kCoefStep[1];
+			kCoef[2] += kCoefStep[2];
+		}
+		out = filt.Sample(out);
+	}
+
+	// apply envelope and attenuation
+	AmpValue eg = volEnv.Gen();
+	if (volEnv.GetSegment() > 2)
+		eg = SoundBank::Attenuation((1.0 - eg) * 960);
+
+	out *= kGain * eg;
+	kGain += kGainStep;
+	return out;
+}
+
+// Produce a block of samples at control rate.
+// Each span between control updates runs the oscillator
+// as a block, then applies filter and amplitude.
+void GMPlayer::GMPlayerZone::CalcKBlock(AmpValue *out, int frames)
+{
+	int n;
+	while (frames > 0)
+	{
+		if (--kCount < 0)
+			Control();
+		int span = kCount + 1;
+		if (span > frames)
+			span = frames;
+		kCount -= span - 1;
+
+		// run the oscillator
+		osc.UpdatePhaseIncr(kIncr);
+		osc.GenBlock(out, span, kIncrStep);
+		kIncr = osc.GetPhaseIncr();
+
+		// filter
+		if (genFlags & SBGEN_FILTERX)
+		{
+			if (kFiltRamp)
+			{
+				for (n = 0; n < span; n++)
+				{
+					filt.InitFilter(kCoef[0], kCoef[1], kCoef[2]);
+					kCoef[0] += kCoefStep[0];
+					kCoef[1] += kCoefStep[1];
+					kCoef[2] += kCoefStep[2];
+					out[n] = filt.Sample(out[n]);
+				}
+			}
+			else
+			{
+				for (n = 0; n < span; n++)
+					out[n] = filt.Sample(out[n]);
+			}
+		}
+
+		// apply envelope and attenuation
+		for (n = 0; n < span; n++)
+		{
+			AmpValue eg = volEnv.Gen();
+			if (volEnv.GetSegment() > 2)
+				eg = SoundBank::Attenuation((1.0 - eg) * 960);
+			out[n] *= kGain * eg;
+			kGain += kGainStep;
+		}
+		out += span;
+		frames -= span;
+	}
+}
+
+void GMPlayer::GMPlayerZone::Gen()
+{
+	AmpValue out = kRate > 1 ? CalcK() : Calc();
 
 	// output
 	if (localPan)
@@ -701,3 +970,36 @@ void GMPlayer::GMPlayerZone::Gen()
 	else
 		im->Output(chnl, out);
 }
+
+void GMPlayer::GMPlayerZone::GenBlock(int frames)
+{
+	AmpValue out[MAX_BLKLEN];
+	int n;
+	if (kRate > 1)
+		CalcKBlock(out, frames);
+	else
+	{
+		for (n = 0; n < frames; n++)
+			out[n] = Calc();
+	}
+
+	// output
+	if (localPan)
+	{
+		// bypass mixer panning and effects
+		AmpValue lft[MAX_BLKLEN];
+		AmpValue rgt[MAX_BLKLEN];
+		AmpValue rvrb = player->rvrbAmnt;
+		for (n = 0; n < frames; n++)
+		{
+			lft[n] = out[n] * panLft;
+			rgt[n] = out[n] * panRgt;
+		}
+		im->Output2Block(chnl, lft, rgt, frames);
+		for (n = 0; n < frames; n++)
+			out[n] *= rvrb;
+		im->FxSendBlock(0, out, frames);
+	}
+	else
+		im->OutputBlock(chnl, out, frames);
+}
@@ -27,6 +27,10 @@
 #define GMPLAYER_BANK 17
 #define GMPLAYER_PROG 18
 #define GMPLAYER_ATTN 19
+#define GMPLAYER_KRATE 20
+
+/// Zone players created up front for each instance
+#define GMPLAYER_ZONES 2
 
 /// @brief GM sound player
 /// @details The GM player implements playback of a SoundBank sample.
@@ -48,6 +52,13 @@
 /// SoundFont (SF2) files will sometimes have multiple zones per note.
 /// This is typically done to implement a stereo sample. GMPlayer uses
 /// a list of zones to handle this situation.
+///
+/// Modulation (LFOs, modulation envelope, pitch bend, volume and
+/// filter cutoff) is normally recalculated on every sample.
+/// Setting a control rate (krate) greater than 1 recalculates
+/// modulation once every krate samples. Between updates the phase
+/// increment, gain and filter coefficients move linearly to the
+/// new values. The volume envelope still runs on every sample.
 class GMPlayer : public InstrumentVP
 {
 private:
@@ -68,6 +79,17 @@ private:
 		bsInt32 vibDelay;   ///< delay before vibrato begins to affect output
 		bsInt32 modDelay;   ///< delay before modulator begins to affect output
 		bsInt32 fcFlt;     ///< Last filter fc in cents
+		bsInt32 kRate;      ///< samples per modulation update
+		bsInt32 kCount;     ///< samples until the next update
+		bsInt32 kFirst;     ///< no update yet, start without ramps
+		bsInt32 kFiltRamp;  ///< filter coefficients are moving
+		PhsAccum kIncr;     ///< phase increment and step per sample
+		PhsAccum kIncrStep;
+		AmpValue kGain;     ///< attenuation gain and step per sample
+		AmpValue kGainStep;
+		AmpValue kCoef[3];  ///< filter coefficients, step and target
+		AmpValue kCoefStep[3];
+		AmpValue kCoefEnd[3];
 
 		bsInt16 chnl;       ///< Playback channel
 		bsInt16 noKey;      ///< Note-on key number
@@ -93,12 +115,18 @@ private:
 		}
 
 		void Initialize(bsInt16 ch, bsInt16 key, bsInt16 vel);
+		AmpValue Calc();
+		AmpValue CalcK();
+		void CalcKBlock(AmpValue *out, int frames);
+		void Control();
 		void Gen();
+		void GenBlock(int frames);
 		void SetPanning();
 		void SetLFO();
 	};
 
 	GMPlayerZone *zoneList;
+	GMPlayerZone *zoneFree; ///< zone players kept for reuse
 
 	bsInt16 chnl;       ///< MIDI channel
 	bsInt16 mkey;       ///< MIDI key number
@@ -110,6 +138,7 @@ private:
 	AmpValue ctrlAtten;
 	AmpValue attnScale;
 	FrqValue rvrbAmnt;
+	bsInt16 ctlRate;    ///< samples per modulation update (krate)
 	SBInstr *instr;     ///< instrument patch
 	InstrManager *im;
 	SoundBank *sndbnk;
@@ -143,8 +172,10 @@ public:
 	virtual void Stop();
 	virtual void Cancel();
 	virtual void Tick();
+	virtual int  TickBlock(int frames);
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle(Opaque tmplt);
 
 	virtual VarParamEvent *AllocParams();
 	virtual int GetParams(VarParamEvent *params);
@@ -78,7 +78,7 @@ void LFO::Reset(float initPhs)
 	if (sigFrq != 0)
 	{
 		//FrqValue f1 = sigFrq * FrqValue(pow(2.0, depth / 12.0));
-		FrqValue f1 = sigFrq * synthParams.GetCentsMult((int)(depth * 100.0));
+		FrqValue f1 = sigFrq * ctx->GetCentsMult((int)(depth * 100.0));
 		ampLvl = AmpValue(fabs(f1 - sigFrq));
 	}
 	else
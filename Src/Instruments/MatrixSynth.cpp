@@ -152,7 +152,7 @@ MatrixSynth::MatrixSynth()
 	frq = 440.0;
 	vol = 1.0;
 	chnl = 0;
-	maxPhs = synthParams.ftableLength/2;
+	maxPhs = SynthContext::Current()->ftableLength/2;
 	lfoOn = 0;
 	panOn = 0;
 	pbOn = 0;
@@ -171,7 +171,7 @@ MatrixSynth::MatrixSynth()
 MatrixSynth::MatrixSynth(MatrixSynth *tp)
 {
 	im = NULL;
-	maxPhs = synthParams.ftableLength/2;
+	maxPhs = SynthContext::Current()->ftableLength/2;
 	Copy(tp);
 }
 
@@ -233,7 +233,7 @@ void MatrixSynth::Start(SeqEvent *evt)
 	{
 		if (flgs & 1)
 		{
-			envPtr->SetDuration(evt->duration / synthParams.sampleRate);
+			envPtr->SetDuration(evt->duration / im->GetContext()->sampleRate);
 			envPtr->Reset(0);
 		}
 		envPtr++;
@@ -763,7 +763,9 @@ void MatrixSynth::Stop()
 	}
 }
 
-void MatrixSynth::Tick()
+// Generate one frame from the envelope values.
+// The sums are returned in res: mono, left, right, fx1-fx4.
+inline void MatrixSynth::Frame(const AmpValue *egVal, AmpValue *res)
 {
 	bsUint32 flgs;
 	AmpValue sigOut = 0;
@@ -781,36 +783,16 @@ void MatrixSynth::Tick()
 	MatrixTone *tMod;
 	MatrixTone *tSig;
 	MatrixTone *tEnd;
-	EnvGenSegSus *envPtr;
-	EnvGenSegSus *envEnd;
-	AmpValue egVal[MATGEN];
-	AmpValue *eg = egVal;
-	bsUint16 envFlgs;
 
 	if (lfoOn)
 	{
 		lfoAmp = lfoGen.Gen();
-		lfoRad = lfoAmp * synthParams.frqTI;
+		lfoRad = lfoAmp * im->GetContext()->frqTI;
 	}
 	if (pbOn)
-		pbRad = pbGen.Gen() * synthParams.frqTI;
+		pbRad = pbGen.Gen() * im->GetContext()->frqTI;
 	if (pbWTOn)
-		pbRad = pbWT.Gen() * synthParams.frqTI;
-
-	// Run the envelope generators
-	envFlgs = envUsed;
-	envEnd = &envs[MATGEN];
-	envPtr = envs; 
-	while (envPtr < envEnd)
-	{
-		if (envFlgs & 1)
-			*eg = envPtr->Gen();
-		else
-			*eg = 0;
-		eg++;
-		envFlgs >>= 1;
-		envPtr++;
-	}
+		pbRad = pbWT.Gen() * im->GetContext()->frqTI;
 
 	// Collect samples from all active generators,
 	// and sum the output signals.
@@ -878,18 +860,115 @@ void MatrixSynth::Tick()
 			}
 		}
 	}
+	res[0] = sigOut;
+	res[1] = sigLft;
+	res[2] = sigRgt;
+	res[3] = fx1Out;
+	res[4] = fx2Out;
+	res[5] = fx3Out;
+	res[6] = fx4Out;
+}
+
+void MatrixSynth::Tick()
+{
+	AmpValue egVal[MATGEN];
+	AmpValue *eg = egVal;
+	AmpValue res[7];
+	EnvGenSegSus *envPtr;
+	EnvGenSegSus *envEnd;
+	bsUint16 envFlgs;
+
+	// Run the envelope generators
+	envFlgs = envUsed;
+	envEnd = &envs[MATGEN];
+	envPtr = envs; 
+	while (envPtr < envEnd)
+	{
+		if (envFlgs & 1)
+			*eg = envPtr->Gen();
+		else
+			*eg = 0;
+		eg++;
+		envFlgs >>= 1;
+		envPtr++;
+	}
+
+	Frame(egVal, res);
+
+	if (fx1On)
+		im->FxSend(0, res[3]);
+	if (fx2On)
+		im->FxSend(1, res[4]);
+	if (fx3On)
+		im->FxSend(2, res[5]);
+	if (fx4On)
+		im->FxSend(3, res[6]);
+
+	if (panOn)
+		im->Output2(chnl, res[1] * vol, res[2] * vol);
+	im->Output(chnl, res[0] * vol);
+}
+
+// Envelopes that hold a constant value for the whole block
+// are set once, the others generate the block in one call.
+// The oscillators and modulation are then run one frame
+// at a time as in Tick().
+int MatrixSynth::TickBlock(int frames)
+{
+	AmpValue egBlk[MATGEN][MAX_BLKLEN];
+	AmpValue outBlk[7][MAX_BLKLEN];
+	AmpValue egVal[MATGEN];
+	AmpValue res[7];
+	bsUint16 envBlk = 0;
+	int en;
+	int n;
+
+	for (en = 0; en < MATGEN; en++)
+	{
+		egVal[en] = 0;
+		if (envUsed & (1 << en))
+		{
+			if (envs[en].ConstantFor(egVal[en]) != EGSEG_CONSTANT)
+			{
+				envs[en].GenBlock(egBlk[en], frames);
+				envBlk |= 1 << en;
+			}
+		}
+	}
+
+	for (n = 0; n < frames; n++)
+	{
+		if (envBlk)
+		{
+			for (en = 0; en < MATGEN; en++)
+			{
+				if (envBlk & (1 << en))
+					egVal[en] = egBlk[en][n];
+			}
+		}
+		Frame(egVal, res);
+		outBlk[0][n] = res[0] * vol;
+		outBlk[1][n] = res[1] * vol;
+		outBlk[2][n] = res[2] * vol;
+		outBlk[3][n] = res[3];
+		outBlk[4][n] = res[4];
+		outBlk[5][n] = res[5];
+		outBlk[6][n] = res[6];
+	}
+
 	if (fx1On)
-		im->FxSend(0, fx1Out);
+		im->FxSendBlock(0, outBlk[3], frames);
 	if (fx2On)
-		im->FxSend(1, fx2Out);
+		im->FxSendBlock(1, outBlk[4], frames);
 	if (fx3On)
-		im->FxSend(2, fx3Out);
+		im->FxSendBlock(2, outBlk[5], frames);
 	if (fx4On)
-		im->FxSend(3, fx4Out);
+		im->FxSendBlock(3, outBlk[6], frames);
 
 	if (panOn)
-		im->Output2(chnl, sigLft * vol, sigRgt * vol);
-	im->Output(chnl, sigOut * vol);
+		im->Output2Block(chnl, outBlk[1], outBlk[2], frames);
+	im->OutputBlock(chnl, outBlk[0], frames);
+	return 1;
 }
 
 int  MatrixSynth::IsFinished()
@@ -912,6 +991,14 @@ void MatrixSynth::Destroy()
 	delete this;
 }
 
+int MatrixSynth::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((MatrixSynth *)tmplt);
+	return 1;
+}
+
 int MatrixSynth::LoadEnv(XmlSynthElem *elem)
 {
 	short en = -1;
@@ -1124,7 +1211,7 @@ void MatrixTone::Copy(MatrixTone *tp)
 inline void MatrixTone::Start(FrqValue frqBase)
 {
 	FrqValue f = frqBase * frqMult;
-	modRad = f * modLvl * synthParams.frqTI;
+	modRad = f * modLvl * osc.GetContext()->frqTI;
 	//if (modRad > maxPhs)
 	//	modRad = maxPhs;
 	osc.SetFrequency(f);
@@ -1134,7 +1221,7 @@ inline void MatrixTone::Start(FrqValue frqBase)
 inline void MatrixTone::AlterFreq(FrqValue frqBase)
 {
 	FrqValue f = frqBase * frqMult;
-	modRad = f * modLvl * synthParams.frqTI;
+	modRad = f * modLvl * osc.GetContext()->frqTI;
 	osc.SetFrequency(f);
 	osc.Reset(-1);
 }
@@ -119,6 +119,7 @@ private:
 	InstrManager *im;
 
 	int LoadEnv(XmlSynthElem *elem);
+	void Frame(const AmpValue *egVal, AmpValue *res);
 	int SaveEnv(XmlSynthElem *elem, int en);
 
 public:
@@ -144,10 +145,14 @@ public:
 	void Stop();
 	/// Generate the next sample sending output to the instrument manager
 	void Tick();
+	/// Generate a block of samples
+	int  TickBlock(int frames);
 	/// Return true if all envelopes are complete
 	int  IsFinished();
 	/// Destroy this instance
 	void Destroy();
+	/// Restore template settings for reuse
+	int  Recycle(Opaque tmplt);
 
 	/// Load parameters from the project file
 	int Load(XmlSynthElem *parent);
@@ -163,6 +163,40 @@ void MixerControl::Start(SeqEvent *evt)
 	}
 }
 
+// Catch up with a mixer change that started before playback.
+// Settings are applied by Start. A ramp is moved to the level it
+// would have reached, or finished if the ramp time has passed.
+// The oscillator is run for the elapsed time to get the phase.
+int MixerControl::Chase(SeqEvent *evt, bsInt32 elapsed)
+{
+	Start(evt);
+	if (mix == 0)
+		return 0;
+
+	if (oscOn)
+	{
+		while (elapsed-- > 0 && tickCount > 0)
+			Tick();
+	}
+	else if (func & mixRamp)
+	{
+		if (elapsed < tickCount)
+		{
+			AmpValue lvl = frLvl + (((toLvl - frLvl) * (AmpValue) elapsed) / (AmpValue) tickCount);
+			tickCount -= elapsed;
+			rmp.InitSegTick(tickCount, lvl, toLvl);
+		}
+		else
+		{
+			// one tick sets the final level
+			tickCount = 1;
+			rmp.InitSegTick(1, toLvl, toLvl);
+			Tick();
+		}
+	}
+	return !IsFinished();
+}
+
 void MixerControl::Param(SeqEvent *evt)
 {
 }
@@ -268,7 +302,7 @@ int MixerControl::Save(XmlSynthElem *node)
 
 int MixerControl::GetParams(VarParamEvent *params)
 {
-	params->SetParam(P_DUR,      (float) synthParams.sampleRate * tmSec);
+	params->SetParam(P_DUR,      (float) SynthContext::Current()->sampleRate * tmSec);
 	params->SetParam(P_CHNL,     (float) inChnl);
 	params->SetParam(P_MIX_FUNC, (float) func);
 	params->SetParam(P_MIX_FRQ,  (float) osc.GetFrequency());
@@ -304,7 +338,7 @@ int MixerControl::SetParam(bsInt16 idval, float val)
 		break;
 	case P_MIX_TIME:
 		tmSec = FrqValue(val);
-		tickCount = (bsInt32) (synthParams.sampleRate * val);
+		tickCount = (bsInt32) (SynthContext::Current()->sampleRate * val);
 		break;
 	case P_MIX_FROM:
 		frLvl = AmpValue(val);
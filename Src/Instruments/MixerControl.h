@@ -42,6 +42,7 @@ public:
 
 	void Copy(MixerControl *tp);
 	virtual void Start(SeqEvent *evt);
+	virtual int  Chase(SeqEvent *evt, bsInt32 elapsed);
 	virtual void Param(SeqEvent *evt);
 	virtual void Stop();
 	virtual void Tick();
@@ -414,9 +414,16 @@ ModSynth::ModSynth()
 	chnl = 0;
 	frq = 0;
 	im = 0;
+	plan = 0;
+	planIn = 0;
+	planInCount = 0;
+	planVal = 0;
+	planSet = 0;
+	numPlan = 0;
+	planState = 0;
 	head.Insert(&tail);
 	head.SetName("@sr");
-	head.SetInput(0, synthParams.sampleRate);
+	head.SetInput(0, SynthContext::Current()->sampleRate);
 	tail.SetName("out");
 	tail.SetID(1);
 	tail.InitDefault();
@@ -431,6 +438,7 @@ ModSynth::ModSynth()
 
 ModSynth::~ModSynth()
 {
+	ClearPlan();
 	ModSynthUG *ug;
 	while ((ug = head.next) != &tail)
 	{
@@ -443,9 +451,15 @@ void ModSynth::Start(SeqEvent *evt)
 {
 	SetParams((VarParamEvent *)evt);
 
+	// Seed each unit from the event ID, spaced so that two
+	// noise units in one note get different signals.
+	bsUint32 seed = (bsUint32) evt->evid << 4;
 	ModSynthUG *ug;
 	for (ug = head.next; ug; ug = ug->next)
+	{
+		ug->Seed(seed++);
 		ug->Start();
+	}
 }
 
 void ModSynth::Param(SeqEvent *evt)
@@ -483,10 +497,158 @@ void ModSynth::Tick()
 	tail.Output(im, chnl);
 }
 
+// Produce a block by running each unit over the block in turn.
+// The plan is compiled when the instance is copied from the
+// template so that nothing is allocated here. Returns 0 when
+// the patch must be ticked one sample at a time, including
+// an instance that was never compiled.
+int ModSynth::TickBlock(int frames)
+{
+	if (frames > MAX_BLKLEN || planState <= 0)
+		return 0;
+
+	ModSynthPlanIn *in = planIn;
+	int index;
+	int nin;
+	for (index = 0; index < numPlan; index++)
+	{
+		nin = planInCount[index];
+		plan[index]->TickBlock(in, nin, &planVal[index*MAX_BLKLEN], &planSet[index*MAX_BLKLEN], frames);
+		in += nin;
+	}
+
+	AmpValue lft[MAX_BLKLEN];
+	AmpValue rgt[MAX_BLKLEN];
+	nin = planInCount[numPlan];
+	for (int n = 0; n < frames; n++)
+	{
+		for (index = 0; index < nin; index++)
+		{
+			if (in[index].set[n])
+				tail.SetInput(in[index].index, in[index].val[n]);
+		}
+		tail.Tick();
+		if (tail.panOn)
+		{
+			lft[n] = tail.lftOut;
+			rgt[n] = tail.rgtOut;
+		}
+		else
+			lft[n] = tail.out;
+	}
+	if (tail.panOn)
+		im->Output2Block(chnl, lft, rgt, frames);
+	else
+		im->OutputBlock(chnl, lft, frames);
+	return 1;
+}
+
+// Locate a unit in the plan, searching forward from index 'from'.
+// The out unit is at index numPlan.
+int ModSynth::PlanIndex(ModSynthUG *ug, int from)
+{
+	if (ug == &tail)
+		return numPlan;
+	for (int index = from; index < numPlan; index++)
+	{
+		if (plan[index] == ug)
+			return index;
+	}
+	return -1;
+}
+
+// Compile the unit list for block rendering.
+// Connections that run at sample rate (UGP_GEN) are collected
+// for each destination in the order the sources are ticked.
+// Connections to an earlier unit, or to the out unit's pan
+// switch, prevent block rendering.
+// Returns non-zero if block rendering is possible.
+int ModSynth::Compile()
+{
+	ClearPlan();
+
+	ModSynthUG *ug;
+	ModSynthConn *conn;
+	int count = 0;
+	for (ug = head.next; ug != &tail; ug = ug->next)
+		count++;
+	plan = new ModSynthUG*[count+1];
+	count = 0;
+	for (ug = head.next; ug != &tail; ug = ug->next)
+		plan[count++] = ug;
+	plan[count] = &tail;
+	numPlan = count;
+
+	int src;
+	int dst;
+	int edges = 0;
+	for (src = 0; src < numPlan; src++)
+	{
+		conn = 0;
+		while ((conn = plan[src]->ConnectList(conn)) != 0)
+		{
+			if (!(conn->when & UGP_GEN))
+				continue;
+			if (PlanIndex(conn->ug, src+1) < 0
+			 || (conn->ug == &tail && conn->index == UGOUT_PON))
+			{
+				planState = -1;
+				return 0;
+			}
+			edges++;
+		}
+	}
+
+	planIn = new ModSynthPlanIn[edges+1];
+	planInCount = new int[numPlan+1];
+	planVal = new AmpValue[(numPlan+1)*MAX_BLKLEN];
+	planSet = new bsUint8[(numPlan+1)*MAX_BLKLEN];
+	ModSynthPlanIn *in = planIn;
+	for (dst = 0; dst <= numPlan; dst++)
+	{
+		planInCount[dst] = 0;
+		for (src = 0; src < dst; src++)
+		{
+			conn = 0;
+			while ((conn = plan[src]->ConnectList(conn)) != 0)
+			{
+				if ((conn->when & UGP_GEN) && conn->ug == plan[dst])
+				{
+					in->val = &planVal[src*MAX_BLKLEN];
+					in->set = &planSet[src*MAX_BLKLEN];
+					in->index = conn->index;
+					in++;
+					planInCount[dst]++;
+				}
+			}
+		}
+	}
+	planState = 1;
+	return 1;
+}
+
+// Discard the compiled plan.
+// This is called whenever units or connections change.
+void ModSynth::ClearPlan()
+{
+	delete[] plan;
+	delete[] planIn;
+	delete[] planInCount;
+	delete[] planVal;
+	delete[] planSet;
+	plan = 0;
+	planIn = 0;
+	planInCount = 0;
+	planVal = 0;
+	planSet = 0;
+	numPlan = 0;
+	planState = 0;
+}
+
 int ModSynth::SetParams(VarParamEvent *vp)
 {
 	chnl = vp->chnl;
-	durParam->SetInput(0, (float)vp->duration / synthParams.sampleRate);
+	durParam->SetInput(0, (float)vp->duration / SynthContext::Current()->sampleRate);
 	volParam->SetInput(0, (float)vp->vol);
 	pitParam->SetInput(0, (float)vp->pitch);
 	frqParam->SetInput(0, (float)vp->frq);
@@ -505,7 +667,7 @@ int ModSynth::GetParams(VarParamEvent *vp)
 	vp->chnl = chnl;
 	vp->frq = frqParam->GetInput(0);
 	vp->vol = volParam->GetInput(0);
-	vp->duration = (bsInt32) (durParam->GetInput(0) * synthParams.sampleRate);
+	vp->duration = (bsInt32) (durParam->GetInput(0) * SynthContext::Current()->sampleRate);
 	ModSynthUG *ug;
 	for (ug = head.next; ug; ug = ug->next)
 	{
@@ -568,6 +730,7 @@ void ModSynth::Copy(ModSynth *tp)
 {
 	// First copy all unit generators
 	ModSynthUG *ugOld;
+	ClearPlan();
 	numUnits = tp->numUnits;
 	maxID = tp->maxID;
 
@@ -584,6 +747,9 @@ void ModSynth::Copy(ModSynth *tp)
 	// Now copy all connections
 	for (ugOld = &tp->head; ugOld; ugOld = ugOld->next)
 		CopyConn(ugOld);
+
+	// Build the block plan now rather than on the audio thread.
+	Compile();
 }
 
 void ModSynth::CopyConn(ModSynthUG *ugOld)
@@ -640,6 +806,7 @@ ModSynthUG *ModSynth::AddUnit(const char *type, const char *name, ModSynthUG *be
 		ug->SetID(++maxID);
 		ug->SetName(name);
 		numUnits++;
+		ClearPlan();
 		ug->GetNumInputs();
 	}
 	return ug;
@@ -687,12 +854,14 @@ void ModSynth::MoveUnit(ModSynthUG *ug, ModSynthUG *before)
 	{
 		ug->Remove();
 		before->InsertBefore(ug);
+		ClearPlan();
 	}
 }
 
 void ModSynth::RemoveUnit(ModSynthUG *ug, int dodel)
 {
 	maxID = 0;
+	ClearPlan();
 	ModSynthUG *ug2;
 	for (ug2 = &head; ug2; ug2 = ug2->next)
 	{
@@ -738,6 +907,7 @@ UGValue *ModSynth::AddParam(const char *name, bsInt16 id)
 void ModSynth::Connect(ModSynthUG *src, ModSynthUG *dst, int input, int when)
 {
 	src->AddConnect(dst, input, when);
+	ClearPlan();
 }
 
 void ModSynth::Connect(ModSynthUG *ug, const char *dst)
@@ -759,7 +929,10 @@ void ModSynth::Connect(ModSynthUG *ug, const char *dst)
 	{
 		const UGParam *p = dstug->FindParam(inp);
 		if (p)
+		{
 			ug->AddConnect(dstug, p->index, p->when);
+			ClearPlan();
+		}
 	}
 }
 
@@ -771,6 +944,7 @@ void ModSynth::Connect(const char *src, const char *dst)
 void ModSynth::Disconnect(ModSynthUG *src, ModSynthUG *dst, int index)
 {
 	src->RemoveConnect(dst, index);
+	ClearPlan();
 }
 
 int ModSynth::Load(XmlSynthElem *parent)
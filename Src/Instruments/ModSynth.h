@@ -28,6 +28,17 @@ struct ModSynthUGType
 
 extern ModSynthUGType ugTypes[];
 
+/// @brief Modular synthesis instrument.
+/// @details Units are ticked in list order, and each unit sends
+/// its output to the connected inputs as it is produced.
+/// For block rendering, the unit list is compiled into a
+/// schedule: an array of units in list order, with the
+/// connections into each unit held in one contiguous array
+/// and the values sent during the block kept in per-unit
+/// buffers. Each unit then runs over the whole block in turn.
+/// This gives the same result as ticking each sample only when
+/// every connection runs forward in the list, so patches with
+/// feedback to an earlier unit are rendered one sample at a time.
 class ModSynth : public InstrumentVP
 {
 private:
@@ -48,6 +59,16 @@ private:
 	FrqValue frq;
 
 	InstrManager *im;
+
+	ModSynthUG **plan;        ///< units in execution order, excluding out
+	ModSynthPlanIn *planIn;   ///< input connections, grouped by unit
+	int *planInCount;         ///< number of input connections per unit
+	AmpValue *planVal;        ///< values sent during a block
+	bsUint8 *planSet;         ///< flags for values sent
+	int numPlan;              ///< number of units in the plan
+	int planState;            ///< 0 = not compiled, 1 = compiled, -1 = per sample only
+
+	int PlanIndex(ModSynthUG *ug, int from);
 public:
 	ModSynth();
 	~ModSynth();
@@ -76,11 +97,14 @@ public:
 	void Connect(ModSynthUG *src, ModSynthUG *dst, int index = 0, int when = 3);
 	void Disconnect(ModSynthUG *src, ModSynthUG *dst, int index = -1);
 	void DumpConnect(void (*fn)(const char *));
+	int Compile();
+	void ClearPlan();
 
 	void Start(SeqEvent *evt);
 	void Param(SeqEvent *evt);
 	void Stop();
 	void Tick();
+	int TickBlock(int frames);
 	int IsFinished();
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
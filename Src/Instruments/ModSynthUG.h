@@ -49,6 +49,18 @@ public:
 
 class ModSynthUG;
 
+/// ModSynthPlanIn is one connection in a compiled ModSynth.
+/// The source unit stores the values it sends during a block,
+/// along with a flag for each sample where it sent a value.
+/// The destination applies those values to the input in
+/// sample order before each of its own ticks.
+struct ModSynthPlanIn
+{
+	AmpValue *val;
+	bsUint8 *set;
+	short index;
+};
+
 /// ModSynthConn defines a connection between a ug output and input.
 class ModSynthConn : public SynthList<ModSynthConn>
 {
@@ -90,7 +102,21 @@ public:
 	virtual short GetNumInputs() = 0;
 	virtual void Start() = 0;
 	virtual void Stop() = 0;
+	/// Seed any random number generator in the unit.
+	/// Units without one ignore this.
+	/// @param s seed value
+	virtual void Seed(bsUint32 s) = 0;
 	virtual void Tick() = 0;
+	/// Produce a block of samples.
+	/// Before each sample, values sent by the source units are
+	/// applied to the inputs. Values this unit sends are stored
+	/// in val and set rather than sent to the connected units.
+	/// @param in compiled input connections
+	/// @param nin number of input connections
+	/// @param val buffer for values sent
+	/// @param set buffer for send flags
+	/// @param frames number of samples
+	virtual void TickBlock(ModSynthPlanIn *in, int nin, AmpValue *val, bsUint8 *set, int frames) = 0;
 	virtual void Send(float value, short mask) = 0;
 	virtual int IsFinished() = 0;
 	virtual AmpValue GetOutput() = 0;
@@ -127,6 +153,9 @@ public:
 	bsString name;
 	ModSynthConn chead;
 	ModSynthConn ctail;
+	AmpValue *blkVal;
+	bsUint8 *blkSet;
+	int blkPos;
 
 	static ModSynthUG *Construct()
 	{
@@ -140,6 +169,9 @@ public:
 		anyChange = 0;
 		out = 0;
 		id = -1;
+		blkVal = 0;
+		blkSet = 0;
+		blkPos = 0;
 		chead.Insert(&ctail);
 	}
 
@@ -314,6 +346,20 @@ public:
 		}
 	}
 
+	/// Send a generated value to connected units.
+	/// During TickBlock the value is stored for
+	/// the compiled connections instead.
+	inline void SendGen(AmpValue value)
+	{
+		if (blkVal)
+		{
+			blkVal[blkPos] = value;
+			blkSet[blkPos] = 1;
+		}
+		else
+			Send(value, UGP_GEN);
+	}
+
 	virtual void Start()
 	{
 		anyChange = 0;
@@ -321,11 +367,34 @@ public:
 
 	virtual void Stop() { }
 
+	virtual void Seed(bsUint32 s) { }
+
 	virtual void Tick()
 	{
 		// derived class must initialize gen from any changed inputs
 		out = gen.Sample(AmpValue(inputs[0]));
-		Send(out, UGP_GEN);
+		SendGen(out);
+	}
+
+	// The derived class SetInput and Tick are called directly
+	// so that they can be inlined into the sample loop.
+	virtual void TickBlock(ModSynthPlanIn *in, int nin, AmpValue *val, bsUint8 *set, int frames)
+	{
+		DT *pthis = static_cast<DT*>(this);
+		memset(set, 0, frames);
+		blkVal = val;
+		blkSet = set;
+		for (blkPos = 0; blkPos < frames; blkPos++)
+		{
+			for (int n = 0; n < nin; n++)
+			{
+				if (in[n].set[blkPos])
+					pthis->DT::SetInput(in[n].index, in[n].val[blkPos]);
+			}
+			pthis->DT::Tick();
+		}
+		blkVal = 0;
+		blkSet = 0;
 	}
 
 	virtual void InitDefault()
@@ -42,7 +42,7 @@ void PitchBend::Copy(PitchBend *pb)
 
 void PitchBend::CalcMul()
 {
-	count = (long) (rate[state] * synthParams.sampleRate);
+	count = (long) (rate[state] * ctx->sampleRate);
 	beg = frq;
 	end = frq;
 	FrqValue a1 = amnt[state] * 100.0;   // convert semitones to cents
@@ -50,9 +50,9 @@ void PitchBend::CalcMul()
 	if (count > 0 && (a1 != a2))
 	{
 		if (a1 != 0)
-			beg *= synthParams.GetCentsMult((int)a1); // pow(2.0, a1 / 1200.0);
+			beg *= ctx->GetCentsMult((int)a1); // pow(2.0, a1 / 1200.0);
 		if (a2 != 0)
-			end *= synthParams.GetCentsMult((int)a2); // pow(2.0, a2 / 1200.0);
+			end *= ctx->GetCentsMult((int)a2); // pow(2.0, a2 / 1200.0);
 		mul = pow((double)end / (double)beg, 1.0 / (double)count);
 	}
 	else
@@ -191,8 +191,8 @@ void PitchBendWT::Reset(float initPhs)
 	{
 		if (mode) // absolute
 		{
-			count = (bsInt32) (durSec * synthParams.sampleRate);
-			delay = (bsInt32) (dlySec * synthParams.sampleRate);
+			count = (bsInt32) (durSec * ctx->sampleRate);
+			delay = (bsInt32) (dlySec * ctx->sampleRate);
 		}
 		else // percent of duration
 		{
@@ -203,34 +203,34 @@ void PitchBendWT::Reset(float initPhs)
 	if (sigFrq > 0.0)
 	{
 		//FrqValue f1 = sigFrq * FrqValue(pow(2.0, depth / 12.0));
-		FrqValue f1 = sigFrq * synthParams.GetCentsMult((int)(depth * 100.0));
+		FrqValue f1 = sigFrq * ctx->GetCentsMult((int)(depth * 100.0));
 		ampLvl = AmpValue(fabs(f1 - sigFrq));
 	}
 	else
 		ampLvl = depth;
 
-	wave = wtSet.GetWavetable(wtSet.FindWavetable(wtID));
+	wave = ctx->wt->GetWavetable(ctx->wt->FindWavetable(wtID));
 	if (wave)
 	{
 		if (count > 0)
-			indexIncr = synthParams.ftableLength / count;
+			indexIncr = ctx->ftableLength / count;
 		else
 			indexIncr = 1;
 		if (initPhs >= 0)
-			index = synthParams.radTI * initPhs;
+			index = ctx->radTI * initPhs;
 		lastVal = ampLvl * wave[(int)(index+0.5)];
 	}
 	else
 	{
 		lastVal = 0;
-		index = synthParams.ftableLength;
+		index = ctx->ftableLength;
 		indexIncr = 0;
 	}
 }
 
 AmpValue PitchBendWT::Gen()
 {
-	if (index >= synthParams.ftableLength)
+	if (index >= ctx->ftableLength)
 		return lastVal;
 	if (delay > 0)
 		delay--;
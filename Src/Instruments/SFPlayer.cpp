@@ -190,10 +190,10 @@ void SFGen::CalcPhsIncr(int pit, SBZone *zone)
 	FrqValue adjKey = FrqValue(pit + zone->coarseTune - zone->keyNum);
 	FrqValue adjCents = zone->fineTune * 0.01;
 	phsPC = FrqValue(zone->scaleTune) * (adjKey + adjCents) - zone->cents;
-	if (zone->rate != synthParams.isampleRate)
+	if (zone->rate != osc.GetContext()->isampleRate)
 	{
 		double wsrCents = 1200.0 * SoundBank::log2((double)zone->rate/440.0);
-		double srCents = 1200.0 * SoundBank::log2((double)synthParams.sampleRate/440.0);
+		double srCents = 1200.0 * SoundBank::log2((double)osc.GetContext()->sampleRate/440.0);
 		phsPC += (float)(wsrCents - srCents);
 	}
 }
@@ -279,7 +279,7 @@ void SFPlayerInstr::Param(SeqEvent *evt)
 			xfdList = BuildZoneList(sfpit, (int) (vol * 127.0));
 			
 			// begin 50ms cross-fade to new sample.
-			xfade = (bsInt32) synthParams.sampleRate / 10;
+			xfade = (bsInt32) im->GetContext()->sampleRate / 10;
 			fadeEG.InitSegTick(xfade, 0.0, 1.0);
 		}
 
@@ -103,10 +103,18 @@ void SubSynth::Copy(SubSynth *tp)
 	nzMix  = 1.0 - sigMix;
 	fltGain = tp->fltGain;
 	fltRes = tp->fltRes;
+	int oldType = fltType;
 	fltType = tp->fltType;
 	envSig.Copy(&tp->envSig);
 	envFlt.Copy(&tp->envFlt);
-	CreateFilter();
+	// a recycled instance keeps its filter object when the type matches
+	if (filt == NULL || oldType != fltType)
+		CreateFilter();
+	else
+	{
+		filt->Init(&envFlt, fltGain, fltRes);
+		filt->SetCalcRate(tp->coefRate);
+	}
 	lfoGen.Copy(&tp->lfoGen);
 	nzOn = nzMix > 0;
 	pbOn = tp->pbOn;
@@ -162,7 +170,8 @@ void SubSynth::Start(SeqEvent *evt)
 		pbWT.SetDurationS(evt->duration);
 		pbWT.Reset(0);
 	}
-	pwFrq = (frq * synthParams.GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+	pwFrq = (frq * im->GetContext()->GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+	nz.Seed((bsUint32) evt->evid);
 }
 
 void SubSynth::Param(SeqEvent *evt)
@@ -171,7 +180,7 @@ void SubSynth::Param(SeqEvent *evt)
 	{
 		ControlEvent *cevt = (ControlEvent *)evt;
 		if ((cevt->mmsg & MIDI_EVTMSK) == MIDI_PWCHG)
-			pwFrq = (frq * synthParams.GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+			pwFrq = (frq * im->GetContext()->GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
 		return; // TODO: process controller changes
 	}
 	SetParams((VarParamEvent *)evt);
@@ -432,7 +441,9 @@ void SubSynth::Stop()
 	envFlt.Release();
 }
 
-void SubSynth::Tick()
+// Oscillator, noise mix and filter for one sample,
+// before the amplitude envelope is applied.
+inline AmpValue SubSynth::Process(AmpValue nzVal)
 {
 	FrqValue phs = pwFrq;
 	if (lfoGen.On())
@@ -441,11 +452,33 @@ void SubSynth::Tick()
 		phs += pbGen.Gen();
 	if (pbWT.On())
 		phs += pbWT.Gen();
-	osc.PhaseModWT(phs * synthParams.frqTI);
+	osc.PhaseModWT(phs * im->GetContext()->frqTI);
 	AmpValue sigVal = osc.Gen();
 	if (nzOn)
-		sigVal = (sigVal * sigMix) + (nz.Gen() * nzMix);
-	im->Output(chnl, filt->Sample(sigVal) * envSig.Gen() * vol);
+		sigVal = (sigVal * sigMix) + (nzVal * nzMix);
+	return filt->Sample(sigVal);
+}
+
+void SubSynth::Tick()
+{
+	AmpValue out = Process(nzOn ? nz.Gen() : 0);
+	im->Output(chnl, out * envSig.Gen() * vol);
+}
+
+// The noise and envelope for the whole block are generated
+// first, then mixed with the oscillator one sample at a time.
+int SubSynth::TickBlock(int frames)
+{
+	AmpValue out[MAX_BLKLEN];
+	AmpValue nzv[MAX_BLKLEN];
+	AmpValue eg[MAX_BLKLEN];
+	if (nzOn)
+		nz.GenBlock(nzv, frames);
+	envSig.GenBlock(eg, frames);
+	for (int n = 0; n < frames; n++)
+		out[n] = Process(nzOn ? nzv[n] : 0) * eg[n] * vol;
+	im->OutputBlock(chnl, out, frames);
+	return 1;
 }
 
 int  SubSynth::IsFinished()
@@ -458,6 +491,14 @@ void SubSynth::Destroy()
 	delete this;
 }
 
+int SubSynth::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((SubSynth *)tmplt);
+	return 1;
+}
+
 int SubSynth::Load(XmlSynthElem *parent)
 {
 	float dvals[7];
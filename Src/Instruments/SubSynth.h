@@ -52,7 +52,7 @@ public:
 	}
 	virtual void SetCalcRate(float f)
 	{
-		coefRate = (bsInt32) (f * 0.001 * synthParams.sampleRate);
+		coefRate = (bsInt32) (f * 0.001 * SynthContext::Current()->sampleRate);
 	}
 };
 
@@ -264,6 +264,8 @@ private:
 	int pbOn;
 	InstrManager *im;
 
+	AmpValue Process(AmpValue nzVal);
+
 public:
 	SubSynth();
 	SubSynth(SubSynth *tp);
@@ -279,8 +281,10 @@ public:
 	virtual void Param(SeqEvent *evt);
 	virtual void Stop();
 	virtual void Tick();
+	virtual int  TickBlock(int frames);
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle(Opaque tmplt);
 
 	int Load(XmlSynthElem *parent);
 	int Save(XmlSynthElem *parent);
@@ -67,7 +67,7 @@ void ToneBase::Start(SeqEvent *evt)
 		pbWT.SetDurationS(evt->duration);
 		pbWT.Reset(0);
 	}
-	pwFrq = (frq * synthParams.GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+	pwFrq = (frq * im->GetContext()->GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
 }
 
 void ToneBase::Param(SeqEvent *evt)
@@ -76,7 +76,7 @@ void ToneBase::Param(SeqEvent *evt)
 	{
 		ControlEvent *cevt = (ControlEvent *)evt;
 		if ((cevt->mmsg & MIDI_EVTMSK) == MIDI_PWCHG)
-			pwFrq = (frq * synthParams.GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
+			pwFrq = (frq * im->GetContext()->GetCentsMult((int)im->GetPitchbendC(chnl))) - frq;
 	}
 	else if (evt->type == SEQEVT_PARAM)
 	{
@@ -107,7 +107,7 @@ void ToneBase::Tick()
 		phs += pbGen.Gen();
 	if (pbWT.On())
 		phs += pbWT.Gen();
-	osc->PhaseModWT(phs * synthParams.frqTI);
+	osc->PhaseModWT(phs * im->GetContext()->frqTI);
 	im->Output(chnl, vol * env.Gen() * osc->Gen());
 }
 
@@ -121,6 +121,14 @@ void ToneBase::Destroy()
 	delete this;
 }
 
+int ToneBase::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((ToneBase *)tmplt);
+	return 1;
+}
+
 int ToneBase::LoadOscil(XmlSynthElem *elem)
 {
 	double dval;
@@ -517,6 +525,14 @@ void ToneFM::Copy(ToneFM *tp)
 	osc2->SetModMultiple(osc1->GetModMultiple());
 }
 
+int ToneFM::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((ToneFM *)tmplt);
+	return 1;
+}
+
 int ToneFM::LoadOscil(XmlSynthElem *elem)
 {
 	int err = ToneBase::LoadOscil(elem);
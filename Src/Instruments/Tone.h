@@ -42,6 +42,7 @@ public:
 	virtual void Tick();
 	virtual int  IsFinished();
 	virtual void Destroy();
+	virtual int  Recycle(Opaque tmplt);
 
 	virtual int Load(XmlSynthElem *parent);
 	virtual int Save(XmlSynthElem *parent);
@@ -83,6 +84,7 @@ public:
 	ToneFM(ToneFM *tp);
 	virtual ~ToneFM();
 	virtual void Copy(ToneFM *tp);
+	virtual int  Recycle(Opaque tmplt);
 	virtual int LoadOscil(XmlSynthElem *elem);
 	virtual int SaveOscil(XmlSynthElem *elem);
 	virtual int SetParam(bsInt16 id, float val);
@@ -48,7 +48,7 @@ public:
 		if (anyChange)
 		{
 			out = inputs[UGVAL_INP];
-			Send(out, UGP_GEN);
+			SendGen(out);
 			anyChange = 0;
 		}
 	}
@@ -261,7 +261,7 @@ public:
 		{
 			anyChange = 0;
 			CalcValue();
-			Send(out, UGP_GEN);
+			SendGen(out);
 		}
 	}
 
@@ -332,7 +332,7 @@ public:
 			out = (inputs[0] / 360.0f) * twoPI;
 			break;
 		case UGOP_F2R: // (v1 / SR) * twoPI
-			out = (inputs[0] / synthParams.sampleRate) * twoPI;
+			out = (inputs[0] / gen.GetContext()->sampleRate) * twoPI;
 			break;
 		case UGOP_HYP: // sqrt(v1*v1 + v2*v2)
 			out = sqrt((inputs[0]*inputs[0]) + (inputs[1]*inputs[1]));
@@ -431,7 +431,7 @@ public:
 		if (anyChange)
 		{
 			CalcValue();
-			Send(out, UGP_GEN);
+			SendGen(out);
 		}
 	}
 
@@ -473,7 +473,7 @@ public:
 
 	UGTable()
 	{
-		table = wtSet.wavSin;
+		table = gen.GetContext()->wt->wavSin;
 	}
 
 	void Start()
@@ -494,19 +494,19 @@ public:
 		{
 			CalcValue();
 			anyChange = 0;
-			Send(out, UGP_GEN);
+			SendGen(out);
 		}
 	}
 
 	void CalcValue()
 	{
 		if (anyChange & 2) // table id
-			table = wtSet.GetWavetable(wtSet.FindWavetable((bsInt32) inputs[UGTBL_WVT]));
+			table = gen.GetContext()->wt->GetWavetable(gen.GetContext()->wt->FindWavetable((bsInt32) inputs[UGTBL_WVT]));
 		float index = inputs[UGTBL_NDX];
-		while (index > synthParams.ftableLength)
-			index -= synthParams.ftableLength;
+		while (index > gen.GetContext()->ftableLength)
+			index -= gen.GetContext()->ftableLength;
 		while (index < 0)
-			index += synthParams.ftableLength;
+			index += gen.GetContext()->ftableLength;
 		if ((int)inputs[UGTBL_INT] != 0) // interpolate
 		{
 			float ipart = floor(index);
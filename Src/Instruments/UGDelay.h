@@ -63,7 +63,7 @@ public:
 		DT *pdt = (DT*)this;
 		pdt->out = pdt->gen.Sample(pdt->inputs[UGDLY_INP] * pdt->inputs[UGDLY_VOL]);
 		pdt->inputs[UGDLY_INP] = 0.0;
-		pdt->Send(pdt->out, UGP_GEN);
+		pdt->SendGen(pdt->out);
 		count -= stopped;
 	}
 };
@@ -99,7 +99,7 @@ public:
 	void Start()
 	{
 		stopped = 0;
-		count = (bsInt32) (inputs[UGDLY_DLY] * synthParams.sampleRate);
+		count = (bsInt32) (inputs[UGDLY_DLY] * gen.GetContext()->sampleRate);
 		inputs[UGDLY_INP] = 0.0;
 		gen.InitDL(inputs[UGDLY_DLY], inputs[UGDLY_DEC]);
 		out = 0;
@@ -137,7 +137,7 @@ public:
 	void Start()
 	{
 		stopped = 0;
-		count = (bsInt32) (inputs[UGDLY_DLY] * synthParams.sampleRate);
+		count = (bsInt32) (inputs[UGDLY_DLY] * gen.GetContext()->sampleRate);
 		inputs[UGDLY_INP] = 0.0f;
 		gen.InitDLR(inputs[UGDLY_DLY], inputs[UGDLY_DEC], 0.001, inputs[UGDLY_VOL]);
 		out = 0;
@@ -185,7 +185,7 @@ public:
 		anyChange |= (1<<UGDLY_VRT); // force setting variable delay on first tick
 		out = 0;
 		stopped = 0;
-		count = (bsInt32) (inputs[UGDLY_DLY] * synthParams.sampleRate);
+		count = (bsInt32) (inputs[UGDLY_DLY] * gen.GetContext()->sampleRate);
 	}
 
 	void Tick()
@@ -202,7 +202,7 @@ public:
 		}
 		out = gen.Sample(inputs[UGDLY_INP] * inputs[UGDLY_VOL]);
 		inputs[UGDLY_INP] = 0.0f;
-		Send(out, UGP_GEN);
+		SendGen(out);
 		count -= stopped;
 	}
 };
@@ -260,7 +260,7 @@ public:
 		gen.InitReverb(inputs[UGRVB_VOL], inputs[UGRVB_RVT]);
 		anyChange = 0;
 		out = 0;
-		count = (bsInt32) (inputs[UGRVB_RVT] * synthParams.sampleRate);
+		count = (bsInt32) (inputs[UGRVB_RVT] * gen.GetContext()->sampleRate);
 		stopped = 0;
 	}
 
@@ -278,7 +278,7 @@ public:
 	{
 		out = gen.Sample(inputs[UGRVB_INP]);
 		inputs[UGRVB_INP] = 0.0f;
-		Send(out, UGP_GEN);
+		SendGen(out);
 		count -= stopped;
 	}
 };
@@ -337,7 +337,7 @@ public:
 						inputs[UGFLNG_SWP]);
 		anyChange = 0;
 		out = 0;
-		count = (bsInt32) (inputs[UGFLNG_CTR] * synthParams.sampleRate);
+		count = (bsInt32) (inputs[UGFLNG_CTR] * gen.GetContext()->sampleRate);
 		stopped = 0;
 	}
 
@@ -364,7 +364,7 @@ public:
 	{
 		out = gen.Sample(inputs[UGFLNG_INP]);
 		inputs[UGFLNG_INP] = 0.0f;
-		Send(out, UGP_GEN);
+		SendGen(out);
 		count -= stopped;
 	}
 };
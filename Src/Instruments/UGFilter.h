@@ -78,7 +78,7 @@ public:
 		}
 		pdt->out = pdt->gen.Sample(pdt->inputs[0]);
 		pdt->inputs[0] = 0;
-		pdt->Send(pdt->out, UGP_GEN);
+		pdt->SendGen(pdt->out);
 	}
 };
 
@@ -299,7 +299,7 @@ public:
 		}
 		out = gen.Sample(inputs[0]);
 		inputs[0] = 0;
-		Send(out, UGP_GEN);
+		SendGen(out);
 	}
 };
 //@}
@@ -65,7 +65,7 @@ public:
 			gen.Reset(-1);
 		}
 		if (anyChange & ((1<<UGOSC_MUL)|(1<<UGOSC_MOD)))
-			gen.PhaseModWT(synthParams.frqTI * inputs[UGOSC_MOD] * inputs[UGOSC_MUL]);
+			gen.PhaseModWT(gen.GetContext()->frqTI * inputs[UGOSC_MOD] * inputs[UGOSC_MUL]);
 		anyChange = 0;
 		base::Tick();
 	}
@@ -113,7 +113,7 @@ public:
 			gen.Reset(-1);
 		}
 		if (anyChange & ((1<<UGOSC_MUL)|(1<<UGOSC_MOD)))
-			gen.PhaseModWT(synthParams.frqTI * inputs[UGOSC_MOD] * inputs[UGOSC_MUL]);
+			gen.PhaseModWT(gen.GetContext()->frqTI * inputs[UGOSC_MOD] * inputs[UGOSC_MUL]);
 		anyChange = 0;
 		base::Tick();
 	}
@@ -252,7 +252,7 @@ public:
 			gen.Modulate(inputs[UGOSC_MOD]);
 		anyChange = 0;
 		out = gen.Sample(inputs[0]);
-		Send(out, UGP_GEN);
+		SendGen(out);
 	}
 };
 
@@ -286,15 +286,20 @@ public:
 
 	void Start()
 	{
-		gen.InitH(inputs[UGNZ_RTE]*synthParams.sampleRate);
+		gen.InitH(inputs[UGNZ_RTE]*gen.GetContext()->sampleRate);
 		anyChange = 0;
 	}
 
+	void Seed(bsUint32 s)
+	{
+		gen.Seed(s);
+	}
+
 	void Tick()
 	{
 		if (anyChange & (1<<UGNZ_AMP))
 		{
-			gen.InitH(inputs[UGNZ_AMP]*synthParams.sampleRate);
+			gen.InitH(inputs[UGNZ_AMP]*gen.GetContext()->sampleRate);
 			anyChange = 0;
 		}
 		base::Tick();
@@ -328,15 +333,20 @@ public:
 
 	void Start()
 	{
-		gen.InitH(inputs[UGNZ_RTE]*synthParams.sampleRate);
+		gen.InitH(inputs[UGNZ_RTE]*gen.GetContext()->sampleRate);
 		anyChange = 0;
 	}
 
+	void Seed(bsUint32 s)
+	{
+		gen.Seed(s);
+	}
+
 	void Tick()
 	{
 		if (anyChange & (1<<UGNZ_AMP))
 		{
-			gen.InitH(inputs[UGNZ_AMP]*synthParams.sampleRate);
+			gen.InitH(inputs[UGNZ_AMP]*gen.GetContext()->sampleRate);
 			anyChange = 0;
 		}
 		base::Tick();
@@ -153,14 +153,14 @@ void WFSynth::Start(SeqEvent *evt)
 		{
 			samples = wfp->GetSampleBuffer();
 			sampleTotal = wfp->GetInputLength();
-			sampleIncr = (PhsAccum) wfp->GetSampleRate() / (PhsAccum) synthParams.sampleRate;
+			sampleIncr = (PhsAccum) wfp->GetSampleRate() / (PhsAccum) im->GetContext()->sampleRate;
 			break;
 		}
 		wfp++;
 	}
 	
 	if (sampleTotal > 0)
-		sampleRel = sampleTotal - PhsAccum(eg.GetRelRt() * synthParams.sampleRate);
+		sampleRel = sampleTotal - PhsAccum(eg.GetRelRt() * im->GetContext()->sampleRate);
 
 	eg.Reset(0);
 }
@@ -278,6 +278,14 @@ void WFSynth::Destroy()
 	delete this;
 }
 
+int WFSynth::Recycle(Opaque tmplt)
+{
+	if (tmplt == 0)
+		return 0;
+	Copy((WFSynth *)tmplt);
+	return 1;
+}
+
 int WFSynth::Load(XmlSynthElem *parent)
 {
 	float atk;
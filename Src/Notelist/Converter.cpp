@@ -39,6 +39,9 @@ nlConverter::nlConverter()
 	symbList = NULL;
 	mixInstr = -1;
 	canceled = 0;
+	memset(symbHash, 0, sizeof(symbHash));
+	memset(instrHash, 0, sizeof(instrHash));
+	memset(paramHash, 0, sizeof(paramHash));
 }
 
 nlConverter::~nlConverter()
@@ -51,6 +54,7 @@ nlConverter::~nlConverter()
 		symbList = sym->next;
 		delete sym;
 	}
+	ClearNames();
 }
 
 int nlConverter::Convert(const char *filename, nlLexIn *in)
@@ -81,6 +85,8 @@ int nlConverter::Generate()
 	if (seq == NULL || mgr == NULL)
 		return -1;
 
+	// instruments may have changed since the last run
+	ClearNames();
 	mixInstr = FindInstrNum("[mixer]");
 	gen.SetConverter(this);
 	return gen.Run();
@@ -227,7 +233,7 @@ void nlConverter::MakeEvent(int evtType, double start, double dur)
 			evt->SetParam(P_USER+pn, (float) val);
 	}
 
-	seq->AddEvent(evt);
+	AddEvent(evt);
 
 	if (curVoice->doublex != 0)
 	{
@@ -244,7 +250,7 @@ void nlConverter::MakeEvent(int evtType, double start, double dur)
 				evt2->SetParam(P_FREQ, pit * pow(2.0, (double)curVoice->doublex/12.0));
 			else
 				evt->SetParam(P_PITCH, (long) pit + curVoice->doublex);
-			seq->AddEvent(evt2);
+			AddEvent(evt2);
 		}
 	}
 }
@@ -276,7 +282,7 @@ void nlConverter::MixerEvent(int fn, double *params)
 			evt->SetParam(P_MIX_WT, (float) params[5]);
 		}
 	}
-	seq->AddEvent(evt);
+	AddEvent(evt);
 }
 
 void nlConverter::MidiEvent(short mmsg, short val1, short val2)
@@ -292,7 +298,7 @@ void nlConverter::MidiEvent(short mmsg, short val1, short val2)
 	evt->SetParam(P_MMSG, mmsg);
 	evt->SetParam(P_CTRL, val1);
 	evt->SetParam(P_CVAL, val2);
-	seq->AddEvent(evt);
+	AddEvent(evt);
 }
 
 void nlConverter::TrackOp(int op, int trk, int cnt)
@@ -307,27 +313,76 @@ void nlConverter::TrackOp(int op, int trk, int cnt)
 	evt->SetParam(P_TRACK, curVoice->track);
 	evt->SetParam(P_TRKNO, trk);
 	evt->SetParam(P_LOOP, cnt);
-	seq->AddEvent(evt);
+	AddEvent(evt);
 }
 
+// Instrument and parameter names are looked up through
+// the instrument manager the first time they are seen.
+// After that the result comes from the hash table.
 int nlConverter::FindInstrNum(const char *name)
 {
 	if (name == NULL || *name == 0)
 		return -1;
 
+	nlNameCache **head = &instrHash[HashToken(name) & (NL_HASHSIZE-1)];
+	nlNameCache *nc;
+	for (nc = *head; nc != NULL; nc = nc->next)
+	{
+		if (CompareToken(nc->name, name) == 0)
+			return nc->inum;
+	}
+
+	int inum = -1;
 	InstrConfig *ip;
 	if ((ip = mgr->FindInstr(name)) != NULL)
-		return ip->inum;
+		inum = ip->inum;
 
-	return -1;
+	nc = new nlNameCache(name, inum, -1);
+	nc->next = *head;
+	*head = nc;
+	return inum;
 }
 
 int nlConverter::GetParamID(int inum, const char *name)
 {
+	if (name == NULL)
+		return -1;
+
+	nlNameCache **head = &paramHash[(HashToken(name) + inum) & (NL_HASHSIZE-1)];
+	nlNameCache *nc;
+	for (nc = *head; nc != NULL; nc = nc->next)
+	{
+		if (nc->inum == inum && CompareToken(nc->name, name) == 0)
+			return nc->id;
+	}
+
+	int id = -1;
 	InstrConfig *ip;
 	if ((ip = mgr->FindInstr(inum)) != NULL)
-		return (int) ip->GetParamID(name);
-	return -1;
+		id = (int) ip->GetParamID(name);
+
+	nc = new nlNameCache(name, inum, id);
+	nc->next = *head;
+	*head = nc;
+	return id;
+}
+
+void nlConverter::ClearNames()
+{
+	for (int n = 0; n < NL_HASHSIZE; n++)
+	{
+		nlNameCache *nc;
+		while ((nc = instrHash[n]) != NULL)
+		{
+			instrHash[n] = nc->next;
+			delete nc;
+		}
+		while ((nc = paramHash[n]) != NULL)
+		{
+			paramHash[n] = nc->next;
+			delete nc;
+		}
+	}
 }
 
 void nlConverter::InitParamMap(int inum)
@@ -379,12 +434,12 @@ void nlConverter::SetParamMap(int inum, int pn, int mn, double scl)
 
 nlSymbol *nlConverter::Lookup(const char *name)
 {
-	nlSymbol *sym = symbList;
+	nlSymbol *sym = symbHash[HashToken(name) & (NL_HASHSIZE-1)];
 	while (sym != NULL)
 	{
 		if (CompareToken(sym->name, name) == 0)
 			return sym;
-		sym = sym->next;
+		sym = sym->hnext;
 	}
 	return NULL;
 }
@@ -394,6 +449,9 @@ nlSymbol *nlConverter::AddSymbol(const char *name)
 	nlSymbol *sym = new nlSymbol(name);
 	sym->next = symbList;
 	symbList = sym;
+	nlSymbol **head = &symbHash[HashToken(name) & (NL_HASHSIZE-1)];
+	sym->hnext = *head;
+	*head = sym;
 	return sym;
 }
 
@@ -422,6 +480,20 @@ int CompareToken(const char *s1, const char *s2)
 	return *s2 - *s1;
 }
 
+// Hash a token, ignoring case the same way as CompareToken.
+unsigned int HashToken(const char *s)
+{
+	unsigned int h = 2166136261U;
+	int c;
+	while ((c = ((int)*s++) & 0xFF) != 0)
+	{
+		if (c >= 'a' && c <= 'z')
+			c = 'A' + c - 'a';
+		h = (h ^ (unsigned int) c) * 16777619U;
+	}
+	return h;
+}
+
 char *StrMakeCopy(const char *s)
 {
 	char *snew = NULL;
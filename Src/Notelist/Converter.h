@@ -201,6 +201,35 @@ public:
 
 };
 
+/// Size of the converter hash tables. Must be a power of 2.
+#define NL_HASHSIZE 256
+
+/// @brief A remembered name lookup.
+/// @details The converter keeps the result of instrument
+/// name and parameter name lookups so that a name is only
+/// resolved through the instrument manager once per Generate().
+class nlNameCache
+{
+public:
+	char *name;
+	int inum;
+	int id;
+	nlNameCache *next;
+
+	nlNameCache(const char *n, int i, int v)
+	{
+		name = StrMakeCopy(n);
+		inum = i;
+		id = v;
+		next = NULL;
+	}
+
+	~nlNameCache()
+	{
+		delete[] name;
+	}
+};
+
 /// @brief Notelist convert class. 
 /// @details This is the base class that provides an interface to the script
 /// conversion modules and implements output to the BasicSynth sequencer. 
@@ -225,6 +254,9 @@ protected:
 	nlScriptEngine *eng;
 
 	nlSymbol *symbList;
+	nlSymbol *symbHash[NL_HASHSIZE];
+	nlNameCache *instrHash[NL_HASHSIZE];
+	nlNameCache *paramHash[NL_HASHSIZE];
 	nlGenerate gen;
 	nlParser parser;
 
@@ -234,6 +266,7 @@ protected:
 	int canceled;
 
 	void MakeEvent(int evtType, double start, double dur);
+	void ClearNames();
 
 	friend class nlGenerate;
 	friend class nlParser;
@@ -373,6 +406,13 @@ public:
 	virtual void RestartNote(double start, double dur);
 	virtual void ContinueNote(double start);
 	virtual void Write(char *txt);
+	/// Output a generated event. By default the event
+	/// is added to the sequencer. A derived class can
+	/// override this to keep the events.
+	virtual void AddEvent(SeqEvent *evt)
+	{
+		seq->AddEvent(evt);
+	}
 	virtual void MixerEvent(int fn, double *params);
 	virtual void MidiEvent(short mmsg, short ccnum, short ccval);
 	virtual void TrackOp(int op, int trk, int cnt);
@@ -1463,7 +1463,8 @@ nlScriptNode *nlPlayNode::Exec()
 		return NULL;
 
 	nlScriptNode *ret = next->Exec();
-	nlSequence *seq = genPtr->FindSequence(next);
+	if (seq == NULL || !seq->MatchID(next))
+		seq = genPtr->FindSequence(next);
 	if (seq != NULL)
 		seq->Play();
 	return ret;
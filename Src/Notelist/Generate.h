@@ -150,18 +150,21 @@ public:
 /// A symbol consists of a name and a value.
 /// The symbol can be an associative array with
 /// a list of values. The Index function selects
-/// or creates the value.
+/// or creates the value. Symbols are kept on the
+/// converter's list (next) and in its hash table (hnext).
 class nlSymbol : public nlVarValue
 {
 public:
 	char *name;
 	nlSymbol *next;
+	nlSymbol *hnext;
 	nlNamedVal *arrayVal;
 
 	nlSymbol()
 	{
 		arrayVal = NULL;
 		next = NULL;
+		hnext = NULL;
 		name = NULL;
 	}
 
@@ -173,6 +176,7 @@ public:
 			name = NULL;
 		arrayVal = NULL;
 		next = NULL;
+		hnext = NULL;
 	}
 
 	nlVarValue *Index(nlVarValue *ndx);
@@ -283,6 +287,7 @@ public:
 	void Append(nlSequence **list);
 	nlScriptNode *AddNode(nlScriptNode *seq);
 	nlSequence *FindSequence(nlVarValue *find);
+	int MatchID(nlVarValue *find) { return id.Compare(find) == 0; }
 };
 
 /// A nlVoice object holds all pertinent information about a voice.
@@ -697,12 +702,17 @@ public:
 /// note list and plays its own note list, then pops the
 /// original notelist back. The push/pop is effected by
 /// calling Play on the sequence.
+/// The sequence found on the first Exec is kept and
+/// reused as long as the name evaluates the same.
 class nlPlayNode : public nlScriptNode
 {
+private:
+	nlSequence *seq;
 public:
 	nlPlayNode()
 	{
 		token = T_PLAY;
+		seq = NULL;
 	}
 	virtual nlScriptNode *Exec();
 };
@@ -143,6 +143,7 @@ class nlScriptNode;
 class nlVariable;
 
 extern int CompareToken(const char *s1, const char *s2);
+extern unsigned int HashToken(const char *s);
 extern char *StrMakeCopy(const char *);
 extern char *StrPaste(const char *s1, const char *s2);
 